@@ -1,4 +1,5 @@
 #include "../jsmn.h"
+#include "../jsmn_format.h"
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,57 +22,30 @@ static inline void *realloc_it(void *ptrmem, size_t size) {
 }
 
 /*
- * An example of reading JSON from stdin and printing its content to stdout.
- * The output looks like YAML, but I'm not sure if it's really compatible.
+ * An example of reading JSON from stdin and pretty-printing it to stdout.
+ * The output is produced by jsmn_pretty_print(), which copies strings and
+ * primitives straight from the input through a 64K output buffer.
  */
 
-static int dump(const char *js, jsmn_token_t *t, size_t count, int indent) {
-  int i, j, k;
-  jsmn_token_t *key;
-  if (count == 0) {
-    return 0;
-  }
-  if (t->type == JSMN_PRIMITIVE) {
-    printf("%.*s", t->end - t->start, js + t->start);
-    return 1;
-  } else if (t->type == JSMN_STRING) {
-    printf("'%.*s'", t->end - t->start, js + t->start);
-    return 1;
-  } else if (t->type == JSMN_OBJECT) {
-    printf("\n");
-    j = 0;
-    for (i = 0; i < t->size; i++) {
-      for (k = 0; k < indent; k++) {
-        printf("  ");
-      }
-      key = t + 1 + j;
-      j += dump(js, key, count - j, indent + 1);
-      if (key->size > 0) {
-        printf(": ");
-        j += dump(js, t + 1 + j, count - j, indent + 1);
-      }
-      printf("\n");
-    }
-    return j + 1;
-  } else if (t->type == JSMN_ARRAY) {
-    j = 0;
-    printf("\n");
-    for (i = 0; i < t->size; i++) {
-      for (k = 0; k < indent - 1; k++) {
-        printf("  ");
-      }
-      printf("   - ");
-      j += dump(js, t + 1 + j, count - j, indent + 1);
-      printf("\n");
-    }
-    return j + 1;
+static int write_stdout(void *arg, const char *buf, size_t len) {
+  return fwrite(buf, 1, len, (FILE *)arg) == len ? 0 : -1;
+}
+
+static int dump(jsmn_parser_t *p) {
+  static char out[65536];
+  jsmn_writer_t w;
+
+  jsmn_writer_init(&w, out, sizeof(out), write_stdout, stdout);
+  if (jsmn_pretty_print(p, 0, NULL, &w) < 0 ||
+      jsmn_writer_write(&w, "\n", 1) < 0 || jsmn_writer_flush(&w) < 0) {
+    fprintf(stderr, "write failed: %d\n", w.error);
+    return 4;
   }
   return 0;
 }
 
 int main() {
   int r;
-  int eof_expected = 0;
   char *js = NULL;
   size_t jslen = 0;
   char buf[BUFSIZ];
@@ -80,9 +54,6 @@ int main() {
   jsmn_token_t *tok;
   size_t tokcount = 2;
 
-  /* Prepare parser */
-  jsmn_init(&p);
-
   /* Allocate some tokens as a start */
   tok = malloc(sizeof(*tok) * tokcount);
   if (tok == NULL) {
@@ -93,42 +64,41 @@ int main() {
   for (;;) {
     /* Read another chunk */
     r = fread(buf, 1, sizeof(buf), stdin);
-    if (r < 0) {
-      fprintf(stderr, "fread(): %d, errno=%d\n", r, errno);
-      return 1;
-    }
     if (r == 0) {
-      if (eof_expected != 0) {
-        return 0;
-      } else {
-        fprintf(stderr, "fread(): unexpected EOF\n");
-        return 2;
+      if (ferror(stdin)) {
+        fprintf(stderr, "fread(): errno=%d\n", errno);
+        return 1;
       }
+      fprintf(stderr, "fread(): unexpected EOF\n");
+      return 2;
     }
 
     js = realloc_it(js, jslen + r + 1);
     if (js == NULL) {
       return 3;
     }
-    strncpy(js + jslen, buf, r);
+    memcpy(js + jslen, buf, r);
     jslen = jslen + r;
 
   again:
-    r = jsmn_parse(&p, js, jslen, tok, tokcount);
-    if (r < 0) {
-      if (r == JSMN_ERROR_NOMEM) {
-        tokcount = tokcount * 2;
-        tok = realloc_it(tok, sizeof(*tok) * tokcount);
-        if (tok == NULL) {
-          return 3;
-        }
-        goto again;
+    jsmn_init(&p, tok, tokcount);
+    r = jsmn_parse(&p, js, jslen);
+    if (r == JSMN_ERROR_NOMEM) {
+      tokcount = tokcount * 2;
+      tok = realloc_it(tok, sizeof(*tok) * tokcount);
+      if (tok == NULL) {
+        return 3;
       }
-    } else {
-      dump(js, tok, p.toknext, 0);
-      eof_expected = 1;
+      goto again;
+    } else if (r == JSMN_ERROR_PART) {
+      continue;
+    } else if (r < 0) {
+      fprintf(stderr, "jsmn_parse(): %d\n", r);
+      return 1;
     }
+    r = dump(&p);
+    free(tok);
+    free(js);
+    return r == 0 ? EXIT_SUCCESS : r;
   }
-
-  return EXIT_SUCCESS;
 }
@@ -25,11 +25,15 @@
 #include "jsmn.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 // *****************************************************************************
 // local types and definitions
 
+/* Most symbols (or keys) a table may hold, as a fraction of its slots */
+#define SYMTAB_LOAD(mask) (((mask) + 1) / 4 * 3)
+
 #define START_TO_STR(js, start) (&js[(start)])
 #define STR_TO_START(js, str) ((str)-js)
 
@@ -37,32 +41,59 @@
 // forward references to local functions
 
 /**
- * Reset the parser, free and clear all tokens.
+ * Hash the len bytes at name (32-bit FNV-1a).
  */
-static void reset_parser(jsmn_parser_t *parser);
+static unsigned int symtab_hash(const char *name, size_t len);
 
 /**
- * Allocates a fresh unused token from the token pool.
+ * Return the parser's child index table, building it if it is out of date,
+ * or NULL if there is no index or it is too small for the tokens.
  */
-static jsmn_token_t *jsmn_alloc_token(jsmn_parser_t *parser);
+static const int *child_table(jsmn_parser_t *parser);
 
-/**
- * Fills token type and boundaries.
- */
-static void jsmn_fill_token(jsmn_token_t *token, const jsmn_token_type_t type,
-                            const char *start, int length);
+// *****************************************************************************
+// parser variants
 
-/**
- * Fills next available token with JSON primitive.
- */
-static int jsmn_parse_primitive(jsmn_parser_t *parser, const char *js,
-                                const size_t len);
+/* jsmn_parse(): policies chosen by the JSMN_* build flags */
+#define JSMN_ENGINE_NAME jsmn_parse
+#ifdef JSMN_STRICT
+#define JSMN_ENGINE_STRICT 1
+#endif
+#ifdef JSMN_PARENT_LINKS
+#define JSMN_ENGINE_PARENT_LINKS 1
+#endif
+#ifdef JSMN_STATS
+#define JSMN_ENGINE_STATS 1
+#endif
+#include "jsmn_engine.h"
 
-/**
- * Fills next token with JSON string.
- */
-static int jsmn_parse_string(jsmn_parser_t *parser, const char *js,
-                             const size_t len);
+#define JSMN_ENGINE_NAME jsmn_parse_strict
+#define JSMN_ENGINE_STRICT 1
+#define JSMN_ENGINE_PARENT_LINKS 1
+#include "jsmn_engine.h"
+
+#define JSMN_ENGINE_NAME jsmn_parse_lenient
+#define JSMN_ENGINE_PARENT_LINKS 1
+#include "jsmn_engine.h"
+
+#define JSMN_ENGINE_NAME jsmn_parse_trusted
+#define JSMN_ENGINE_PARENT_LINKS 1
+#define JSMN_ENGINE_TRUSTED 1
+#include "jsmn_engine.h"
+
+#if JSMN_PADDING < 64
+#error "JSMN_PADDING must cover a 64-byte block read at the NUL"
+#endif
+#define JSMN_ENGINE_NAME jsmn_parse_padded
+#define JSMN_ENGINE_PARENT_LINKS 1
+#define JSMN_ENGINE_PADDED 1
+#include "jsmn_engine.h"
+
+#define JSMN_ENGINE_NAME jsmn_parse_table
+#define JSMN_ENGINE_STRICT 1
+#define JSMN_ENGINE_PARENT_LINKS 1
+#define JSMN_ENGINE_TABLE 1
+#include "jsmn_engine.h"
 
 // *****************************************************************************
 // public functions
@@ -75,206 +106,160 @@ void jsmn_init(jsmn_parser_t *parser, jsmn_token_t *tokens,
                unsigned int num_tokens) {
     parser->tokens = tokens;
     parser->num_tokens = num_tokens;
+    jsmn_set_limits(parser, NULL);
+    jsmn_stats_reset(parser);
+    parser->symtab = NULL;
+    parser->children = NULL;
+    parser->keyset = NULL;
 }
 
-/**
- * Parse JSON string and fill tokens.
- */
-int jsmn_parse(jsmn_parser_t *parser, const char *js, const size_t len) {
-    int r;
-    int i;
-    int count;
-    jsmn_token_t *token;
-
-    reset_parser(parser);
-    count = parser->token_count;
-
-    for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
-        char c;
-        jsmn_token_type_t type;
-
-        c = js[parser->pos];
-        switch (c) {
-        case '{':
-        case '[':
-            count++;
-            if (parser->tokens == NULL) {
-                break;
-            }
-            token = jsmn_alloc_token(parser);
-            parser->level += 1;
-            if (token == NULL) {
-                return JSMN_ERROR_NOMEM;
-            }
-            if (parser->parent_index != -1) {
-                jsmn_token_t *parent = &parser->tokens[parser->parent_index];
-#ifdef JSMN_STRICT
-                /* In strict mode an object or array can't become a key */
-                if (parent->type == JSMN_OBJECT) {
-                    return JSMN_ERROR_INVAL;
-                }
-#endif
-                parent->child_count++;
-#ifdef JSMN_PARENT_LINKS
-                token->parent_index = parser->parent_index;
-#endif
-            }
-            token->type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
-            token->start = &js[parser->pos];
-            parser->parent_index = parser->token_count - 1;
-            break;
-        case '}':
-        case ']':
-            parser->level -= 1;
-            if (parser->tokens == NULL) {
-                break;
-            }
-            type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
-#ifdef JSMN_PARENT_LINKS
-            if (parser->token_count < 1) {
-                return JSMN_ERROR_INVAL;
-            }
-            token = &parser->tokens[parser->token_count - 1];
-            for (;;) {
-                if (token->start != NULL && token->strlen == -1) {
-                    if (token->type != type) {
-                        return JSMN_ERROR_INVAL;
-                    }
-                    token->strlen = (parser->pos + 1) - (token->start - js);
-                    parser->parent_index = token->parent_index;
-                    break;
-                }
-                if (token->parent_index == -1) {
-                    if (token->type != type || parser->parent_index == -1) {
-                        return JSMN_ERROR_INVAL;
-                    }
-                    break;
-                }
-                token = &parser->tokens[token->parent_index];
-            }
-#else
-            for (i = parser->token_count - 1; i >= 0; i--) {
-                token = &parser->tokens[i];
-                if (token->start != NULL && token->strlen == -1) {
-                    if (token->type != type) {
-                        return JSMN_ERROR_INVAL;
-                    }
-                    parser->parent_index = -1;
-                    token->strlen = (parser->pos + 1) - (token->start - js);
-                    break;
-                }
-            }
-            /* Error if unmatched closing bracket */
-            if (i == -1) {
-                return JSMN_ERROR_INVAL;
-            }
-            for (; i >= 0; i--) {
-                token = &parser->tokens[i];
-                if (token->start != NULL && token->strlen == -1) {
-                    parser->parent_index = i;
-                    break;
-                }
-            }
-#endif
-            break;
-        case '\"':
-            r = jsmn_parse_string(parser, js, len);
-            if (r < 0) {
-                return r;
-            }
-            count++;
-            if (parser->parent_index != -1 && parser->tokens != NULL) {
-                parser->tokens[parser->parent_index].child_count++;
-            }
-            break;
-        case '\t':
-        case '\r':
-        case '\n':
-        case ' ':
-            break;
-        case ':':
-            parser->parent_index = parser->token_count - 1;
-            break;
-        case ',':
-            if (parser->tokens != NULL && parser->parent_index != -1 &&
-                parser->tokens[parser->parent_index].type != JSMN_ARRAY &&
-                parser->tokens[parser->parent_index].type != JSMN_OBJECT) {
-#ifdef JSMN_PARENT_LINKS
-                parser->parent_index =
-                    parser->tokens[parser->parent_index].parent_index;
-#else
-                for (i = parser->token_count - 1; i >= 0; i--) {
-                    if (parser->tokens[i].type == JSMN_ARRAY ||
-                        parser->tokens[i].type == JSMN_OBJECT) {
-                        if (parser->tokens[i].start != NULL &&
-                            parser->tokens[i].strlen == -1) {
-                            parser->parent_index = i;
-                            break;
-                        }
-                    }
-                }
-#endif
-            }
-            break;
-#ifdef JSMN_STRICT
-        /* In strict mode primitives are: numbers and booleans */
-        case '-':
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-        case 't':
-        case 'f':
-        case 'n':
-            /* And they must not be keys of the object */
-            if (parser->tokens != NULL && parser->parent_index != -1) {
-                const jsmn_token_t *t = &parser->tokens[parser->parent_index];
-                if (t->type == JSMN_OBJECT ||
-                    (t->type == JSMN_STRING && t->child_count != 0)) {
-                    return JSMN_ERROR_INVAL;
-                }
-            }
-#else
-        /* In non-strict mode every unquoted value is a primitive */
-        default:
-#endif
-            r = jsmn_parse_primitive(parser, js, len);
-            if (r < 0) {
-                return r;
-            }
-            count++;
-            if (parser->parent_index != -1 && parser->tokens != NULL) {
-                parser->tokens[parser->parent_index].child_count++;
-            }
+char *jsmn_alloc_padded(size_t len) {
+    char *buf = malloc(len + JSMN_PADDING);
+    if (buf != NULL) {
+        memset(&buf[len], 0, JSMN_PADDING);
+    }
+    return buf;
+}
+
+void jsmn_free_padded(char *buf) {
+    free(buf);
+}
+
+void jsmn_symtab_init(jsmn_symtab_t *symtab, jsmn_symbol_slot_t *slots,
+                      unsigned int num_slots) {
+    memset(slots, 0, sizeof(jsmn_symbol_slot_t) * num_slots);
+    symtab->slots = slots;
+    symtab->mask = num_slots - 1;
+    symtab->count = 0;
+    symtab->seeded = 0;
+}
+
+int jsmn_symtab_add(jsmn_symtab_t *symtab, const char *name) {
+    jsmn_symtab_reset(symtab);
+    int id = jsmn_symtab_intern(symtab, name, strlen(name));
+    if (id == 0) {
+        return JSMN_ERROR_NOMEM;
+    }
+    symtab->seeded = symtab->count;
+    return id;
+}
+
+int jsmn_symtab_intern(jsmn_symtab_t *symtab, const char *name, size_t len) {
+    unsigned int hash = symtab_hash(name, len);
+    unsigned int i = hash & symtab->mask;
+    jsmn_symbol_slot_t *slot;
+    for (;; i = (i + 1) & symtab->mask) {
+        slot = &symtab->slots[i];
+        if (slot->id == 0) {
             break;
+        }
+        if (slot->hash == hash && slot->len == len &&
+            memcmp(slot->name, name, len) == 0) {
+            return slot->id;
+        }
+    }
+    if (symtab->count >= SYMTAB_LOAD(symtab->mask)) {
+        return 0;
+    }
+    slot->name = name;
+    slot->len = (unsigned int)len;
+    slot->hash = hash;
+    slot->id = (unsigned short)++symtab->count;
+    return slot->id;
+}
 
-#ifdef JSMN_STRICT
-        /* Unexpected char in strict mode */
-        default:
-            return JSMN_ERROR_INVAL;
-#endif
+int jsmn_symtab_find(const jsmn_symtab_t *symtab, const char *name,
+                     size_t len) {
+    unsigned int hash = symtab_hash(name, len);
+    for (unsigned int i = hash & symtab->mask;; i = (i + 1) & symtab->mask) {
+        const jsmn_symbol_slot_t *slot = &symtab->slots[i];
+        if (slot->id == 0) {
+            return 0;
+        }
+        if (slot->hash == hash && slot->len == len &&
+            memcmp(slot->name, name, len) == 0) {
+            return slot->id;
         }
     }
+}
 
-    if (parser->tokens != NULL) {
-        for (i = parser->token_count - 1; i >= 0; i--) {
-            /* Unmatched opened object or array */
-            if (parser->tokens[i].start != NULL &&
-                parser->tokens[i].strlen == -1) {
-                return JSMN_ERROR_PART;
-            }
+void jsmn_symtab_reset(jsmn_symtab_t *symtab) {
+    if (symtab->count == symtab->seeded) {
+        return;
+    }
+    // Parse-time symbols were all inserted after the seeded ones, so no
+    // seeded probe sequence runs through them: clearing their slots leaves
+    // the table exactly as seeding left it.
+    for (unsigned int i = 0; i <= symtab->mask; i++) {
+        if (symtab->slots[i].id > symtab->seeded) {
+            symtab->slots[i].id = 0;
         }
     }
+    symtab->count = symtab->seeded;
+}
+
+void jsmn_set_symtab(jsmn_parser_t *parser, jsmn_symtab_t *symtab) {
+    parser->symtab = symtab;
+}
 
-    return count;
+void jsmn_keyset_init(jsmn_keyset_t *keyset, jsmn_keyset_slot_t *slots,
+                      unsigned int num_slots) {
+    keyset->slots = slots;
+    keyset->mask = num_slots - 1;
+    keyset->count = 1; // have the reset clear the slots
+    jsmn_keyset_reset(keyset);
 }
 
+int jsmn_keyset_insert(jsmn_keyset_t *keyset, int object, const char *name,
+                       size_t len) {
+    // the object index is mixed in, so its keys spread out from its
+    // neighbours' keys of the same name
+    unsigned int hash =
+        symtab_hash(name, len) ^ ((unsigned int)object * 0x9e3779b9u);
+    unsigned int i = hash & keyset->mask;
+    jsmn_keyset_slot_t *slot;
+    for (;; i = (i + 1) & keyset->mask) {
+        slot = &keyset->slots[i];
+        if (slot->name == NULL) {
+            break;
+        }
+        if (slot->hash == hash && slot->object == object &&
+            slot->len == len && memcmp(slot->name, name, len) == 0) {
+            return JSMN_ERROR_DUPKEY;
+        }
+    }
+    if (keyset->count >= SYMTAB_LOAD(keyset->mask)) {
+        return JSMN_ERROR_KEYSET;
+    }
+    slot->name = name;
+    slot->len = (unsigned int)len;
+    slot->hash = hash;
+    slot->object = object;
+    keyset->count++;
+    return 0;
+}
+
+void jsmn_keyset_reset(jsmn_keyset_t *keyset) {
+    if (keyset->count != 0) {
+        memset(keyset->slots, 0,
+               sizeof(jsmn_keyset_slot_t) * (keyset->mask + 1));
+        keyset->count = 0;
+    }
+}
+
+void jsmn_set_keyset(jsmn_parser_t *parser, jsmn_keyset_t *keyset) {
+    parser->keyset = keyset;
+}
+
+void jsmn_set_limits(jsmn_parser_t *parser, const jsmn_limits_t *limits) {
+    if (limits == NULL) {
+        memset(&parser->limits, 0, sizeof(parser->limits));
+    } else {
+        parser->limits = *limits;
+    }
+}
+
+
 jsmn_token_t *jsmn_token_ref(jsmn_parser_t *parser, int index) {
     if ((index < 0) || (index >= parser->token_count)) {
         return NULL;
@@ -287,7 +272,7 @@ jsmn_token_type_t jsmn_token_type(jsmn_token_t *token) {
     if (token == NULL) {
         return JSMN_UNDEFINED;
     } else {
-        return token->type;
+        return (jsmn_token_type_t)token->type;
     }
 }
 
@@ -335,20 +320,19 @@ int jsmn_parent_of(jsmn_parser_t *parser, int token_index) {
 }
 
 int jsmn_sibling_of(jsmn_parser_t *parser, int token_index) {
-    int level = jsmn_token_level(jsmn_token_ref(parser, token_index));
+    jsmn_token_t *token = jsmn_token_ref(parser, token_index);
+    int level = jsmn_token_level(token);
     if (level <= 0) {
         // if level is 0, we're already at top level so there's no sibling.
         // if level is -1, then token_index was invalid.
         return -1;
     }
-    // search forward for the next token with the same level number.
-    for (int i = token_index + 1; i < parser->token_count; i++) {
-        if (jsmn_token_level(jsmn_token_ref(parser, i)) == level) {
-            // found the sibling
-            return i;
-        }
+    // the token following this one's subtree is the sibling if it sits at
+    // the same level; otherwise this was the last child of its parent.
+    int next = token->end_index;
+    if (jsmn_token_level(jsmn_token_ref(parser, next)) == level) {
+        return next;
     }
-    // ran out of tokens without finding a sibling
     return -1;
 }
 
@@ -367,6 +351,58 @@ int jsmn_child_of(jsmn_parser_t *parser, int token_index) {
     return -1;
 }
 
+int jsmn_array_get(jsmn_parser_t *parser, int arr_index, int n) {
+    jsmn_token_t *arr = jsmn_token_ref(parser, arr_index);
+    if (arr == NULL || arr->type != JSMN_ARRAY || n < 0 ||
+        n >= arr->child_count) {
+        return -1;
+    }
+    const int *table = child_table(parser);
+    if (table != NULL) {
+        return table[table[arr_index] + n];
+    }
+    int child = arr_index + 1;
+    for (; n > 0 && child < (int)parser->token_count; n--) {
+        child = parser->tokens[child].end_index;
+    }
+    return (n == 0 && child < (int)parser->token_count) ? child : -1;
+}
+
+int jsmn_object_member(jsmn_parser_t *parser, int obj_index, int n) {
+    jsmn_token_t *obj = jsmn_token_ref(parser, obj_index);
+    if (obj == NULL || obj->type != JSMN_OBJECT || n < 0 ||
+        n >= obj->child_count) {
+        return -1;
+    }
+    const int *table = child_table(parser);
+    if (table != NULL) {
+        return table[table[obj_index] + n];
+    }
+    int key = obj_index + 1;
+    for (; n > 0 && key + 1 < (int)parser->token_count; n--) {
+        key = parser->tokens[key + 1].end_index;
+    }
+    return (n == 0 && key < (int)parser->token_count) ? key : -1;
+}
+
+void jsmn_child_index_init(jsmn_child_index_t *index, int *table,
+                           unsigned int size) {
+    index->table = table;
+    index->size = size;
+    index->built = false;
+}
+
+void jsmn_set_child_index(jsmn_parser_t *parser, jsmn_child_index_t *index) {
+    parser->children = index;
+    jsmn_child_index_invalidate(parser);
+}
+
+void jsmn_child_index_invalidate(jsmn_parser_t *parser) {
+    if (parser->children != NULL) {
+        parser->children->built = false;
+    }
+}
+
 bool jsmn_token_stringeq(jsmn_token_t *token, const char *literal) {
     // printf("stringeq tok '%.*s'\n", jsmn_token_strlen(token),
     // jsmn_token_string(token));
@@ -385,6 +421,23 @@ int jsmn_token_find(jsmn_parser_t *parser, const char *literal) {
     return -1;
 }
 
+jsmn_class_t jsmn_token_class(jsmn_token_t *token) {
+    if (token == NULL || token->type != JSMN_PRIMITIVE) {
+        return JSMN_CLASS_NONE;
+    } else {
+        return (jsmn_class_t)(token->subtype & JSMN_CLASS_MASK);
+    }
+}
+
+bool jsmn_token_is_negative(jsmn_token_t *token) {
+    return jsmn_token_class(token) != JSMN_CLASS_NONE &&
+           (token->subtype & JSMN_CLASS_NEGATIVE) != 0;
+}
+
+int jsmn_token_symbol(jsmn_token_t *token) {
+    return token == NULL ? 0 : token->symbol;
+}
+
 bool jsmn_token_is_array(jsmn_token_t *token) {
     if (token == NULL) {
         return false;
@@ -394,33 +447,29 @@ bool jsmn_token_is_array(jsmn_token_t *token) {
 }
 
 bool jsmn_token_is_boolean(jsmn_token_t *token) {
-    return jsmn_token_is_false(token) || jsmn_token_is_true(token);
+    jsmn_class_t class_ = jsmn_token_class(token);
+    return class_ == JSMN_CLASS_TRUE || class_ == JSMN_CLASS_FALSE;
 }
 
 bool jsmn_token_is_false(jsmn_token_t *token) {
-    return jsmn_token_is_primitive(token) && (*jsmn_token_string(token) == 'f');
+    return jsmn_token_class(token) == JSMN_CLASS_FALSE;
 }
 
 bool jsmn_token_is_float(jsmn_token_t *token) {
-    return jsmn_token_is_number(token) &&
-           memchr(jsmn_token_string(token), '.', jsmn_token_strlen(token));
+    return jsmn_token_class(token) == JSMN_CLASS_FLOAT;
 }
 
 bool jsmn_token_is_integer(jsmn_token_t *token) {
-    return jsmn_token_is_number(token) && !jsmn_token_is_float(token);
+    return jsmn_token_class(token) == JSMN_CLASS_INTEGER;
 }
 
 bool jsmn_token_is_null(jsmn_token_t *token) {
-    return jsmn_token_is_primitive(token) && (*jsmn_token_string(token) == 'n');
+    return jsmn_token_class(token) == JSMN_CLASS_NULL;
 }
 
 bool jsmn_token_is_number(jsmn_token_t *token) {
-    if (!jsmn_token_is_primitive(token)) {
-        return false;
-    } else {
-        unsigned char c = *jsmn_token_string(token);
-        return ((c >= '0') && (c <= '9')) || (c == '-');
-    }
+    jsmn_class_t class_ = jsmn_token_class(token);
+    return class_ == JSMN_CLASS_INTEGER || class_ == JSMN_CLASS_FLOAT;
 }
 
 bool jsmn_token_is_object(jsmn_token_t *token) {
@@ -448,170 +497,63 @@ bool jsmn_token_is_string(jsmn_token_t *token) {
 }
 
 bool jsmn_token_is_true(jsmn_token_t *token) {
-    return jsmn_token_is_primitive(token) && (*jsmn_token_string(token) == 't');
+    return jsmn_token_class(token) == JSMN_CLASS_TRUE;
 }
 
-// *****************************************************************************
-// local (private) functions
-
-static void reset_parser(jsmn_parser_t *parser) {
-    memset(parser->tokens, 0, sizeof(jsmn_token_t) * parser->num_tokens);
-    parser->pos = 0;
-    parser->token_count = 0;
-    parser->parent_index = -1;
-    parser->level = 0;
+void jsmn_stats_get(const jsmn_parser_t *parser, jsmn_stats_t *stats) {
+    *stats = parser->stats;
 }
 
-static jsmn_token_t *jsmn_alloc_token(jsmn_parser_t *parser) {
-    jsmn_token_t *tok;
-    if (parser->token_count >= parser->num_tokens) {
-        return NULL;
-    }
-    tok = &parser->tokens[parser->token_count++];
-    tok->start = NULL;
-    tok->strlen = -1;
-    tok->child_count = 0;
-#ifdef JSMN_PARENT_LINKS
-    tok->parent_index = -1;
-#endif
-    tok->level = parser->level;
-    return tok;
+void jsmn_stats_reset(jsmn_parser_t *parser) {
+    memset(&parser->stats, 0, sizeof(parser->stats));
 }
 
-static void jsmn_fill_token(jsmn_token_t *token, const jsmn_token_type_t type,
-                            const char *start, int length) {
-    token->type = type;
-    token->start = start;
-    token->strlen = length;
-    token->child_count = 0;
-}
+// *****************************************************************************
+// local (private) functions
 
-static int jsmn_parse_primitive(jsmn_parser_t *parser, const char *js,
-                                const size_t len) {
-    jsmn_token_t *token;
-    int start; // index, not char pointer!
+static unsigned int symtab_hash(const char *name, size_t len) {
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return h;
+}
 
-    start = parser->pos;
+static const int *child_table(jsmn_parser_t *parser) {
+    jsmn_child_index_t *index = parser->children;
+    int count = (int)parser->token_count;
 
-    for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
-        switch (js[parser->pos]) {
-#ifndef JSMN_STRICT
-        /* In strict mode primitive must be followed by "," or "}" or "]" */
-        case ':':
-#endif
-        case '\t':
-        case '\r':
-        case '\n':
-        case ' ':
-        case ',':
-        case ']':
-        case '}':
-            goto found;
-        default:
-            /* to quiet a warning from gcc*/
-            break;
-        }
-        if (js[parser->pos] < 32 || js[parser->pos] >= 127) {
-            parser->pos = start;
-            return JSMN_ERROR_INVAL;
-        }
+    if (index == NULL) {
+        return NULL;
     }
-#ifdef JSMN_STRICT
-    /* In strict mode primitive must be followed by a comma/object/array */
-    parser->pos = start;
-    return JSMN_ERROR_PART;
-#endif
-
-found:
-    if (parser->tokens == NULL) {
-        parser->pos--;
-        return 0;
+    if (index->built) {
+        return index->table;
     }
-    token = jsmn_alloc_token(parser);
-    if (token == NULL) {
-        parser->pos = start;
-        return JSMN_ERROR_NOMEM;
+    if (index->size / 2 < parser->token_count) {
+        return NULL;
     }
-    jsmn_fill_token(token, JSMN_PRIMITIVE, &js[start], parser->pos - start);
-#ifdef JSMN_PARENT_LINKS
-    token->parent_index = parser->parent_index;
-#endif
-    parser->pos--;
-    return 0;
-}
-
-static int jsmn_parse_string(jsmn_parser_t *parser, const char *js,
-                             const size_t len) {
-    jsmn_token_t *token;
-
-    int start = parser->pos; // index, not char pointer!
-
-    /* Skip starting quote */
-    parser->pos++;
-
-    for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
-        char c = js[parser->pos];
-
-        /* Quote: end of string */
-        if (c == '\"') {
-            if (parser->tokens == NULL) {
-                return 0;
-            }
-            token = jsmn_alloc_token(parser);
-            if (token == NULL) {
-                parser->pos = start;
-                return JSMN_ERROR_NOMEM;
-            }
-            jsmn_fill_token(token, JSMN_STRING, &js[start + 1],
-                            parser->pos - start - 1);
-#ifdef JSMN_PARENT_LINKS
-            token->parent_index = parser->parent_index;
-#endif
-            return 0;
+    // one pass: each token is listed once, as a child of its container
+    int *table = index->table;
+    int next = count;
+    for (int i = 0; i < count; i++) {
+        const jsmn_token_t *tok = &parser->tokens[i];
+        if (tok->type != JSMN_OBJECT && tok->type != JSMN_ARRAY) {
+            table[i] = -1;
+            continue;
         }
-
-        /* Backslash: Quoted symbol expected */
-        if (c == '\\' && parser->pos + 1 < len) {
-            int i;
-            parser->pos++;
-            switch (js[parser->pos]) {
-            /* Allowed escaped symbols */
-            case '\"':
-            case '/':
-            case '\\':
-            case 'b':
-            case 'f':
-            case 'r':
-            case 'n':
-            case 't':
-                break;
-            /* Allows escaped symbol \uXXXX */
-            case 'u':
-                parser->pos++;
-                for (i = 0;
-                     i < 4 && parser->pos < len && js[parser->pos] != '\0';
-                     i++) {
-                    /* If it isn't a hex character we have an error */
-                    if (!((js[parser->pos] >= 48 &&
-                           js[parser->pos] <= 57) || /* 0-9 */
-                          (js[parser->pos] >= 65 &&
-                           js[parser->pos] <= 70) || /* A-F */
-                          (js[parser->pos] >= 97 &&
-                           js[parser->pos] <= 102))) { /* a-f */
-                        parser->pos = start;
-                        return JSMN_ERROR_INVAL;
-                    }
-                    parser->pos++;
-                }
-                parser->pos--;
-                break;
-            /* Unexpected symbol */
-            default:
-                parser->pos = start;
-                return JSMN_ERROR_INVAL;
+        table[i] = next;
+        int child = i + 1;
+        for (int k = 0; k < tok->child_count; k++) {
+            // a failed parse may leave a container short of children
+            int last = (tok->type == JSMN_OBJECT) ? child + 1 : child;
+            if (last >= count) {
+                table[next++] = -1;
+                continue;
             }
+            table[next++] = child;
+            child = parser->tokens[last].end_index;
         }
     }
-    parser->pos = start;
-    return JSMN_ERROR_PART;
+    index->built = true;
+    return table;
 }
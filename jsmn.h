@@ -31,6 +31,14 @@
 extern "C" {
 #endif
 
+/**
+ * Bytes of zero padding jsmn_parse_padded() needs after its input.  At least
+ * 64, the widest block the string kernels read; may be raised at build time.
+ */
+#ifndef JSMN_PADDING
+#define JSMN_PADDING 64
+#endif
+
 /**
  * JSON type identifier. Basic types are:
  * 	o Object
@@ -46,32 +54,153 @@ typedef enum {
   JSMN_PRIMITIVE = 1 << 3,
 } jsmn_token_type_t;
 
+/**
+ * Class of a PRIMITIVE token, worked out by the parser while scanning it and
+ * kept in jsmn_token_t.subtype.  Numbers with a leading '-' also have
+ * JSMN_CLASS_NEGATIVE set.
+ */
+typedef enum {
+  JSMN_CLASS_NONE = 0,       // not a primitive
+  JSMN_CLASS_INTEGER = 1,    // number without fraction or exponent
+  JSMN_CLASS_FLOAT = 2,      // number with a fraction and/or an exponent
+  JSMN_CLASS_TRUE = 3,       // true
+  JSMN_CLASS_FALSE = 4,      // false
+  JSMN_CLASS_NULL = 5,       // null
+  JSMN_CLASS_OTHER = 6,      // any other bare word (lenient parsers only)
+  JSMN_CLASS_NEGATIVE = 0x80 // flag: number with a leading '-'
+} jsmn_class_t;
+
+/* Bits of jsmn_token_t.subtype that hold the class, without the flag */
+#define JSMN_CLASS_MASK 0x7f
+
 typedef enum {
   /* Not enough tokens were provided */
   JSMN_ERROR_NOMEM = -1,
   /* Invalid character inside JSON string */
   JSMN_ERROR_INVAL = -2,
   /* The string is not a full JSON packet, more bytes expected */
-  JSMN_ERROR_PART = -3
+  JSMN_ERROR_PART = -3,
+  /* A resource limit set by jsmn_set_limits() was exceeded */
+  JSMN_ERROR_LIMIT = -4,
+  /* An object has the same key twice (see jsmn_set_keyset()) */
+  JSMN_ERROR_DUPKEY = -5,
+  /* The duplicate key set is full; more tokens will not help */
+  JSMN_ERROR_KEYSET = -6
 } jsmn_err_t;
 
 /**
  * JSON token description.
  * type		type (object, array, string etc.)
+ * subtype	for primitives, the class found by the parser (integer, float,
+ *      true, false, null) plus the negative flag; see jsmn_token_class().
+ * symbol for object keys, the key's ID in the parser's symbol table (see
+ *      jsmn_set_symtab()), or 0 if there is no table or no room in it.
  * start	pointer to the first char of the token string
  * strlen number of characters in the token string.
+ * parent_index filled in by parsers with parent links (jsmn_parse() in
+ *      JSMN_PARENT_LINKS builds, jsmn_parse_strict(), jsmn_parse_lenient(),
+ *      jsmn_parse_trusted()); -1 otherwise.  The layout is the same either
+ *      way.
+ * end_index for an OBJECT or ARRAY, the index of the first token after its
+ *      last nested token; for strings and primitives (object keys included)
+ *      the index of the token itself plus one.  Skipping a value is therefore
+ *      a single lookup, however large the value.
  */
 typedef struct {
-  jsmn_token_type_t type;
   const char *start;     // start of token string
+  unsigned char type;    // jsmn_token_type_t
+  unsigned char subtype; // jsmn_class_t of a PRIMITIVE, else 0
+  unsigned short symbol; // interned symbol ID of an object key, else 0
   int strlen;            // length of token string
   int child_count;       // number of nested tokens within OBJECT or ARRAy
-#ifdef JSMN_PARENT_LINKS
-  int parent_index;      // index to token that contains this token
-#endif
+  int parent_index;      // index to token that contains this token, or -1
   int level;
+  int end_index;         // index of the first token past this token's subtree
 } jsmn_token_t;
 
+/**
+ * Resource budgets applied to each call to jsmn_parse().  A field of zero
+ * means "no limit".
+ */
+typedef struct {
+  unsigned int max_depth;  // deepest allowed nesting of objects and arrays
+  unsigned int max_tokens; // most tokens a document may produce
+  unsigned int max_strlen; // longest allowed string or primitive, in bytes
+  size_t max_bytes;        // most input bytes examined per call
+} jsmn_limits_t;
+
+/**
+ * Hot-path counters, accumulated over every parse until they are cleared
+ * with jsmn_stats_reset().  Only parsers built with statistics update them:
+ * jsmn_parse() in JSMN_STATS builds, or a jsmn_engine.h variant with
+ * JSMN_ENGINE_STATS.
+ */
+typedef struct {
+  unsigned long bytes_scanned;    // input bytes examined
+  unsigned long tokens_allocated; // tokens taken from the token pool
+  unsigned long backscan_steps;   // tokens visited by '}', ']' and ',' scans
+  unsigned long escapes;          // escape sequences inside strings
+  unsigned long nomem_retries;    // calls that returned JSMN_ERROR_NOMEM
+  int max_depth;                  // deepest nesting level reached
+} jsmn_stats_t;
+
+/**
+ * One slot of a symbol table.
+ */
+typedef struct {
+  const char *name;    // key text, not NUL terminated
+  unsigned int len;    // length of name
+  unsigned int hash;   // hash of name
+  unsigned short id;   // symbol ID, or 0 for an empty slot
+} jsmn_symbol_slot_t;
+
+/**
+ * Interning table mapping object keys to small integer symbol IDs, stored
+ * in caller supplied slots.  Keys added with jsmn_symtab_add() keep their
+ * IDs for the life of the table; keys first met during a parse get the next
+ * free IDs, which last only until the next parse.
+ */
+typedef struct {
+  jsmn_symbol_slot_t *slots; // open-addressed table
+  unsigned int mask;         // number of slots - 1
+  unsigned int count;        // symbols interned
+  unsigned int seeded;       // symbols added by jsmn_symtab_add()
+} jsmn_symtab_t;
+
+/**
+ * One slot of a duplicate key set.
+ */
+typedef struct {
+  const char *name;  // key text, not NUL terminated; NULL for an empty slot
+  unsigned int len;  // length of name
+  unsigned int hash; // hash of name and object
+  int object;        // token index of the object holding the key
+} jsmn_keyset_slot_t;
+
+/**
+ * The keys met so far in each object of a parse, in caller supplied slots,
+ * for rejecting duplicate keys.  One open-addressed table serves every
+ * object: entries are told apart by the index of their object, so each
+ * object in effect has its own set and nothing is cleared when it closes.
+ */
+typedef struct {
+  jsmn_keyset_slot_t *slots; // open-addressed table
+  unsigned int mask;         // number of slots - 1
+  unsigned int count;        // keys in the set
+} jsmn_keyset_t;
+
+/**
+ * Table of the children of every object and array, for constant time
+ * jsmn_array_get() and jsmn_object_member().  Stored in caller supplied ints
+ * (two per token) and built by the first such call after a parse.
+ */
+typedef struct {
+  int *table;        // per token: offset of its children in table; then
+                     // the children of each container, in order
+  unsigned int size; // ints in table
+  bool built;        // table describes the parser's current tokens
+} jsmn_child_index_t;
+
 /**
  * JSON parser. Contains an array of token blocks available. Also stores
  * the string being parsed now and current position in that string.
@@ -83,19 +212,173 @@ typedef struct {
   unsigned int pos;         // offset in the JSON string
   int parent_index;         // index of containing node (array or object) or -1
   int level;
+  jsmn_limits_t limits;     // resource budgets, see jsmn_set_limits()
+  jsmn_stats_t stats;       // hot-path counters
+  jsmn_symtab_t *symtab;    // key interning table, or NULL
+  jsmn_child_index_t *children; // child offset table, or NULL
+  jsmn_keyset_t *keyset;    // duplicate key set, or NULL
 } jsmn_parser_t;
 
+/**
+ * A parser entry point: jsmn_parse() or one of its variants.
+ */
+typedef int (*jsmn_parse_fn)(jsmn_parser_t *parser, const char *js,
+                             const size_t len);
+
 /**
  * Create JSON parser over an array of tokens
  */
 void jsmn_init(jsmn_parser_t *parser, jsmn_token_t *tokens, unsigned int num_tokens);
 
+/**
+ * @brief Bound the work done by subsequent calls to jsmn_parse().  Once any
+ * limit is exceeded jsmn_parse() stops and returns JSMN_ERROR_LIMIT.  Pass
+ * NULL to remove all limits.  jsmn_init() also removes all limits.
+ */
+void jsmn_set_limits(jsmn_parser_t *parser, const jsmn_limits_t *limits);
+
+/**
+ * @brief Prepare a symbol table over num_slots slots.  num_slots must be a
+ * power of two no greater than 65536; the table holds up to 3/4 of it.
+ */
+void jsmn_symtab_init(jsmn_symtab_t *symtab, jsmn_symbol_slot_t *slots,
+                      unsigned int num_slots);
+
+/**
+ * @brief Seed the table with a key known in advance, returning its symbol
+ * ID (the same ID if it is already present), or JSMN_ERROR_NOMEM if the
+ * table is full.  name must outlive the table.  Drops the symbols of the
+ * last parse.
+ */
+int jsmn_symtab_add(jsmn_symtab_t *symtab, const char *name);
+
+/**
+ * @brief Return the symbol ID of the len-byte key at name, interning it if
+ * it is new and there is room.  Returns 0 if the table is full.
+ */
+int jsmn_symtab_intern(jsmn_symtab_t *symtab, const char *name, size_t len);
+
+/**
+ * @brief Return the symbol ID of the len-byte key at name, or 0 if it has
+ * none.
+ */
+int jsmn_symtab_find(const jsmn_symtab_t *symtab, const char *name,
+                     size_t len);
+
+/**
+ * @brief Forget the symbols interned by parses, keeping the seeded ones.
+ * Every parse with the table attached starts by doing this.
+ */
+void jsmn_symtab_reset(jsmn_symtab_t *symtab);
+
+/**
+ * @brief Have subsequent parses give each object key the symbol ID of its
+ * raw text (escapes as written) in symtab.  Pass NULL to stop.  jsmn_init()
+ * also detaches the table.
+ */
+void jsmn_set_symtab(jsmn_parser_t *parser, jsmn_symtab_t *symtab);
+
+/**
+ * @brief Prepare a duplicate key set over num_slots slots.  num_slots must
+ * be a power of two; the set holds up to 3/4 of it.  See jsmn_set_keyset()
+ * for how many a document needs.
+ */
+void jsmn_keyset_init(jsmn_keyset_t *keyset, jsmn_keyset_slot_t *slots,
+                      unsigned int num_slots);
+
+/**
+ * @brief Add the len-byte key at name to the keys of the object at token
+ * index object.  Returns 0, JSMN_ERROR_DUPKEY if the object already has the
+ * key, or JSMN_ERROR_KEYSET if the set is full.
+ */
+int jsmn_keyset_insert(jsmn_keyset_t *keyset, int object, const char *name,
+                       size_t len);
+
+/**
+ * @brief Empty the set.  Every parse with the set attached starts by doing
+ * this.
+ */
+void jsmn_keyset_reset(jsmn_keyset_t *keyset);
+
+/**
+ * @brief Have subsequent parses reject objects with duplicate keys: a parse
+ * fails with JSMN_ERROR_DUPKEY at the second occurrence of a key, compared
+ * by raw text (escapes as written).  Each key is hashed as it is scanned,
+ * so the check stays linear in the number of keys.
+ *
+ * Entries stay in the set until the next parse, also after their object
+ * closes, so the set must hold every key of the document, counted over all
+ * objects: num_slots of jsmn_keyset_init() at least 4/3 of that total.  A
+ * parse with more keys fails with JSMN_ERROR_KEYSET, which unlike
+ * JSMN_ERROR_NOMEM is not cured by a bigger token array.  Since a key takes
+ * at least two tokens, a set with at least as many slots as tokens is always
+ * big enough.
+ *
+ * Counting parses (no tokens) do not check.  Pass NULL to stop; jsmn_init()
+ * also detaches the set.
+ */
+void jsmn_set_keyset(jsmn_parser_t *parser, jsmn_keyset_t *keyset);
+
 /**
  * Run JSON parser. It parses a JSON data string into and array of tokens, each
  * describing a single JSON object.
  */
 int jsmn_parse(jsmn_parser_t *parser, const char *js, const size_t len);
 
+/**
+ * @brief jsmn_parse() fixed to strict RFC 8259 parsing with parent links,
+ * whatever the build flags.  Suited to untrusted input.
+ */
+int jsmn_parse_strict(jsmn_parser_t *parser, const char *js, const size_t len);
+
+/**
+ * @brief jsmn_parse() fixed to lenient parsing (see JSMN_STRICT) with parent
+ * links, whatever the build flags.  Suited to trusted internal data.
+ */
+int jsmn_parse_lenient(jsmn_parser_t *parser, const char *js,
+                       const size_t len);
+
+/**
+ * @brief Parse input known to be well-formed JSON, such as the output of
+ * jsmn_writer, skipping the per-byte validation the other parsers do.  For
+ * valid input the tokens match jsmn_parse_lenient(), so a bare top-level
+ * primitive such as 1 or true gives one token where jsmn_parse_strict()
+ * returns JSMN_ERROR_PART; for anything else the result is unspecified.
+ * Never use it on untrusted input.
+ */
+int jsmn_parse_trusted(jsmn_parser_t *parser, const char *js,
+                       const size_t len);
+
+/**
+ * @brief Parse like jsmn_parse_lenient() from a padded buffer: js[len] must
+ * be '\0' and the JSMN_PADDING bytes from js[len] on must be readable.  The
+ * scanners then test only for the terminating NUL instead of the length,
+ * and pass over string text with jsmn_scan_string_padded(), whose blocks
+ * may run past len into the padding.  A byte budget (jsmn_limits_t.max_bytes)
+ * smaller than len fails at once with JSMN_ERROR_LIMIT.
+ */
+int jsmn_parse_padded(jsmn_parser_t *parser, const char *js,
+                      const size_t len);
+
+/**
+ * @brief jsmn_parse_strict() driven by character class tables instead of
+ * per-character switches (see JSMN_ENGINE_TABLE in jsmn_engine.h).  Gives
+ * the same tokens and errors with fewer hard-to-predict branches, and needs
+ * no SIMD.
+ */
+int jsmn_parse_table(jsmn_parser_t *parser, const char *js, const size_t len);
+
+/**
+ * @brief Allocate a buffer for len bytes of input followed by JSMN_PADDING
+ * zero bytes, ready for jsmn_parse_padded().  Returns NULL if out of memory.
+ */
+char *jsmn_alloc_padded(size_t len);
+
+/**
+ * @brief Free a buffer from jsmn_alloc_padded().
+ */
+void jsmn_free_padded(char *buf);
+
 /**
  * @brief Return a token, referenced by index.  Return NULL if out of range.
  */
@@ -140,6 +423,39 @@ int jsmn_sibling_of(jsmn_parser_t *parser, int token_index);
  */
 int jsmn_child_of(jsmn_parser_t *parser, int token_index);
 
+/**
+ * @brief Return the index of element n of the array at arr_index, or -1 if
+ * there is no such element.  Constant time with a child index attached (see
+ * jsmn_set_child_index()); otherwise it steps over the n elements before.
+ */
+int jsmn_array_get(jsmn_parser_t *parser, int arr_index, int n);
+
+/**
+ * @brief Return the index of the key of member n of the object at
+ * obj_index (its value follows it), or -1 if there is no such member.
+ * Constant time with a child index attached, like jsmn_array_get().
+ */
+int jsmn_object_member(jsmn_parser_t *parser, int obj_index, int n);
+
+/**
+ * @brief Prepare a child index over size ints of table.  It needs two per
+ * token of the parses it indexes; with fewer, lookups fall back to stepping.
+ */
+void jsmn_child_index_init(jsmn_child_index_t *index, int *table,
+                           unsigned int size);
+
+/**
+ * @brief Have jsmn_array_get() and jsmn_object_member() use index, building
+ * it on first use after each parse.  Pass NULL to stop.
+ */
+void jsmn_set_child_index(jsmn_parser_t *parser, jsmn_child_index_t *index);
+
+/**
+ * @brief Mark the parser's child index out of date.  Parsing does this;
+ * call it after changing the tokens any other way.
+ */
+void jsmn_child_index_invalidate(jsmn_parser_t *parser);
+
 /**
  * @brief Return true if the underlying token string equals literal.
  */
@@ -151,6 +467,26 @@ bool jsmn_token_stringeq(jsmn_token_t *token, const char *literal);
  */
 int jsmn_token_find(jsmn_parser_t *parser, const char *literal);
 
+/**
+ * @brief Return the class of a primitive token, without JSMN_CLASS_NEGATIVE,
+ * or JSMN_CLASS_NONE for other tokens and NULL.
+ */
+jsmn_class_t jsmn_token_class(jsmn_token_t *token);
+
+/**
+ * @brief Return true if the token is a number with a leading '-'.
+ */
+bool jsmn_token_is_negative(jsmn_token_t *token);
+
+/**
+ * @brief Return the symbol ID of an object key token, or 0 if it has none.
+ */
+int jsmn_token_symbol(jsmn_token_t *token);
+
+/*
+ * Type predicates.  All are constant time: the primitive ones read the class
+ * recorded at parse time rather than the token text.
+ */
 bool jsmn_token_is_array(jsmn_token_t *token);
 bool jsmn_token_is_boolean(jsmn_token_t *token);
 bool jsmn_token_is_false(jsmn_token_t *token);
@@ -164,6 +500,16 @@ bool jsmn_token_is_string(jsmn_token_t *token);
 bool jsmn_token_is_true(jsmn_token_t *token);
 bool jsmn_token_is_array(jsmn_token_t *token);
 
+/**
+ * @brief Copy the parser's accumulated statistics into stats.
+ */
+void jsmn_stats_get(const jsmn_parser_t *parser, jsmn_stats_t *stats);
+
+/**
+ * @brief Clear the parser's accumulated statistics.
+ */
+void jsmn_stats_reset(jsmn_parser_t *parser);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,649 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_HPP
+#define JSMN_HPP
+
+/**
+ * Header-only C++17 view over jsmn tokens.  Values, ranges and iterators
+ * are small copyable handles into a parsed token array: nothing here
+ * allocates, copies input text or throws.  Iteration over arrays and
+ * objects steps from one child to the next through jsmn_token_t.end_index,
+ * so skipping a nested value costs the same regardless of its size.
+ *
+ *     jsmn::document<64> doc;
+ *     if (doc.parse(text) > 0) {
+ *         for (auto [name, val] : doc.root().members()) { ... }
+ *         std::int64_t id = doc.root()["id"].get<std::int64_t>();
+ *     }
+ */
+
+#include "jsmn.h"
+#include "jsmn_bind.h"
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace jsmn {
+
+/**
+ * @brief An object key to look up, with a hash computed when the key is
+ * constructed (at compile time for literals and constexpr keys).  The hash
+ * packs the key's length with its first and last bytes, so the same hash
+ * can be taken from a document key in constant time and most non-matching
+ * keys are rejected without touching the rest of their text.
+ */
+class key {
+  public:
+    template <std::size_t N>
+    constexpr key(const char (&name)[N]) noexcept
+        : key(std::string_view(name, N - 1)) {}
+
+    constexpr explicit key(std::string_view name) noexcept
+        : name_(name), hash_(hash_of(name.data(), name.size())) {}
+
+    constexpr std::string_view name() const noexcept { return name_; }
+    constexpr std::uint32_t hash() const noexcept { return hash_; }
+
+    /** @brief Hash of the n bytes at s, in the form stored by key. */
+    static constexpr std::uint32_t hash_of(const char *s,
+                                           std::size_t n) noexcept {
+        return n == 0 ? 0
+                      : (static_cast<std::uint32_t>(n) << 16) ^
+                            (static_cast<std::uint32_t>(
+                                 static_cast<unsigned char>(s[0]))
+                             << 8) ^
+                            static_cast<unsigned char>(s[n - 1]);
+    }
+
+  private:
+    std::string_view name_;
+    std::uint32_t hash_;
+};
+
+namespace literals {
+/** @brief "name"_key: a key whose hash is folded at compile time. */
+constexpr key operator""_key(const char *s, std::size_t n) noexcept {
+    return key(std::string_view(s, n));
+}
+} // namespace literals
+
+class array_range;
+class object_range;
+
+/**
+ * @brief A handle to one token of a parsed document.  A default
+ * constructed value, or one produced by a failed lookup, is invalid: its
+ * predicates return false, its text is empty and get() fails.
+ */
+class value {
+  public:
+    constexpr value() noexcept = default;
+
+    constexpr value(const jsmn_token_t *tokens, int count, int index) noexcept
+        : tokens_(tokens), count_(count), index_(index) {}
+
+    /** @brief View token `index` of a parser filled by jsmn_parse(). */
+    explicit value(const jsmn_parser_t &parser, int index = 0) noexcept
+        : value(parser.tokens, static_cast<int>(parser.token_count), index) {}
+
+    bool valid() const noexcept {
+        return tokens_ != nullptr && index_ >= 0 && index_ < count_;
+    }
+    explicit operator bool() const noexcept { return valid(); }
+
+    int index() const noexcept { return index_; }
+    const jsmn_token_t &token() const noexcept { return tokens_[index_]; }
+
+    jsmn_token_type_t type() const noexcept {
+        return valid() ? static_cast<jsmn_token_type_t>(token().type)
+                       : JSMN_UNDEFINED;
+    }
+
+    /** @brief Class of a primitive, as recorded by the parser. */
+    jsmn_class_t primitive_class() const noexcept {
+        return is_primitive()
+                   ? static_cast<jsmn_class_t>(token().subtype & JSMN_CLASS_MASK)
+                   : JSMN_CLASS_NONE;
+    }
+
+    bool is_object() const noexcept { return type() == JSMN_OBJECT; }
+    bool is_array() const noexcept { return type() == JSMN_ARRAY; }
+    bool is_string() const noexcept { return type() == JSMN_STRING; }
+    bool is_primitive() const noexcept { return type() == JSMN_PRIMITIVE; }
+    bool is_null() const noexcept {
+        return primitive_class() == JSMN_CLASS_NULL;
+    }
+    bool is_bool() const noexcept {
+        return primitive_class() == JSMN_CLASS_TRUE ||
+               primitive_class() == JSMN_CLASS_FALSE;
+    }
+    bool is_integer() const noexcept {
+        return primitive_class() == JSMN_CLASS_INTEGER;
+    }
+    bool is_float() const noexcept {
+        return primitive_class() == JSMN_CLASS_FLOAT;
+    }
+    bool is_number() const noexcept { return is_integer() || is_float(); }
+    bool is_negative() const noexcept {
+        return is_number() && (token().subtype & JSMN_CLASS_NEGATIVE) != 0;
+    }
+
+    /**
+     * @brief The token's text: string contents without the quotes (escape
+     * sequences are left as written), primitive text, or the complete text
+     * of an object or array.
+     */
+    std::string_view text() const noexcept {
+        if (!valid() || token().strlen < 0) {
+            return std::string_view();
+        }
+        return std::string_view(token().start,
+                                static_cast<std::size_t>(token().strlen));
+    }
+
+    /** @brief Number of keys in an object or elements in an array. */
+    int size() const noexcept { return valid() ? token().child_count : 0; }
+
+    /** @brief The member of this object named k, or an invalid value. */
+    value find(key k) const noexcept {
+        if (!is_object()) {
+            return value();
+        }
+        const std::string_view name = k.name();
+        for (int i = index_ + 1; i < token().end_index;) {
+            const jsmn_token_t &t = tokens_[i];
+            if (t.strlen >= 0 &&
+                key::hash_of(t.start, static_cast<std::size_t>(t.strlen)) ==
+                    k.hash() &&
+                static_cast<std::size_t>(t.strlen) == name.size() &&
+                std::memcmp(t.start, name.data(), name.size()) == 0) {
+                return t.child_count > 0 ? value(tokens_, count_, i + 1)
+                                         : value();
+            }
+            i = t.child_count > 0 ? tokens_[i + 1].end_index : i + 1;
+        }
+        return value();
+    }
+
+    value operator[](key k) const noexcept { return find(k); }
+
+    /** @brief Element n of this array, or an invalid value. */
+    value operator[](std::size_t n) const noexcept {
+        if (!is_array()) {
+            return value();
+        }
+        int i = index_ + 1;
+        for (; n > 0 && i < token().end_index; n--) {
+            i = tokens_[i].end_index;
+        }
+        return i < token().end_index ? value(tokens_, count_, i) : value();
+    }
+
+    /** @brief The elements of this array; empty if this is not an array. */
+    array_range elements() const noexcept;
+
+    /** @brief The members of this object; empty if this is not an object. */
+    object_range members() const noexcept;
+
+    /**
+     * @brief Convert the token to T and store it in out.  Supported types
+     * are std::string_view (strings), bool (true/false), any integral type
+     * (numbers with no fraction or exponent that fit in T), float or double
+     * (any number) and jsmn::value (the token itself).  Returns false and
+     * leaves out untouched if the token does not hold a T.
+     */
+    template <typename T> bool try_get(T &out) const noexcept {
+        if constexpr (std::is_same_v<T, value>) {
+            if (!valid()) {
+                return false;
+            }
+            out = *this;
+            return true;
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            if (!is_string()) {
+                return false;
+            }
+            out = text();
+            return true;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            if (!is_bool()) {
+                return false;
+            }
+            out = primitive_class() == JSMN_CLASS_TRUE;
+            return true;
+        } else if constexpr (std::is_integral_v<T>) {
+            if (!is_integer() ||
+                (std::is_unsigned_v<T> && is_negative())) {
+                return false;
+            }
+            const std::string_view s = text();
+            T v;
+            auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+            if (ec != std::errc() || end != s.data() + s.size()) {
+                return false;
+            }
+            out = v;
+            return true;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            if (!is_number()) {
+                return false;
+            }
+            const std::string_view s = text();
+            std::int64_t n;
+            if (is_integer() && s.size() <= 18 &&
+                std::from_chars(s.data(), s.data() + s.size(), n).ec ==
+                    std::errc() &&
+                (n != 0 || !is_negative())) {
+                // converting an int64_t rounds correctly, as strtod would;
+                // -0 has no int64_t form and takes the slow path
+                out = static_cast<T>(n);
+                return true;
+            }
+            double v;
+            if (!to_double(s, v)) {
+                return false;
+            }
+            out = static_cast<T>(v);
+            return true;
+        } else {
+            static_assert(std::is_same_v<T, void>,
+                          "jsmn::value::try_get: unsupported type");
+            return false;
+        }
+    }
+
+    /** @brief Convert the token to T, or return fallback if it can't be. */
+    template <typename T> T get(T fallback = T()) const noexcept {
+        T out = fallback;
+        try_get(out);
+        return out;
+    }
+
+  private:
+    static bool to_double(std::string_view s, double &out) noexcept {
+        // Input text need not be NUL terminated after the token, so strtod
+        // works on a bounded local copy.
+        char buf[128];
+        if (s.empty() || s.size() >= sizeof(buf)) {
+            return false;
+        }
+        std::memcpy(buf, s.data(), s.size());
+        buf[s.size()] = '\0';
+        char *end;
+        out = std::strtod(buf, &end);
+        return end == buf + s.size();
+    }
+
+    const jsmn_token_t *tokens_ = nullptr;
+    int count_ = 0;
+    int index_ = -1;
+};
+
+/** @brief Forward iterator over the elements of an array. */
+class array_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = value;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value;
+
+    constexpr array_iterator(const jsmn_token_t *tokens, int count,
+                             int index) noexcept
+        : tokens_(tokens), count_(count), index_(index) {}
+
+    value operator*() const noexcept { return value(tokens_, count_, index_); }
+    array_iterator &operator++() noexcept {
+        index_ = tokens_[index_].end_index;
+        return *this;
+    }
+    array_iterator operator++(int) noexcept {
+        array_iterator prev = *this;
+        ++*this;
+        return prev;
+    }
+    bool operator==(const array_iterator &o) const noexcept {
+        return index_ == o.index_;
+    }
+    bool operator!=(const array_iterator &o) const noexcept {
+        return index_ != o.index_;
+    }
+
+  private:
+    const jsmn_token_t *tokens_;
+    int count_;
+    int index_;
+};
+
+/** @brief One key/value pair of an object. */
+struct member {
+    value name; // the key, a string token
+    value val;  // the value; invalid if the key has none
+};
+
+/** @brief Forward iterator over the members of an object. */
+class object_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = member;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = member;
+
+    constexpr object_iterator(const jsmn_token_t *tokens, int count,
+                              int index) noexcept
+        : tokens_(tokens), count_(count), index_(index) {}
+
+    member operator*() const noexcept {
+        return member{value(tokens_, count_, index_),
+                      tokens_[index_].child_count > 0
+                          ? value(tokens_, count_, index_ + 1)
+                          : value()};
+    }
+    object_iterator &operator++() noexcept {
+        index_ = tokens_[index_].child_count > 0
+                     ? tokens_[index_ + 1].end_index
+                     : index_ + 1;
+        return *this;
+    }
+    object_iterator operator++(int) noexcept {
+        object_iterator prev = *this;
+        ++*this;
+        return prev;
+    }
+    bool operator==(const object_iterator &o) const noexcept {
+        return index_ == o.index_;
+    }
+    bool operator!=(const object_iterator &o) const noexcept {
+        return index_ != o.index_;
+    }
+
+  private:
+    const jsmn_token_t *tokens_;
+    int count_;
+    int index_;
+};
+
+class array_range {
+  public:
+    constexpr array_range(const jsmn_token_t *tokens, int count, int first,
+                          int last) noexcept
+        : tokens_(tokens), count_(count), first_(first), last_(last) {}
+
+    array_iterator begin() const noexcept {
+        return array_iterator(tokens_, count_, first_);
+    }
+    array_iterator end() const noexcept {
+        return array_iterator(tokens_, count_, last_);
+    }
+    bool empty() const noexcept { return first_ == last_; }
+
+  private:
+    const jsmn_token_t *tokens_;
+    int count_;
+    int first_;
+    int last_;
+};
+
+class object_range {
+  public:
+    constexpr object_range(const jsmn_token_t *tokens, int count, int first,
+                           int last) noexcept
+        : tokens_(tokens), count_(count), first_(first), last_(last) {}
+
+    object_iterator begin() const noexcept {
+        return object_iterator(tokens_, count_, first_);
+    }
+    object_iterator end() const noexcept {
+        return object_iterator(tokens_, count_, last_);
+    }
+    bool empty() const noexcept { return first_ == last_; }
+
+  private:
+    const jsmn_token_t *tokens_;
+    int count_;
+    int first_;
+    int last_;
+};
+
+inline array_range value::elements() const noexcept {
+    if (!is_array()) {
+        return array_range(tokens_, count_, 0, 0);
+    }
+    return array_range(tokens_, count_, index_ + 1, token().end_index);
+}
+
+inline object_range value::members() const noexcept {
+    if (!is_object()) {
+        return object_range(tokens_, count_, 0, 0);
+    }
+    return object_range(tokens_, count_, index_ + 1, token().end_index);
+}
+
+/**
+ * @brief A parser together with storage for N tokens.  The document must
+ * outlive the values taken from it, and the parsed text must outlive both.
+ */
+template <unsigned int N> class document {
+  public:
+    document() noexcept { jsmn_init(&parser_, tokens_, N); }
+    document(const document &) = delete;
+    document &operator=(const document &) = delete;
+
+    /** @brief Parse js, replacing any previous contents.  See jsmn_parse(). */
+    int parse(std::string_view js) noexcept {
+        return jsmn_parse(&parser_, js.data(), js.size());
+    }
+
+    /** @brief The first top-level value, invalid if nothing was parsed. */
+    value root() const noexcept { return value(parser_, 0); }
+
+    jsmn_parser_t &parser() noexcept { return parser_; }
+    const jsmn_parser_t &parser() const noexcept { return parser_; }
+
+  private:
+    jsmn_token_t tokens_[N];
+    jsmn_parser_t parser_;
+};
+
+namespace detail {
+
+// Byte positions a binding hash may sample: 0..7 from the front, 8..15 from
+// the end.  Mirrors jsmn_bind.c.
+constexpr unsigned int bind_positions = 16;
+constexpr unsigned int bind_seeds = 32;
+
+constexpr std::uint32_t bind_sample(std::string_view s,
+                                    unsigned int pos) noexcept {
+    const std::size_t len = s.size();
+    if (len == 0) {
+        return 0;
+    }
+    if (pos < bind_positions / 2) {
+        return static_cast<unsigned char>(s[pos < len ? pos : len - 1]);
+    }
+    const std::size_t back = pos - bind_positions / 2;
+    return static_cast<unsigned char>(s[back < len ? len - 1 - back : 0]);
+}
+
+constexpr unsigned int bind_hash(std::string_view s, std::uint32_t seed,
+                                 unsigned int a, unsigned int b,
+                                 unsigned int mask) noexcept {
+    std::uint32_t h = 2166136261u ^ seed;
+    h = (h ^ static_cast<std::uint32_t>(s.size())) * 16777619u;
+    h = (h ^ bind_sample(s, a)) * 16777619u;
+    h = (h ^ bind_sample(s, b)) * 16777619u;
+    return (h ^ (h >> 15)) & mask;
+}
+
+// Deliberately not constexpr: a constexpr binding whose names have no
+// perfect hash fails to compile at the call below.
+inline void no_perfect_hash() noexcept {}
+
+} // namespace detail
+
+/** @brief A JSON member name bound to a struct member. */
+template <typename S, typename M> struct field_t {
+    std::string_view name;
+    M S::*member;
+};
+
+/** @brief Bind JSON member `name` to struct member `member`. */
+template <typename S, typename M>
+constexpr field_t<S, M> field(std::string_view name, M S::*member) noexcept {
+    return field_t<S, M>{name, member};
+}
+
+/**
+ * @brief Decoder from a JSON object into struct S, built from a list of
+ * fields.  Declared constexpr, the perfect hash over the field names is
+ * found at compile time; decoding then hashes each document key from its
+ * length and two sampled bytes, confirms the one candidate field, and
+ * converts the value straight into the struct with value::try_get().
+ *
+ *     struct point { int x; double y; std::string_view tag; };
+ *     constexpr auto point_binding = jsmn::make_binding(
+ *         jsmn::field("x", &point::x), jsmn::field("y", &point::y),
+ *         jsmn::field("tag", &point::tag));
+ *     point p{};
+ *     point_binding.decode(doc.root(), p);
+ */
+template <typename S, typename... M> class binding {
+  public:
+    static constexpr std::size_t num_fields = sizeof...(M);
+    static_assert(num_fields <= JSMN_BIND_MAX_SLOTS / 2,
+                  "jsmn::binding: too many fields");
+
+    constexpr binding(field_t<S, M>... fields) noexcept
+        : fields_(fields...), names_{{fields.name...}}, slots_{} {
+        for (unsigned int size = 1; size <= JSMN_BIND_MAX_SLOTS; size *= 2) {
+            if (size < num_fields) {
+                continue;
+            }
+            for (unsigned int a = 0; a < detail::bind_positions; a++) {
+                for (unsigned int b = a; b < detail::bind_positions; b++) {
+                    for (std::uint32_t seed = 0; seed < detail::bind_seeds;
+                         seed++) {
+                        if (try_hash(seed, a, b, size - 1)) {
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+        detail::no_perfect_hash();
+    }
+
+    /** @brief False if no perfect hash was found for the field names. */
+    constexpr bool ok() const noexcept { return ok_; }
+
+    /**
+     * @brief Decode object obj into out in one pass over its members.
+     * Unknown and null members are ignored.  Returns the number of fields
+     * stored, JSMN_BIND_ERROR_INVAL if obj is not an object, or
+     * JSMN_BIND_ERROR_TYPE if a value does not convert to its field.
+     */
+    int decode(value obj, S &out) const noexcept {
+        if (!ok_ || !obj.is_object()) {
+            return JSMN_BIND_ERROR_INVAL;
+        }
+        int stored = 0;
+        for (auto [name, val] : obj.members()) {
+            const std::string_view k = name.text();
+            const unsigned int slot =
+                slots_[detail::bind_hash(k, seed_, pos_a_, pos_b_, mask_)];
+            if (slot == 0 || names_[slot - 1] != k || !val || val.is_null()) {
+                continue;
+            }
+            if (!assign(slot - 1, val, out,
+                        std::index_sequence_for<M...>())) {
+                return JSMN_BIND_ERROR_TYPE;
+            }
+            stored++;
+        }
+        return stored;
+    }
+
+  private:
+    constexpr bool try_hash(std::uint32_t seed, unsigned int a, unsigned int b,
+                            unsigned int mask) noexcept {
+        for (auto &slot : slots_) {
+            slot = 0;
+        }
+        for (std::size_t i = 0; i < num_fields; i++) {
+            const unsigned int h = detail::bind_hash(names_[i], seed, a, b, mask);
+            if (slots_[h] != 0) {
+                return false;
+            }
+            slots_[h] = static_cast<unsigned char>(i + 1);
+        }
+        seed_ = seed;
+        pos_a_ = a;
+        pos_b_ = b;
+        mask_ = mask;
+        ok_ = true;
+        return true;
+    }
+
+    // Convert v into the member of field i; the fold dispatches on an
+    // integer index, never on names.
+    template <std::size_t... I>
+    bool assign(std::size_t i, value v, S &out,
+                std::index_sequence<I...>) const noexcept {
+        bool converted = false;
+        (void)((i == I
+                    ? (converted = v.try_get(out.*(std::get<I>(fields_).member)),
+                       true)
+                    : false) ||
+               ...);
+        return converted;
+    }
+
+    std::tuple<field_t<S, M>...> fields_;
+    std::array<std::string_view, num_fields> names_;
+    std::array<unsigned char, JSMN_BIND_MAX_SLOTS> slots_;
+    std::uint32_t seed_ = 0;
+    unsigned int pos_a_ = 0;
+    unsigned int pos_b_ = 0;
+    unsigned int mask_ = 0;
+    bool ok_ = false;
+};
+
+/** @brief Deduce a binding's struct and member types from its fields. */
+template <typename S, typename... M>
+constexpr binding<S, M...> make_binding(field_t<S, M>... fields) noexcept {
+    return binding<S, M...>(fields...);
+}
+
+} // namespace jsmn
+
+#endif /* JSMN_HPP */
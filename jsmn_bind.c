@@ -0,0 +1,354 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_bind.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/* Byte positions a hash may sample: 0..7 from the front, 8..15 from the end */
+#define NUM_POSITIONS 16
+
+/* Seeds tried for each table size and pair of positions */
+#define NUM_SEEDS 32
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Return the byte of s (len bytes) selected by position pos, or 0 if s is
+ * empty.  Positions past either end clamp to the last / first byte.
+ */
+static unsigned int sample(const char *s, unsigned int len, unsigned int pos);
+
+/**
+ * Hash a member name to its slot in the binding's table.
+ */
+static unsigned int bind_hash(const jsmn_binding_t *binding, const char *s,
+                              unsigned int len);
+
+/**
+ * Fill in the binding's slots under its current hash parameters.  Return
+ * false if two fields collide.
+ */
+static bool try_hash(jsmn_binding_t *binding);
+
+/**
+ * Convert the value at token index v into the field at dst.  Return the
+ * number of fields stored or a jsmn_bind_err_t.
+ */
+static int store(const jsmn_bind_field_t *field, jsmn_parser_t *parser, int v,
+                 void *dst);
+
+/**
+ * Parse an integer-class token as a sign and magnitude.  Return false for
+ * other tokens and on overflow.
+ */
+static bool parse_int(jsmn_token_t *token, bool *negative, uint64_t *mag);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_bind_init(jsmn_binding_t *binding, const jsmn_bind_field_t *fields,
+                   unsigned int num_fields) {
+    if (num_fields > JSMN_BIND_MAX_SLOTS / 2) {
+        return JSMN_BIND_ERROR_INVAL;
+    }
+    for (unsigned int i = 0; i < num_fields; i++) {
+        for (unsigned int j = i + 1; j < num_fields; j++) {
+            if (strcmp(fields[i].name, fields[j].name) == 0) {
+                return JSMN_BIND_ERROR_INVAL;
+            }
+        }
+    }
+    binding->fields = fields;
+    binding->num_fields = num_fields;
+    unsigned int size = 1;
+    while (size < num_fields) {
+        size *= 2;
+    }
+    // prefer the smallest table, then the earliest positions and seed
+    for (; size <= JSMN_BIND_MAX_SLOTS; size *= 2) {
+        binding->mask = size - 1;
+        for (unsigned int a = 0; a < NUM_POSITIONS; a++) {
+            for (unsigned int b = a; b < NUM_POSITIONS; b++) {
+                for (unsigned int seed = 0; seed < NUM_SEEDS; seed++) {
+                    binding->pos_a = (unsigned char)a;
+                    binding->pos_b = (unsigned char)b;
+                    binding->seed = seed;
+                    if (try_hash(binding)) {
+                        return 0;
+                    }
+                }
+            }
+        }
+    }
+    binding->fields = NULL;
+    return JSMN_BIND_ERROR_HASH;
+}
+
+int jsmn_bind_decode(const jsmn_binding_t *binding, jsmn_parser_t *parser,
+                     int token_index, void *out) {
+    jsmn_token_t *obj = jsmn_token_ref(parser, token_index);
+    if (binding == NULL || binding->fields == NULL || obj == NULL ||
+        obj->type != JSMN_OBJECT) {
+        return JSMN_BIND_ERROR_INVAL;
+    }
+    int stored = 0;
+    int i = token_index + 1;
+    while (i < obj->end_index) {
+        jsmn_token_t *key = &parser->tokens[i];
+        if (key->child_count == 0) {
+            // a key without a value (lenient builds only)
+            i += 1;
+            continue;
+        }
+        int v = i + 1;
+        i = parser->tokens[v].end_index;
+        unsigned int len = (unsigned int)key->strlen;
+        unsigned int slot = binding->slots[bind_hash(binding, key->start, len)];
+        if (slot == 0) {
+            continue;
+        }
+        const jsmn_bind_field_t *field = &binding->fields[slot - 1];
+        if (strncmp(field->name, key->start, len) != 0 ||
+            field->name[len] != '\0') {
+            continue;
+        }
+        int r = store(field, parser, v, (char *)out + field->offset);
+        if (r < 0) {
+            return r;
+        }
+        stored += r;
+    }
+    return stored;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static unsigned int sample(const char *s, unsigned int len, unsigned int pos) {
+    if (len == 0) {
+        return 0;
+    }
+    unsigned int i;
+    if (pos < NUM_POSITIONS / 2) {
+        i = pos < len ? pos : len - 1;
+    } else {
+        unsigned int back = pos - NUM_POSITIONS / 2;
+        i = back < len ? len - 1 - back : 0;
+    }
+    return (unsigned char)s[i];
+}
+
+static unsigned int bind_hash(const jsmn_binding_t *binding, const char *s,
+                              unsigned int len) {
+    // FNV-1a over the length and two sampled bytes
+    uint32_t h = 2166136261u ^ binding->seed;
+    h = (h ^ len) * 16777619u;
+    h = (h ^ sample(s, len, binding->pos_a)) * 16777619u;
+    h = (h ^ sample(s, len, binding->pos_b)) * 16777619u;
+    return (h ^ (h >> 15)) & binding->mask;
+}
+
+static bool try_hash(jsmn_binding_t *binding) {
+    memset(binding->slots, 0, sizeof(binding->slots));
+    for (unsigned int i = 0; i < binding->num_fields; i++) {
+        const char *name = binding->fields[i].name;
+        unsigned int slot = bind_hash(binding, name, strlen(name));
+        if (binding->slots[slot] != 0) {
+            return false;
+        }
+        binding->slots[slot] = (unsigned char)(i + 1);
+    }
+    return true;
+}
+
+static int store(const jsmn_bind_field_t *field, jsmn_parser_t *parser, int v,
+                 void *dst) {
+    jsmn_token_t *token = &parser->tokens[v];
+    if (field->type == JSMN_BIND_TOKEN) {
+        if (field->size != sizeof(int)) {
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        *(int *)dst = v;
+        return 1;
+    }
+    if (jsmn_token_is_null(token)) {
+        return 0;
+    }
+    switch (field->type) {
+    case JSMN_BIND_BOOL:
+        if (!jsmn_token_is_boolean(token) || field->size != sizeof(bool)) {
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        *(bool *)dst = jsmn_token_is_true(token);
+        return 1;
+    case JSMN_BIND_INT: {
+        bool negative;
+        uint64_t mag;
+        if (!parse_int(token, &negative, &mag)) {
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        // the most negative value of a w-bit field has magnitude 2^(w-1)
+        unsigned int bits = (unsigned int)field->size * 8;
+        if (bits == 0 || bits > 64 ||
+            mag > ((uint64_t)1 << (bits - 1)) - (negative ? 0 : 1)) {
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        int64_t n = negative ? (int64_t)(0 - mag) : (int64_t)mag;
+        switch (field->size) {
+        case 1:
+            *(int8_t *)dst = (int8_t)n;
+            break;
+        case 2:
+            *(int16_t *)dst = (int16_t)n;
+            break;
+        case 4:
+            *(int32_t *)dst = (int32_t)n;
+            break;
+        case 8:
+            *(int64_t *)dst = n;
+            break;
+        default:
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        return 1;
+    }
+    case JSMN_BIND_UINT: {
+        bool negative;
+        uint64_t mag;
+        if (!parse_int(token, &negative, &mag) || (negative && mag != 0)) {
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        switch (field->size) {
+        case 1:
+            if (mag > UINT8_MAX) {
+                return JSMN_BIND_ERROR_TYPE;
+            }
+            *(uint8_t *)dst = (uint8_t)mag;
+            break;
+        case 2:
+            if (mag > UINT16_MAX) {
+                return JSMN_BIND_ERROR_TYPE;
+            }
+            *(uint16_t *)dst = (uint16_t)mag;
+            break;
+        case 4:
+            if (mag > UINT32_MAX) {
+                return JSMN_BIND_ERROR_TYPE;
+            }
+            *(uint32_t *)dst = (uint32_t)mag;
+            break;
+        case 8:
+            *(uint64_t *)dst = mag;
+            break;
+        default:
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        return 1;
+    }
+    case JSMN_BIND_DOUBLE: {
+        bool negative;
+        uint64_t mag;
+        double d;
+        if (!jsmn_token_is_number(token)) {
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        if (parse_int(token, &negative, &mag)) {
+            // integers skip strtod; converting one rounds the same way
+            d = negative ? -(double)mag : (double)mag;
+        } else {
+            // the token need not be followed by a NUL, so strtod works on
+            // a bounded copy
+            char buf[128];
+            if ((size_t)token->strlen >= sizeof(buf)) {
+                return JSMN_BIND_ERROR_TYPE;
+            }
+            memcpy(buf, token->start, token->strlen);
+            buf[token->strlen] = '\0';
+            char *end;
+            d = strtod(buf, &end);
+            if (end != buf + token->strlen) {
+                return JSMN_BIND_ERROR_TYPE;
+            }
+        }
+        if (field->size == sizeof(double)) {
+            *(double *)dst = d;
+        } else if (field->size == sizeof(float)) {
+            *(float *)dst = (float)d;
+        } else {
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        return 1;
+    }
+    case JSMN_BIND_STRING:
+        if (token->type != JSMN_STRING) {
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        if ((size_t)token->strlen >= field->size) {
+            return JSMN_BIND_ERROR_NOMEM;
+        }
+        memcpy(dst, token->start, token->strlen);
+        ((char *)dst)[token->strlen] = '\0';
+        return 1;
+    case JSMN_BIND_OBJECT:
+        if (token->type != JSMN_OBJECT) {
+            return JSMN_BIND_ERROR_TYPE;
+        }
+        return jsmn_bind_decode(field->binding, parser, v, dst);
+    default:
+        return JSMN_BIND_ERROR_INVAL;
+    }
+}
+
+static bool parse_int(jsmn_token_t *token, bool *negative, uint64_t *mag) {
+    const char *p = token->start;
+    const char *end = p + token->strlen;
+    if (!jsmn_token_is_integer(token)) {
+        // floats are rejected by class, without looking at the text
+        return false;
+    }
+    *negative = (*p == '-');
+    if (*negative) {
+        p++;
+    }
+    if (p == end) {
+        return false;
+    }
+    uint64_t n = 0;
+    for (; p < end; p++) {
+        unsigned int d = (unsigned int)(*p - '0');
+        if (d > 9 || n > (UINT64_MAX - d) / 10) {
+            return false;
+        }
+        n = n * 10 + d;
+    }
+    *mag = n;
+    return true;
+}
@@ -0,0 +1,141 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_BIND_H
+#define JSMN_BIND_H
+
+#include "jsmn.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Largest hash table a binding may use, and so the most fields it can
+ * describe.
+ */
+#define JSMN_BIND_MAX_SLOTS 256
+
+typedef enum {
+  /* Token is not an object, or the binding is not initialized */
+  JSMN_BIND_ERROR_INVAL = -1,
+  /* A bound value has the wrong JSON type or does not fit its field */
+  JSMN_BIND_ERROR_TYPE = -2,
+  /* A bound string is longer than its char array */
+  JSMN_BIND_ERROR_NOMEM = -3,
+  /* No perfect hash exists for the field names (see jsmn_bind_init) */
+  JSMN_BIND_ERROR_HASH = -4
+} jsmn_bind_err_t;
+
+/**
+ * How a JSON value is stored into a struct field.
+ */
+typedef enum {
+  JSMN_BIND_BOOL,   // true/false into a bool
+  JSMN_BIND_INT,    // integer into a signed integer of any width
+  JSMN_BIND_UINT,   // non-negative integer into an unsigned integer
+  JSMN_BIND_DOUBLE, // any number into a float or double
+  JSMN_BIND_STRING, // string contents (escapes as written) into a char array
+  JSMN_BIND_TOKEN,  // index of the value's token into an int
+  JSMN_BIND_OBJECT  // object decoded into a nested struct by another binding
+} jsmn_bind_type_t;
+
+struct jsmn_binding;
+
+/**
+ * One JSON member bound to one struct field.  Build these with the
+ * JSMN_BIND_FIELD() family of macros.
+ */
+typedef struct {
+  const char *name;                   // JSON member name
+  jsmn_bind_type_t type;              // conversion to apply
+  size_t offset;                      // offset of the field in the struct
+  size_t size;                        // size of the field in bytes
+  const struct jsmn_binding *binding; // for JSMN_BIND_OBJECT, else NULL
+} jsmn_bind_field_t;
+
+/**
+ * @brief Describe struct member `member` of `type`, matched by a JSON member
+ * of the same name.
+ */
+#define JSMN_BIND_FIELD(type, member, kind)                                    \
+  JSMN_BIND_NAMED(#member, type, member, kind)
+
+/**
+ * @brief Describe struct member `member` of `type`, matched by the JSON
+ * member `name`.
+ */
+#define JSMN_BIND_NAMED(name, type, member, kind)                              \
+  { (name), (kind), offsetof(type, member), sizeof(((type *)0)->member), NULL }
+
+/**
+ * @brief Describe struct member `member` of `type`, itself a struct decoded
+ * by the binding pointed to by `nested`.
+ */
+#define JSMN_BIND_NESTED(type, member, nested)                                 \
+  {                                                                            \
+    #member, JSMN_BIND_OBJECT, offsetof(type, member),                         \
+        sizeof(((type *)0)->member), (nested)                                  \
+  }
+
+/**
+ * A field table together with a perfect hash over its names.  Each key in
+ * the document is hashed from its length and two of its bytes, which
+ * selects the only field it can match; one comparison then confirms it.
+ */
+typedef struct jsmn_binding {
+  const jsmn_bind_field_t *fields;           // the field table
+  unsigned int num_fields;                   // entries in fields
+  unsigned int seed;                         // hash seed
+  unsigned int mask;                         // table size - 1
+  unsigned char pos_a;                       // first byte sampled
+  unsigned char pos_b;                       // second byte sampled
+  unsigned char slots[JSMN_BIND_MAX_SLOTS];  // field index + 1, or 0
+} jsmn_binding_t;
+
+/**
+ * @brief Prepare a binding over a table of num_fields fields, searching for
+ * a hash that sends every field name to its own slot.  The table must
+ * outlive the binding.  Returns 0, JSMN_BIND_ERROR_INVAL if there are too
+ * many fields or two share a name, or JSMN_BIND_ERROR_HASH if no perfect
+ * hash was found.
+ */
+int jsmn_bind_init(jsmn_binding_t *binding, const jsmn_bind_field_t *fields,
+                   unsigned int num_fields);
+
+/**
+ * @brief Decode the object at token_index into the struct at out in one
+ * pass over its members.  Members without a field are ignored, as are
+ * null members of any field type but JSMN_BIND_TOKEN, and fields without
+ * a member are left untouched.  Returns the number of fields
+ * stored, counting those of nested structs, or a jsmn_bind_err_t.
+ */
+int jsmn_bind_decode(const jsmn_binding_t *binding, jsmn_parser_t *parser,
+                     int token_index, void *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_BIND_H */
@@ -0,0 +1,276 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_cache.h"
+#include "jsmn_tape.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/**
+ * One cached result, allocated as a single block: this header, then the
+ * result as a tape (see jsmn_tape.h), then a copy of the input it came from.
+ * The tape's offsets make the tokens relocatable to any copy of the input.
+ */
+struct jsmn_cache_entry {
+    struct jsmn_cache_entry *next;  // next entry in the same hash chain
+    struct jsmn_cache_entry *newer; // LRU neighbour, or NULL if newest
+    struct jsmn_cache_entry *older; // LRU neighbour, or NULL if oldest
+    uint64_t hash;                  // jsmn_tape_checksum() of the input
+    size_t len;                     // length of the input
+    size_t tape_size;               // bytes of tape following this header
+    size_t size;                    // size of the whole block
+};
+
+typedef struct jsmn_cache_entry entry_t;
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Return the entry holding the len bytes at js, or NULL.
+ */
+static entry_t *find_entry(jsmn_cache_t *cache, uint64_t hash, const char *js,
+                           size_t len);
+
+/**
+ * Cache the tokens parser just produced from js.  Quietly gives up if the
+ * result is too large for the cache or memory runs out.
+ */
+static void insert_entry(jsmn_cache_t *cache, const jsmn_parser_t *parser,
+                         uint64_t hash, const char *js, size_t len);
+
+/**
+ * Unlink entry from its hash chain and the LRU list, and free it.
+ */
+static void remove_entry(jsmn_cache_t *cache, entry_t *entry);
+
+/**
+ * Unlink entry from the LRU list.
+ */
+static void lru_unlink(jsmn_cache_t *cache, entry_t *entry);
+
+/**
+ * Link entry in as the newest in the LRU list.
+ */
+static void lru_push(jsmn_cache_t *cache, entry_t *entry);
+
+/**
+ * Give the object keys among the parser's tokens their symbol IDs, as the
+ * parser would have.
+ */
+static void intern_keys(jsmn_parser_t *parser);
+
+/**
+ * Return the tape of an entry.
+ */
+static void *entry_tape(entry_t *entry);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_cache_init(jsmn_cache_t *cache, jsmn_parse_fn parse,
+                    unsigned int max_entries, size_t max_bytes) {
+    unsigned int num_buckets = 1;
+
+    if (max_entries == 0) {
+        return JSMN_CACHE_ERROR_INVAL;
+    }
+    while (num_buckets < max_entries && num_buckets <= UINT32_MAX / 2) {
+        num_buckets *= 2;
+    }
+    memset(cache, 0, sizeof(*cache));
+    cache->buckets = (entry_t **)calloc(num_buckets, sizeof(entry_t *));
+    if (cache->buckets == NULL) {
+        return JSMN_CACHE_ERROR_NOMEM;
+    }
+    cache->parse = parse;
+    cache->mask = num_buckets - 1;
+    cache->max_entries = max_entries;
+    cache->max_bytes = max_bytes;
+    return 0;
+}
+
+int jsmn_cache_parse(jsmn_cache_t *cache, jsmn_parser_t *parser,
+                     const char *js, const size_t len) {
+    uint64_t hash = jsmn_tape_checksum(js, len);
+    entry_t *entry;
+    int r;
+
+    if (parser->keyset != NULL) {
+        // a hit may come from a parse that did not check for duplicates
+        r = cache->parse(parser, js, len);
+        if (r >= 0 && parser->tokens != NULL) {
+            insert_entry(cache, parser, hash, js, len);
+        }
+        return r;
+    }
+    cache->stats.lookups++;
+    if (parser->tokens != NULL &&
+        (entry = find_entry(cache, hash, js, len)) != NULL) {
+        jsmn_tape_t tape;
+        cache->stats.hits++;
+        lru_unlink(cache, entry);
+        lru_push(cache, entry);
+        jsmn_tape_open(&tape, entry_tape(entry), entry->tape_size, js, len,
+                       false);
+        r = jsmn_tape_load(&tape, parser);
+        if (r < 0) {
+            return r == JSMN_TAPE_ERROR_NOMEM ? JSMN_ERROR_NOMEM
+                                              : JSMN_ERROR_INVAL;
+        }
+        if (parser->symtab != NULL) {
+            intern_keys(parser);
+        }
+        return r;
+    }
+
+    r = cache->parse(parser, js, len);
+    if (r >= 0 && parser->tokens != NULL) {
+        insert_entry(cache, parser, hash, js, len);
+    }
+    return r;
+}
+
+void jsmn_cache_clear(jsmn_cache_t *cache) {
+    while (cache->oldest != NULL) {
+        remove_entry(cache, cache->oldest);
+    }
+}
+
+void jsmn_cache_free(jsmn_cache_t *cache) {
+    jsmn_cache_clear(cache);
+    free(cache->buckets);
+    cache->buckets = NULL;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static entry_t *find_entry(jsmn_cache_t *cache, uint64_t hash, const char *js,
+                           size_t len) {
+    entry_t *entry = cache->buckets[hash & cache->mask];
+    for (; entry != NULL; entry = entry->next) {
+        if (entry->hash == hash && entry->len == len &&
+            memcmp((char *)entry_tape(entry) + entry->tape_size, js, len) ==
+                0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void insert_entry(jsmn_cache_t *cache, const jsmn_parser_t *parser,
+                         uint64_t hash, const char *js, size_t len) {
+    size_t tape_size = jsmn_tape_size((int)parser->token_count);
+    size_t size = sizeof(entry_t) + tape_size + len;
+    entry_t *entry;
+
+    if (cache->max_bytes != 0 && size > cache->max_bytes) {
+        return;
+    }
+    while (cache->oldest != NULL &&
+           (cache->stats.entries >= cache->max_entries ||
+            (cache->max_bytes != 0 &&
+             cache->stats.bytes + size > cache->max_bytes))) {
+        remove_entry(cache, cache->oldest);
+        cache->stats.evictions++;
+    }
+    entry = (entry_t *)malloc(size);
+    if (entry == NULL) {
+        return;
+    }
+    if (jsmn_tape_write(parser, js, len, entry_tape(entry), tape_size) != 0) {
+        free(entry);
+        return;
+    }
+    memcpy((char *)entry_tape(entry) + tape_size, js, len);
+    entry->hash = hash;
+    entry->len = len;
+    entry->tape_size = tape_size;
+    entry->size = size;
+    entry->next = cache->buckets[hash & cache->mask];
+    cache->buckets[hash & cache->mask] = entry;
+    lru_push(cache, entry);
+    cache->stats.inserts++;
+    cache->stats.entries++;
+    cache->stats.bytes += size;
+}
+
+static void remove_entry(jsmn_cache_t *cache, entry_t *entry) {
+    entry_t **link = &cache->buckets[entry->hash & cache->mask];
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    lru_unlink(cache, entry);
+    cache->stats.entries--;
+    cache->stats.bytes -= entry->size;
+    free(entry);
+}
+
+static void lru_unlink(jsmn_cache_t *cache, entry_t *entry) {
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+}
+
+static void lru_push(jsmn_cache_t *cache, entry_t *entry) {
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest != NULL) {
+        cache->newest->newer = entry;
+    } else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+static void intern_keys(jsmn_parser_t *parser) {
+    jsmn_symtab_reset(parser->symtab);
+    for (unsigned int i = 0; i < parser->token_count; i++) {
+        jsmn_token_t *tok = &parser->tokens[i];
+        // a string with a child is a key holding its value
+        if (tok->type == JSMN_STRING && tok->child_count == 1) {
+            tok->symbol = (unsigned short)jsmn_symtab_intern(
+                parser->symtab, tok->start, (size_t)tok->strlen);
+        }
+    }
+}
+
+static void *entry_tape(entry_t *entry) {
+    // the header's size is a multiple of its 8-byte alignment, so the tape
+    // header that follows it is aligned too
+    return entry + 1;
+}
@@ -0,0 +1,109 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_CACHE_H
+#define JSMN_CACHE_H
+
+#include "jsmn.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  /* Out of memory setting up the cache */
+  JSMN_CACHE_ERROR_NOMEM = -1,
+  /* max_entries is zero */
+  JSMN_CACHE_ERROR_INVAL = -2
+} jsmn_cache_err_t;
+
+/**
+ * Counters for tuning a cache's capacity.  The hit rate is hits / lookups.
+ */
+typedef struct {
+  unsigned long lookups;   // calls that looked in the cache
+  unsigned long hits;      // lookups answered from the cache
+  unsigned long inserts;   // parse results added
+  unsigned long evictions; // results dropped to make room
+  unsigned int entries;    // results held now
+  size_t bytes;            // memory held by those results
+} jsmn_cache_stats_t;
+
+struct jsmn_cache_entry;
+
+/**
+ * A bounded LRU cache of parse results, keyed by the content of the input.
+ * Each result holds a copy of its input, so a hit is confirmed byte for byte
+ * and never depends on the hash alone.
+ */
+typedef struct {
+  jsmn_parse_fn parse;              // parser whose results are cached
+  struct jsmn_cache_entry **buckets; // hash chains
+  unsigned int mask;                // number of buckets - 1
+  struct jsmn_cache_entry *newest;  // head of the LRU list
+  struct jsmn_cache_entry *oldest;  // tail of the LRU list
+  unsigned int max_entries;         // capacity in results
+  size_t max_bytes;                 // capacity in bytes, or 0 for no limit
+  jsmn_cache_stats_t stats;         // see jsmn_cache_stats_t
+} jsmn_cache_t;
+
+/**
+ * @brief Set up a cache for the results of parse, holding at most
+ * max_entries results and (if max_bytes is not zero) max_bytes of memory.
+ * Returns 0, JSMN_CACHE_ERROR_INVAL or JSMN_CACHE_ERROR_NOMEM.
+ */
+int jsmn_cache_init(jsmn_cache_t *cache, jsmn_parse_fn parse,
+                    unsigned int max_entries, size_t max_bytes);
+
+/**
+ * @brief Parse js (len bytes) into parser as cache->parse would, reusing
+ * the tokens of an earlier parse of the same bytes if the cache holds one.
+ *
+ * On a hit the cached tokens are relocated to point into js, and keys are
+ * re-interned if parser has a symbol table.  Only complete parses into a
+ * token array are cached, and parser limits are not re-applied to hits, so
+ * use one cache per set of limits.  Hits leave parser->stats untouched.  A
+ * parser with a duplicate key set (jsmn_set_keyset()) always parses, since
+ * a cached parse may not have checked for duplicates; its results are still
+ * cached for other parsers.  Returns what cache->parse returns.
+ */
+int jsmn_cache_parse(jsmn_cache_t *cache, jsmn_parser_t *parser,
+                     const char *js, const size_t len);
+
+/**
+ * @brief Drop every cached result, keeping the counters.
+ */
+void jsmn_cache_clear(jsmn_cache_t *cache);
+
+/**
+ * @brief Drop every cached result and release the cache's memory.
+ */
+void jsmn_cache_free(jsmn_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_CACHE_H */
@@ -0,0 +1,593 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_canon.h"
+#include "jsmn_simd.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/* Longest number text converted to a double */
+#define MAX_NUMBER 511
+
+/* Integers with more digits than this may not fit a double exactly */
+#define MAX_EXACT_DIGITS 15
+
+/* Objects with more members than this are sorted with a heapsort */
+#define INSERTION_SORT_MAX 16
+
+/* One open object or array */
+typedef struct {
+    bool is_object;
+    int base;  // object: index in order of its sorted keys
+    int count; // members or elements
+    int pos;   // members or elements written
+    int next;  // array: token index of the next element
+} frame_t;
+
+/* Key comparisons of one jsmn_canonicalize() call */
+typedef struct {
+    const jsmn_token_t *tokens;
+    bool duplicate; // two keys compared equal
+} sorter_t;
+
+/* A key being read as UTF-16 code units */
+typedef struct {
+    const char *s;
+    int len;
+    int i;            // next byte
+    unsigned int low; // low surrogate still to return, or 0
+} units_t;
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Write a string, number or literal token.  Returns 0, a writer error or
+ * JSMN_WRITER_ERROR_INVAL.
+ */
+static int put_scalar(jsmn_writer_t *writer, jsmn_token_t *token);
+
+/**
+ * Write the len bytes at s, the text of a string token, as a canonical
+ * string.
+ */
+static int put_string(jsmn_writer_t *writer, const char *s, int len);
+
+/**
+ * Write a number token in its ECMAScript form.
+ */
+static int put_number(jsmn_writer_t *writer, jsmn_token_t *token);
+
+/**
+ * Store the canonical form of the escape at s[i] in out and its length in
+ * *n.  Returns the length of the escape, or -1 if it has no canonical form.
+ */
+static int decode_escape(const char *s, int len, int i, char *out, int *n);
+
+/**
+ * Store the canonical escape of character c, which must be a control
+ * character, '"' or '\\', in out.  Returns its length.
+ */
+static int escape_char(char *out, unsigned int c);
+
+/**
+ * Return the value of the four hex digits at p, or -1.
+ */
+static long hex4(const char *p);
+
+/**
+ * Sort the token indices of n keys.  Returns 0, or JSMN_WRITER_ERROR_INVAL
+ * if two keys are equal.
+ */
+static int sort_keys(sorter_t *st, int *keys, int n);
+
+/**
+ * Move keys[root] down the max-heap of the first n keys.
+ */
+static void sift_down(sorter_t *st, int *keys, int root, int n);
+
+/**
+ * Compare the keys at token indices a and b by their UTF-16 code units.
+ * Equal keys are ordered by index, and noted in st.
+ */
+static int compare_keys(sorter_t *st, int a, int b);
+
+/**
+ * Return the next UTF-16 code unit of a key, escapes decoded, or -1 at the
+ * end.
+ */
+static long next_unit(units_t *u);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_canonicalize(jsmn_parser_t *parser, int token_index, int *order,
+                      int order_size, jsmn_writer_t *writer) {
+    frame_t stack[JSMN_WRITER_MAX_DEPTH];
+    sorter_t sorter;
+    jsmn_token_t *tokens = parser->tokens;
+    int count = (int)parser->token_count;
+    int used = 0; // entries of order taken by open objects
+    int depth = 0;
+    int t = token_index;
+    int r;
+
+    sorter.tokens = tokens;
+    sorter.duplicate = false;
+    for (;;) {
+        jsmn_token_t *token;
+        frame_t *frame;
+
+        if (tokens == NULL || t < 0 || t >= count) {
+            // ran off the end of the tokens (partial parse?)
+            return JSMN_WRITER_ERROR_INVAL;
+        }
+        token = &tokens[t];
+        if (token->type == JSMN_OBJECT || token->type == JSMN_ARRAY) {
+            bool is_object = (token->type == JSMN_OBJECT);
+            int n = token->child_count;
+
+            if (n == 0) {
+                if (jsmn_writer_write(writer, is_object ? "{}" : "[]", 2) < 0) {
+                    return writer->error;
+                }
+            } else {
+                if (depth >= JSMN_WRITER_MAX_DEPTH) {
+                    return JSMN_WRITER_ERROR_INVAL;
+                }
+                frame = &stack[depth++];
+                frame->is_object = is_object;
+                frame->count = n;
+                frame->pos = 0;
+                frame->next = t + 1;
+                frame->base = used;
+                if (is_object) {
+                    // gather the keys, then put them in canonical order
+                    int k = t + 1;
+                    if (order_size - used < n) {
+                        return JSMN_WRITER_ERROR_NOMEM;
+                    }
+                    for (int m = 0; m < n; m++) {
+                        if (k >= count - 1 || tokens[k].type != JSMN_STRING ||
+                            tokens[k].child_count != 1) {
+                            return JSMN_WRITER_ERROR_INVAL;
+                        }
+                        order[used + m] = k;
+                        k = tokens[k + 1].end_index;
+                    }
+                    if (sort_keys(&sorter, &order[used], n) < 0) {
+                        return JSMN_WRITER_ERROR_INVAL;
+                    }
+                    used += n;
+                }
+                if (jsmn_writer_write(writer, is_object ? "{" : "[", 1) < 0) {
+                    return writer->error;
+                }
+            }
+        } else if ((r = put_scalar(writer, token)) < 0) {
+            return r;
+        }
+
+        // a value is complete: find the next one, closing finished containers
+        for (;;) {
+            if (depth == 0) {
+                return writer->error;
+            }
+            frame = &stack[depth - 1];
+            if (frame->pos < frame->count) {
+                if (frame->pos > 0 && jsmn_writer_write(writer, ",", 1) < 0) {
+                    return writer->error;
+                }
+                if (frame->is_object) {
+                    int k = order[frame->base + frame->pos];
+                    if ((r = put_string(writer, tokens[k].start,
+                                        tokens[k].strlen)) < 0) {
+                        return r;
+                    }
+                    if (jsmn_writer_write(writer, ":", 1) < 0) {
+                        return writer->error;
+                    }
+                    t = k + 1;
+                } else {
+                    t = frame->next;
+                    if (t >= count) {
+                        return JSMN_WRITER_ERROR_INVAL;
+                    }
+                    frame->next = tokens[t].end_index;
+                }
+                frame->pos++;
+                break;
+            }
+            if (jsmn_writer_write(writer, frame->is_object ? "}" : "]", 1) <
+                0) {
+                return writer->error;
+            }
+            used = frame->base;
+            depth--;
+        }
+    }
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static int put_scalar(jsmn_writer_t *writer, jsmn_token_t *token) {
+    if (token->type == JSMN_STRING) {
+        return put_string(writer, token->start, token->strlen);
+    }
+    switch (jsmn_token_class(token)) {
+    case JSMN_CLASS_INTEGER:
+    case JSMN_CLASS_FLOAT:
+        return put_number(writer, token);
+    case JSMN_CLASS_TRUE:
+        return jsmn_writer_write(writer, "true", 4);
+    case JSMN_CLASS_FALSE:
+        return jsmn_writer_write(writer, "false", 5);
+    case JSMN_CLASS_NULL:
+        return jsmn_writer_write(writer, "null", 4);
+    default:
+        return JSMN_WRITER_ERROR_INVAL;
+    }
+}
+
+static int put_string(jsmn_writer_t *writer, const char *s, int len) {
+    char out[8];
+    int n;
+
+    if (jsmn_writer_write(writer, "\"", 1) < 0) {
+        return writer->error;
+    }
+    for (int i = 0; i < len;) {
+        // copy the run up to the next escape, checking it is valid UTF-8
+        size_t run = jsmn_scan_unescaped(&s[i], (size_t)(len - i));
+        if (jsmn_scan_utf8(&s[i], run) != run) {
+            return JSMN_WRITER_ERROR_INVAL;
+        }
+        if (run > 0 && jsmn_writer_write(writer, &s[i], run) < 0) {
+            return writer->error;
+        }
+        i += (int)run;
+        if (i == len) {
+            break;
+        }
+        if (s[i] == '\\') {
+            int used = decode_escape(s, len, i, out, &n);
+            if (used < 0) {
+                return JSMN_WRITER_ERROR_INVAL;
+            }
+            i += used;
+        } else {
+            // an unescaped control character (lenient parsers only)
+            n = escape_char(out, (unsigned char)s[i++]);
+        }
+        if (jsmn_writer_write(writer, out, (size_t)n) < 0) {
+            return writer->error;
+        }
+    }
+    return jsmn_writer_write(writer, "\"", 1);
+}
+
+static int put_number(jsmn_writer_t *writer, jsmn_token_t *token) {
+    const char *s = token->start;
+    int len = token->strlen;
+    int digits = len - (s[0] == '-');
+    char buf[MAX_NUMBER + 1];
+    double value;
+
+    if (jsmn_token_class(token) == JSMN_CLASS_INTEGER &&
+        digits <= MAX_EXACT_DIGITS && (digits == 1 || s[len - digits] != '0')) {
+        // a double holds it exactly and prints it as written, but for -0
+        if (len == 2 && s[0] == '-' && s[1] == '0') {
+            return jsmn_writer_write(writer, "0", 1);
+        }
+        return jsmn_writer_write(writer, s, (size_t)len);
+    }
+    if (len > MAX_NUMBER) {
+        return JSMN_WRITER_ERROR_INVAL;
+    }
+    memcpy(buf, s, (size_t)len);
+    buf[len] = '\0';
+    value = strtod(buf, NULL);
+    len = jsmn_format_double_shortest(buf, value);
+    if (len == 0) {
+        // out of range: no JSON number reads back as infinity
+        return JSMN_WRITER_ERROR_INVAL;
+    }
+    return jsmn_writer_write(writer, buf, (size_t)len);
+}
+
+static int decode_escape(const char *s, int len, int i, char *out, int *n) {
+    long u;
+    int used = 6;
+
+    if (i + 1 >= len) {
+        return -1;
+    }
+    switch (s[i + 1]) {
+    case '"':
+    case '\\':
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+        // already in canonical form
+        out[0] = '\\';
+        out[1] = s[i + 1];
+        *n = 2;
+        return 2;
+    case '/':
+        out[0] = '/';
+        *n = 1;
+        return 2;
+    case 'u':
+        break;
+    default:
+        return -1;
+    }
+    if (i + 6 > len || (u = hex4(&s[i + 2])) < 0) {
+        return -1;
+    }
+    if (u >= 0xd800 && u <= 0xdbff) {
+        long lo = (i + 12 <= len && s[i + 6] == '\\' && s[i + 7] == 'u')
+                      ? hex4(&s[i + 8])
+                      : -1;
+        if (lo < 0xdc00 || lo > 0xdfff) {
+            return -1;
+        }
+        u = 0x10000 + ((u - 0xd800) << 10) + (lo - 0xdc00);
+        used = 12;
+    } else if (u >= 0xdc00 && u <= 0xdfff) {
+        return -1;
+    }
+    if (u < 0x20 || u == '"' || u == '\\') {
+        *n = escape_char(out, (unsigned int)u);
+    } else if (u < 0x80) {
+        out[0] = (char)u;
+        *n = 1;
+    } else if (u < 0x800) {
+        out[0] = (char)(0xc0 | (u >> 6));
+        out[1] = (char)(0x80 | (u & 0x3f));
+        *n = 2;
+    } else if (u < 0x10000) {
+        out[0] = (char)(0xe0 | (u >> 12));
+        out[1] = (char)(0x80 | ((u >> 6) & 0x3f));
+        out[2] = (char)(0x80 | (u & 0x3f));
+        *n = 3;
+    } else {
+        out[0] = (char)(0xf0 | (u >> 18));
+        out[1] = (char)(0x80 | ((u >> 12) & 0x3f));
+        out[2] = (char)(0x80 | ((u >> 6) & 0x3f));
+        out[3] = (char)(0x80 | (u & 0x3f));
+        *n = 4;
+    }
+    return used;
+}
+
+static int escape_char(char *out, unsigned int c) {
+    static const char hex[] = "0123456789abcdef";
+
+    out[0] = '\\';
+    switch (c) {
+    case '"':
+    case '\\':
+        out[1] = (char)c;
+        return 2;
+    case '\b':
+        out[1] = 'b';
+        return 2;
+    case '\f':
+        out[1] = 'f';
+        return 2;
+    case '\n':
+        out[1] = 'n';
+        return 2;
+    case '\r':
+        out[1] = 'r';
+        return 2;
+    case '\t':
+        out[1] = 't';
+        return 2;
+    default:
+        memcpy(&out[1], "u00", 3);
+        out[4] = hex[c >> 4];
+        out[5] = hex[c & 0xf];
+        return 6;
+    }
+}
+
+static long hex4(const char *p) {
+    long u = 0;
+
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        int d;
+        if (c >= '0' && c <= '9') {
+            d = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            d = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            d = c - 'A' + 10;
+        } else {
+            return -1;
+        }
+        u = (u << 4) | d;
+    }
+    return u;
+}
+
+static int sort_keys(sorter_t *st, int *keys, int n) {
+    bool sorted = true;
+
+    if (n <= INSERTION_SORT_MAX) {
+        for (int i = 1; i < n; i++) {
+            int key = keys[i];
+            int j = i;
+            for (; j > 0 && compare_keys(st, keys[j - 1], key) > 0; j--) {
+                keys[j] = keys[j - 1];
+            }
+            keys[j] = key;
+        }
+    } else {
+        // keys often arrive sorted already, e.g. from a canonical producer
+        for (int i = 1; i < n && sorted; i++) {
+            sorted = compare_keys(st, keys[i - 1], keys[i]) < 0;
+        }
+        if (!sorted) {
+            for (int i = n / 2 - 1; i >= 0; i--) {
+                sift_down(st, keys, i, n);
+            }
+            for (int i = n - 1; i > 0; i--) {
+                int key = keys[0];
+                keys[0] = keys[i];
+                keys[i] = key;
+                sift_down(st, keys, 0, i);
+            }
+        }
+    }
+    // a sort compares every pair of neighbours it leaves, so equal keys
+    // cannot slip through
+    return st->duplicate ? JSMN_WRITER_ERROR_INVAL : 0;
+}
+
+static void sift_down(sorter_t *st, int *keys, int root, int n) {
+    for (;;) {
+        int child = 2 * root + 1;
+        int key;
+        if (child >= n) {
+            return;
+        }
+        if (child + 1 < n &&
+            compare_keys(st, keys[child], keys[child + 1]) < 0) {
+            child++;
+        }
+        if (compare_keys(st, keys[root], keys[child]) >= 0) {
+            return;
+        }
+        key = keys[root];
+        keys[root] = keys[child];
+        keys[child] = key;
+        root = child;
+    }
+}
+
+static int compare_keys(sorter_t *st, int a, int b) {
+    const jsmn_token_t *ka = &st->tokens[a];
+    const jsmn_token_t *kb = &st->tokens[b];
+    int n = (ka->strlen < kb->strlen) ? ka->strlen : kb->strlen;
+    int i = 0;
+    units_t ua;
+    units_t ub;
+
+    // skip the bytes the keys share, backing up to the start of the UTF-8
+    // sequence they differ in; the rest is compared unit by unit
+    while (i < n && ka->start[i] == kb->start[i] && ka->start[i] != '\\') {
+        i++;
+    }
+    while (i > 0 && i < n && ((unsigned char)ka->start[i] & 0xc0) == 0x80) {
+        i--;
+    }
+    ua.s = ka->start;
+    ua.len = ka->strlen;
+    ua.i = i;
+    ua.low = 0;
+    ub.s = kb->start;
+    ub.len = kb->strlen;
+    ub.i = i;
+    ub.low = 0;
+    for (;;) {
+        long ca = next_unit(&ua);
+        long cb = next_unit(&ub);
+        if (ca != cb) {
+            return (ca < cb) ? -1 : 1;
+        }
+        if (ca < 0) {
+            break;
+        }
+    }
+    st->duplicate = true;
+    return (a < b) ? -1 : 1;
+}
+
+static long next_unit(units_t *u) {
+    const unsigned char *s = (const unsigned char *)u->s;
+    unsigned long c;
+    int extra;
+
+    if (u->low != 0) {
+        c = u->low;
+        u->low = 0;
+        return (long)c;
+    }
+    if (u->i >= u->len) {
+        return -1;
+    }
+    c = s[u->i];
+    if (c == '\\' && u->i + 1 < u->len) {
+        long v;
+        c = s[u->i + 1];
+        if (c == 'u' && u->i + 6 <= u->len &&
+            (v = hex4(&u->s[u->i + 2])) >= 0) {
+            u->i += 6;
+            return v;
+        }
+        u->i += 2;
+        switch (c) {
+        case 'b':
+            return '\b';
+        case 'f':
+            return '\f';
+        case 'n':
+            return '\n';
+        case 'r':
+            return '\r';
+        case 't':
+            return '\t';
+        default:
+            return (long)c;
+        }
+    }
+    extra = (c >= 0xf0) ? 3 : (c >= 0xe0) ? 2 : (c >= 0xc0) ? 1 : 0;
+    if (u->i + extra >= u->len) {
+        extra = 0; // cut short: invalid, and rejected when written
+    }
+    if (extra > 0) {
+        c &= 0x3f >> extra;
+    }
+    for (int k = 1; k <= extra; k++) {
+        c = (c << 6) | (s[u->i + k] & 0x3f);
+    }
+    u->i += extra + 1;
+    if (c >= 0x10000) {
+        // a surrogate pair
+        c -= 0x10000;
+        u->low = (unsigned int)(0xdc00 + (c & 0x3ff));
+        return (long)(0xd800 + (c >> 10));
+    }
+    return (long)c;
+}
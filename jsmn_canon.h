@@ -0,0 +1,61 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef JSMN_CANON_H
+#define JSMN_CANON_H
+
+#include "jsmn.h"
+#include "jsmn_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Write the value at token_index in the canonical form of RFC 8785
+ * (JSON Canonicalization Scheme), for hashing and signing: no whitespace,
+ * object members sorted by the UTF-16 code units of their keys, numbers as
+ * ECMAScript writes them (jsmn_format_double_shortest()) and strings with
+ * only the escapes JSON requires.
+ *
+ * Members are sorted as token indices in order (order_size ints), so no
+ * value is copied; order needs room for the members of every object open
+ * at once, which the number of tokens always covers.  Output goes through
+ * writer's buffer in a single pass over the tokens.
+ *
+ * Fails with JSMN_WRITER_ERROR_INVAL for what has no canonical form:
+ * duplicate keys, invalid UTF-8, lone surrogates, numbers out of double
+ * range (or over 511 characters long), bare words from lenient parsers,
+ * and nesting deeper than JSMN_WRITER_MAX_DEPTH; with
+ * JSMN_WRITER_ERROR_NOMEM if order is too small.  Returns 0 or a negative
+ * jsmn_writer_err_t.
+ */
+int jsmn_canonicalize(jsmn_parser_t *parser, int token_index, int *order,
+                      int order_size, jsmn_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_CANON_H */
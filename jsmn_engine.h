@@ -0,0 +1,1017 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * The jsmn parser core, instantiated once per parser variant.  This file has
+ * no include guard: each inclusion defines one parse function, named by
+ * JSMN_ENGINE_NAME, with the same signature and behaviour as jsmn_parse()
+ * but with its policies fixed at compile time.  Variants share the token
+ * and parser layout, so any number of them can be linked into one program
+ * and used on the same jsmn_parser_t.
+ *
+ *     #define JSMN_ENGINE_NAME my_parse_strict
+ *     #define JSMN_ENGINE_STRICT 1
+ *     #include "jsmn_engine.h"
+ *
+ * Policies, each 0 (the default) or 1:
+ *
+ *   JSMN_ENGINE_STRICT        accept only RFC 8259 JSON (see JSMN_STRICT)
+ *   JSMN_ENGINE_PARENT_LINKS  record jsmn_token_t.parent_index and use it to
+ *                             find the enclosing container in constant time
+ *   JSMN_ENGINE_STATS         accumulate jsmn_parser_t.stats
+ *   JSMN_ENGINE_TRUSTED       assume the input is well-formed: skip the
+ *                             character checks on primitives, \uXXXX hex
+ *                             validation and strict-mode key checks.  Valid
+ *                             documents give the same tokens as without it;
+ *                             malformed ones give unspecified (but memory
+ *                             safe) results
+ *   JSMN_ENGINE_PADDED        the caller guarantees js[len] == '\0' with
+ *                             JSMN_PADDING readable bytes from there on, so
+ *                             scanners test only for the NUL sentinel
+ *                             instead of checking the length on every byte,
+ *                             and string text is scanned in whole blocks
+ *                             that may run into the padding
+ *   JSMN_ENGINE_TABLE         drive the scanners from a 256-entry character
+ *                             class table: the main loop dispatches on a
+ *                             handful of classes, primitives are scanned
+ *                             with one table test per byte, and strings run
+ *                             through a small transition table for escapes.
+ *                             Tokens and errors are unchanged
+ *
+ * Every variant passes over string text and runs of whitespace with the
+ * CPU-dispatched kernels of jsmn_simd.h, bounded by NUL and, except for
+ * string text in padded variants, by the length.
+ *
+ * JSMN_ENGINE_API sets the storage class of the parse function; it defaults
+ * to external linkage and may be defined as e.g. `static inline`.  All
+ * policy macros are undefined again at the end of this file.
+ */
+
+#ifndef JSMN_ENGINE_NAME
+#error "define JSMN_ENGINE_NAME before including jsmn_engine.h"
+#endif
+#ifndef JSMN_ENGINE_STRICT
+#define JSMN_ENGINE_STRICT 0
+#endif
+#ifndef JSMN_ENGINE_PARENT_LINKS
+#define JSMN_ENGINE_PARENT_LINKS 0
+#endif
+#ifndef JSMN_ENGINE_STATS
+#define JSMN_ENGINE_STATS 0
+#endif
+#ifndef JSMN_ENGINE_TRUSTED
+#define JSMN_ENGINE_TRUSTED 0
+#endif
+#ifndef JSMN_ENGINE_PADDED
+#define JSMN_ENGINE_PADDED 0
+#endif
+#ifndef JSMN_ENGINE_TABLE
+#define JSMN_ENGINE_TABLE 0
+#endif
+#ifndef JSMN_ENGINE_API
+#define JSMN_ENGINE_API
+#endif
+
+#include "jsmn.h"
+#include "jsmn_simd.h"
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+#ifndef JSMN_ENGINE_FN
+#define JSMN_ENGINE_CAT2(a, b) a##_##b
+#define JSMN_ENGINE_CAT(a, b) JSMN_ENGINE_CAT2(a, b)
+/* Name of a private function of the variant being instantiated */
+#define JSMN_ENGINE_FN(name) JSMN_ENGINE_CAT(JSMN_ENGINE_NAME, name)
+#endif
+
+#if JSMN_ENGINE_TABLE && !defined(JSMN_ENGINE_CHARS)
+/*
+ * Character table shared by JSMN_ENGINE_TABLE variants.  Each entry holds
+ * the class the main loop dispatches on (JSMN_CC_*), flags for the
+ * primitive scanner (JSMN_CF_*) and, in the top bits, the class of the byte
+ * inside a string (JSMN_SC_*).
+ */
+#define JSMN_ENGINE_CHARS jsmn_engine_chars
+
+#define JSMN_CC_OTHER 0     // anything else (a lenient primitive)
+#define JSMN_CC_OPEN 1      // { [
+#define JSMN_CC_CLOSE 2     // } ]
+#define JSMN_CC_QUOTE 3     // "
+#define JSMN_CC_SPACE 4     // tab, CR, LF, space
+#define JSMN_CC_COLON 5     // :
+#define JSMN_CC_COMMA 6     // ,
+#define JSMN_CC_PRIMITIVE 7 // - 0-9 t f n: the start of a strict primitive
+#define JSMN_CC_MASK 0x000f
+
+#define JSMN_CF_END 0x0010      // ends any primitive
+#define JSMN_CF_COLON 0x0020    // ends a lenient primitive
+#define JSMN_CF_FRACTION 0x0040 // . e E
+#define JSMN_CF_BAD 0x0080      // control byte, DEL or non-ASCII
+#define JSMN_CF_NUL 0x0100      // the terminating NUL
+
+#define JSMN_SC_PLAIN 0    // no meaning inside a string
+#define JSMN_SC_QUOTE 1    // "
+#define JSMN_SC_BACKSLASH 2
+#define JSMN_SC_ESCAPE 3   // / n r t: may follow a backslash
+#define JSMN_SC_ESC_HEX 4  // b f: may follow a backslash, and a hex digit
+#define JSMN_SC_U 5        // u
+#define JSMN_SC_HEX 6      // other hex digits
+#define JSMN_SC_NUL 7
+#define JSMN_SC_COUNT 8
+#define JSMN_SC_SHIFT 12
+
+/* States of the string scanner; from JSMN_SS_DONE on it stops */
+#define JSMN_SS_IN 0     // plain text
+#define JSMN_SS_ESCAPE 1 // after a backslash
+#define JSMN_SS_U1 2     // after \u, then U2..U4 as hex digits follow
+#define JSMN_SS_DONE 6   // at the closing quote
+#define JSMN_SS_BAD 7    // at a malformed escape
+#define JSMN_SS_STOP 8   // at the NUL
+
+static const unsigned short jsmn_engine_chars[256] = {
+    0x7180, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0094, 0x0094, 0x0080, 0x0080, 0x0094, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0014, 0x0000, 0x1003, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0016, 0x0007, 0x0040, 0x3000,
+    0x6007, 0x6007, 0x6007, 0x6007, 0x6007, 0x6007, 0x6007, 0x6007,
+    0x6007, 0x6007, 0x0025, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x6000, 0x6000, 0x6000, 0x6000, 0x6040, 0x6000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0001, 0x2000, 0x0012, 0x0000, 0x0000,
+    0x0000, 0x6000, 0x4000, 0x6000, 0x6000, 0x6040, 0x4007, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x3007, 0x0000,
+    0x0000, 0x0000, 0x3000, 0x0000, 0x3007, 0x5000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0001, 0x0000, 0x0012, 0x0000, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080, 0x0080,
+};
+#endif
+
+#define reset_parser JSMN_ENGINE_FN(reset_parser)
+#define parse_json JSMN_ENGINE_FN(parse_json)
+#define jsmn_alloc_token JSMN_ENGINE_FN(alloc_token)
+#define jsmn_fill_token JSMN_ENGINE_FN(fill_token)
+#define jsmn_parse_primitive JSMN_ENGINE_FN(parse_primitive)
+#define jsmn_parse_string JSMN_ENGINE_FN(parse_string)
+#define classify_primitive JSMN_ENGINE_FN(classify_primitive)
+
+#if JSMN_ENGINE_STATS
+#define ENGINE_STAT_ADD(parser, field, n) ((parser)->stats.field += (n))
+#else
+#define ENGINE_STAT_ADD(parser, field, n) ((void)0)
+#endif
+
+/*
+ * Error for a malformed string or primitive that began at start.  Padded
+ * scanners don't stop at max_strlen, so an overlong token reports
+ * JSMN_ERROR_LIMIT ahead of a later syntax error, as bounded ones do.
+ */
+#if JSMN_ENGINE_PADDED
+#define ENGINE_INVAL(parser, start, quotes)                                    \
+    ((parser)->limits.max_strlen != 0 &&                                       \
+             (parser)->pos - (start) - (quotes) > (parser)->limits.max_strlen  \
+         ? JSMN_ERROR_LIMIT                                                    \
+         : JSMN_ERROR_INVAL)
+#else
+#define ENGINE_INVAL(parser, start, quotes) JSMN_ERROR_INVAL
+#endif
+
+/* True while js[pos] is input to scan, with end as the limit */
+#if JSMN_ENGINE_PADDED
+#define ENGINE_MORE(js, pos, end) ((js)[pos] != '\0')
+#else
+#define ENGINE_MORE(js, pos, end) ((pos) < (end) && (js)[pos] != '\0')
+#endif
+
+/* Length of the string text at js[pos] up to a quote, backslash or NUL */
+#if JSMN_ENGINE_PADDED
+#define ENGINE_SCAN_STRING(js, pos, end)                                       \
+    ((void)(end), jsmn_scan_string_padded(&(js)[pos]))
+#else
+#define ENGINE_SCAN_STRING(js, pos, end)                                       \
+    jsmn_scan_string_nul(&(js)[pos], (end) - (pos))
+#endif
+
+/* What the main loop switches on, and its case labels */
+#if JSMN_ENGINE_TABLE
+#define ENGINE_DISPATCH(c)                                                     \
+    (jsmn_engine_chars[(unsigned char)(c)] & JSMN_CC_MASK)
+#define ENGINE_CASE_OPEN case JSMN_CC_OPEN
+#define ENGINE_CASE_CLOSE case JSMN_CC_CLOSE
+#define ENGINE_CASE_QUOTE case JSMN_CC_QUOTE
+#define ENGINE_CASE_SPACE case JSMN_CC_SPACE
+#define ENGINE_CASE_COLON case JSMN_CC_COLON
+#define ENGINE_CASE_COMMA case JSMN_CC_COMMA
+#define ENGINE_CASE_PRIMITIVE case JSMN_CC_PRIMITIVE
+#else
+#define ENGINE_DISPATCH(c) (c)
+#define ENGINE_CASE_OPEN                                                       \
+    case '{':                                                                  \
+    case '['
+#define ENGINE_CASE_CLOSE                                                      \
+    case '}':                                                                  \
+    case ']'
+#define ENGINE_CASE_QUOTE case '\"'
+#define ENGINE_CASE_SPACE                                                      \
+    case '\t':                                                                 \
+    case '\r':                                                                 \
+    case '\n':                                                                 \
+    case ' '
+#define ENGINE_CASE_COLON case ':'
+#define ENGINE_CASE_COMMA case ','
+#define ENGINE_CASE_PRIMITIVE                                                  \
+    case '-':                                                                  \
+    case '0':                                                                  \
+    case '1':                                                                  \
+    case '2':                                                                  \
+    case '3':                                                                  \
+    case '4':                                                                  \
+    case '5':                                                                  \
+    case '6':                                                                  \
+    case '7':                                                                  \
+    case '8':                                                                  \
+    case '9':                                                                  \
+    case 't':                                                                  \
+    case 'f':                                                                  \
+    case 'n'
+#endif
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Reset the parser, free and clear all tokens.
+ */
+static void reset_parser(jsmn_parser_t *parser);
+
+/**
+ * Parse JSON string and fill tokens.  Does the work of JSMN_ENGINE_NAME().
+ */
+static int parse_json(jsmn_parser_t *parser, const char *js, const size_t len);
+
+/**
+ * Allocates a fresh unused token from the token pool.
+ */
+static jsmn_token_t *jsmn_alloc_token(jsmn_parser_t *parser);
+
+/**
+ * Fills token type and boundaries.
+ */
+static void jsmn_fill_token(jsmn_token_t *token, const jsmn_token_type_t type,
+                            const char *start, int length);
+
+/**
+ * Fills next available token with JSON primitive.
+ */
+static int jsmn_parse_primitive(jsmn_parser_t *parser, const char *js,
+                                const size_t len);
+
+/**
+ * Return the jsmn_class_t of the len-byte primitive at s.  fraction says
+ * whether the scan saw '.', 'e' or 'E'.
+ */
+static unsigned char classify_primitive(const char *s, int len, bool fraction);
+
+/**
+ * Fills next token with JSON string.
+ */
+static int jsmn_parse_string(jsmn_parser_t *parser, const char *js,
+                             const size_t len);
+
+// *****************************************************************************
+// public functions
+
+JSMN_ENGINE_API int JSMN_ENGINE_NAME(jsmn_parser_t *parser, const char *js,
+                                     const size_t len) {
+    size_t end = len;
+    int r;
+
+    if (parser->limits.max_bytes != 0 && parser->limits.max_bytes < len) {
+#if JSMN_ENGINE_PADDED
+        // Scanners stop only at the sentinel, so the budget is checked up
+        // front: the whole document has to fit in it.
+        parser->pos = 0;
+        return JSMN_ERROR_LIMIT;
+#else
+        end = parser->limits.max_bytes;
+#endif
+    }
+    r = parse_json(parser, js, end);
+    if (end < len && js[end] != '\0') {
+        // Input was cut short by the byte budget: running out of it is a
+        // limit error unless the document ended with a NUL before the cut.
+        if ((r >= 0 && parser->pos >= end) ||
+            (r == JSMN_ERROR_PART && memchr(js, '\0', end) == NULL)) {
+            r = JSMN_ERROR_LIMIT;
+        }
+    }
+#if JSMN_ENGINE_STATS
+    parser->stats.bytes_scanned += parser->pos;
+    if (r == JSMN_ERROR_NOMEM) {
+        parser->stats.nomem_retries++;
+    }
+#endif
+    return r;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static int parse_json(jsmn_parser_t *parser, const char *js, const size_t len) {
+    int r;
+    int i;
+    int count;
+    jsmn_token_t *token;
+    int max_depth = INT_MAX;
+    int max_tokens = INT_MAX;
+
+    reset_parser(parser);
+    count = parser->token_count;
+    if (parser->limits.max_depth != 0) {
+        max_depth = parser->limits.max_depth;
+    }
+    if (parser->limits.max_tokens != 0) {
+        max_tokens = parser->limits.max_tokens;
+    }
+
+    for (; ENGINE_MORE(js, parser->pos, len); parser->pos++) {
+        char c;
+        jsmn_token_type_t type;
+
+        c = js[parser->pos];
+        switch (ENGINE_DISPATCH(c)) {
+        ENGINE_CASE_OPEN:
+            if (count >= max_tokens || parser->level >= max_depth) {
+                return JSMN_ERROR_LIMIT;
+            }
+            count++;
+            if (parser->tokens == NULL) {
+                parser->level += 1;
+                break;
+            }
+            token = jsmn_alloc_token(parser);
+            parser->level += 1;
+            if (token == NULL) {
+                return JSMN_ERROR_NOMEM;
+            }
+#if JSMN_ENGINE_STATS
+            if (parser->level > parser->stats.max_depth) {
+                parser->stats.max_depth = parser->level;
+            }
+#endif
+            if (parser->parent_index != -1) {
+                jsmn_token_t *parent = &parser->tokens[parser->parent_index];
+#if JSMN_ENGINE_STRICT && !JSMN_ENGINE_TRUSTED
+                /* In strict mode an object or array can't become a key */
+                if (parent->type == JSMN_OBJECT) {
+                    return JSMN_ERROR_INVAL;
+                }
+#endif
+                parent->child_count++;
+#if JSMN_ENGINE_PARENT_LINKS
+                token->parent_index = parser->parent_index;
+#endif
+            }
+            token->type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
+            token->start = &js[parser->pos];
+            parser->parent_index = parser->token_count - 1;
+            break;
+        ENGINE_CASE_CLOSE:
+            parser->level -= 1;
+            if (parser->tokens == NULL) {
+                break;
+            }
+            type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
+#if JSMN_ENGINE_PARENT_LINKS
+            if (parser->token_count < 1) {
+                return JSMN_ERROR_INVAL;
+            }
+            token = &parser->tokens[parser->token_count - 1];
+            for (;;) {
+                ENGINE_STAT_ADD(parser, backscan_steps, 1);
+                if (token->start != NULL && token->strlen == -1) {
+                    if (token->type != type) {
+                        return JSMN_ERROR_INVAL;
+                    }
+                    token->strlen = (parser->pos + 1) - (token->start - js);
+                    token->end_index = parser->token_count;
+                    parser->parent_index = token->parent_index;
+                    break;
+                }
+                if (token->parent_index == -1) {
+                    if (token->type != type || parser->parent_index == -1) {
+                        return JSMN_ERROR_INVAL;
+                    }
+                    break;
+                }
+                token = &parser->tokens[token->parent_index];
+            }
+#else
+            for (i = parser->token_count - 1; i >= 0; i--) {
+                ENGINE_STAT_ADD(parser, backscan_steps, 1);
+                token = &parser->tokens[i];
+                if (token->start != NULL && token->strlen == -1) {
+                    if (token->type != type) {
+                        return JSMN_ERROR_INVAL;
+                    }
+                    parser->parent_index = -1;
+                    token->strlen = (parser->pos + 1) - (token->start - js);
+                    token->end_index = parser->token_count;
+                    break;
+                }
+            }
+            /* Error if unmatched closing bracket */
+            if (i == -1) {
+                return JSMN_ERROR_INVAL;
+            }
+            for (; i >= 0; i--) {
+                ENGINE_STAT_ADD(parser, backscan_steps, 1);
+                token = &parser->tokens[i];
+                if (token->start != NULL && token->strlen == -1) {
+                    parser->parent_index = i;
+                    break;
+                }
+            }
+#endif
+            break;
+        ENGINE_CASE_QUOTE:
+            if (count >= max_tokens) {
+                return JSMN_ERROR_LIMIT;
+            }
+            r = jsmn_parse_string(parser, js, len);
+            if (r < 0) {
+                return r;
+            }
+            count++;
+            if (parser->parent_index != -1 && parser->tokens != NULL) {
+                parser->tokens[parser->parent_index].child_count++;
+            }
+            break;
+        ENGINE_CASE_SPACE:
+            /* Hand runs (indentation) to the whitespace kernel; the loop
+             * steps past the last byte of the run */
+            if (parser->pos + 1 < len &&
+                (js[parser->pos + 1] == ' ' || js[parser->pos + 1] == '\n' ||
+                 js[parser->pos + 1] == '\t' || js[parser->pos + 1] == '\r')) {
+                parser->pos += jsmn_skip_space(&js[parser->pos + 1],
+                                               len - parser->pos - 1);
+            }
+            break;
+        ENGINE_CASE_COLON:
+            parser->parent_index = parser->token_count - 1;
+            break;
+        ENGINE_CASE_COMMA:
+            if (parser->tokens != NULL && parser->parent_index != -1 &&
+                parser->tokens[parser->parent_index].type != JSMN_ARRAY &&
+                parser->tokens[parser->parent_index].type != JSMN_OBJECT) {
+#if JSMN_ENGINE_PARENT_LINKS
+                ENGINE_STAT_ADD(parser, backscan_steps, 1);
+                parser->parent_index =
+                    parser->tokens[parser->parent_index].parent_index;
+#else
+                for (i = parser->token_count - 1; i >= 0; i--) {
+                    ENGINE_STAT_ADD(parser, backscan_steps, 1);
+                    if (parser->tokens[i].type == JSMN_ARRAY ||
+                        parser->tokens[i].type == JSMN_OBJECT) {
+                        if (parser->tokens[i].start != NULL &&
+                            parser->tokens[i].strlen == -1) {
+                            parser->parent_index = i;
+                            break;
+                        }
+                    }
+                }
+#endif
+            }
+            break;
+#if JSMN_ENGINE_STRICT
+        /* In strict mode primitives are: numbers and booleans */
+        ENGINE_CASE_PRIMITIVE:
+#if !JSMN_ENGINE_TRUSTED
+            /* And they must not be keys of the object */
+            if (parser->tokens != NULL && parser->parent_index != -1) {
+                const jsmn_token_t *t = &parser->tokens[parser->parent_index];
+                if (t->type == JSMN_OBJECT ||
+                    (t->type == JSMN_STRING && t->child_count != 0)) {
+                    return JSMN_ERROR_INVAL;
+                }
+            }
+#endif
+#else
+        /* In non-strict mode every unquoted value is a primitive */
+        default:
+#endif
+            if (count >= max_tokens) {
+                return JSMN_ERROR_LIMIT;
+            }
+            r = jsmn_parse_primitive(parser, js, len);
+            if (r < 0) {
+                return r;
+            }
+            count++;
+            if (parser->parent_index != -1 && parser->tokens != NULL) {
+                parser->tokens[parser->parent_index].child_count++;
+            }
+            break;
+
+#if JSMN_ENGINE_STRICT
+        /* Unexpected char in strict mode */
+        default:
+            return JSMN_ERROR_INVAL;
+#endif
+        }
+    }
+
+    if (parser->tokens != NULL) {
+        for (i = parser->token_count - 1; i >= 0; i--) {
+            /* Unmatched opened object or array */
+            if (parser->tokens[i].start != NULL &&
+                parser->tokens[i].strlen == -1) {
+                return JSMN_ERROR_PART;
+            }
+        }
+    }
+
+    return count;
+}
+
+static void reset_parser(jsmn_parser_t *parser) {
+    if (parser->tokens != NULL) {
+        memset(parser->tokens, 0, sizeof(jsmn_token_t) * parser->num_tokens);
+    }
+    if (parser->symtab != NULL) {
+        jsmn_symtab_reset(parser->symtab);
+    }
+    if (parser->children != NULL) {
+        parser->children->built = false;
+    }
+    if (parser->keyset != NULL) {
+        jsmn_keyset_reset(parser->keyset);
+    }
+    parser->pos = 0;
+    parser->token_count = 0;
+    parser->parent_index = -1;
+    parser->level = 0;
+}
+
+static jsmn_token_t *jsmn_alloc_token(jsmn_parser_t *parser) {
+    jsmn_token_t *tok;
+    if (parser->token_count >= parser->num_tokens) {
+        return NULL;
+    }
+    tok = &parser->tokens[parser->token_count++];
+    ENGINE_STAT_ADD(parser, tokens_allocated, 1);
+    tok->start = NULL;
+    tok->strlen = -1;
+    tok->subtype = JSMN_CLASS_NONE;
+    tok->symbol = 0;
+    tok->child_count = 0;
+    tok->parent_index = -1;
+    tok->level = parser->level;
+    tok->end_index = parser->token_count;
+    return tok;
+}
+
+static void jsmn_fill_token(jsmn_token_t *token, const jsmn_token_type_t type,
+                            const char *start, int length) {
+    token->type = type;
+    token->start = start;
+    token->strlen = length;
+    token->child_count = 0;
+}
+
+static int jsmn_parse_primitive(jsmn_parser_t *parser, const char *js,
+                                const size_t len) {
+    jsmn_token_t *token;
+    int start; // index, not char pointer!
+    size_t end = len;
+    bool fraction = false;
+
+    start = parser->pos;
+#if JSMN_ENGINE_PADDED
+    (void)end;
+#else
+    if (parser->limits.max_strlen != 0 &&
+        start + (size_t)parser->limits.max_strlen + 1 < len) {
+        end = start + (size_t)parser->limits.max_strlen + 1;
+    }
+#endif
+
+#if JSMN_ENGINE_TABLE
+    /* One table test per byte: the flags of the bytes passed over are
+     * collected and examined once, when the primitive ends */
+#if JSMN_ENGINE_STRICT
+    const unsigned int stop = JSMN_CF_END | JSMN_CF_NUL;
+#else
+    const unsigned int stop = JSMN_CF_END | JSMN_CF_COLON | JSMN_CF_NUL;
+#endif
+    unsigned int flags = 0;
+    unsigned int seen = 0;
+#if JSMN_ENGINE_PADDED
+    for (;; parser->pos++) {
+#else
+    for (; parser->pos < end; parser->pos++) {
+#endif
+        flags = jsmn_engine_chars[(unsigned char)js[parser->pos]];
+        if ((flags & stop) != 0) {
+            break;
+        }
+        seen |= flags;
+    }
+#if !JSMN_ENGINE_TRUSTED
+    if ((seen & JSMN_CF_BAD) != 0) {
+        /* Fail at the first bad byte, as the bytewise scan does */
+        parser->pos = start;
+        while ((jsmn_engine_chars[(unsigned char)js[parser->pos]] &
+                JSMN_CF_BAD) == 0) {
+            parser->pos++;
+        }
+        int err = ENGINE_INVAL(parser, start, 0);
+        parser->pos = start;
+        return err;
+    }
+#endif
+    fraction = (seen & JSMN_CF_FRACTION) != 0;
+    if ((flags & (JSMN_CF_END | JSMN_CF_COLON) & stop) != 0) {
+        goto found;
+    }
+#else
+    for (; ENGINE_MORE(js, parser->pos, end); parser->pos++) {
+        switch (js[parser->pos]) {
+#if !JSMN_ENGINE_STRICT
+        /* In strict mode primitive must be followed by "," or "}" or "]" */
+        case ':':
+#endif
+        case '\t':
+        case '\r':
+        case '\n':
+        case ' ':
+        case ',':
+        case ']':
+        case '}':
+            goto found;
+        case '.':
+        case 'e':
+        case 'E':
+            fraction = true;
+            break;
+        default:
+            /* to quiet a warning from gcc*/
+            break;
+        }
+#if !JSMN_ENGINE_TRUSTED
+        if (js[parser->pos] < 32 || js[parser->pos] >= 127) {
+            int err = ENGINE_INVAL(parser, start, 0);
+            parser->pos = start;
+            return err;
+        }
+#endif
+    }
+#endif
+    if (parser->limits.max_strlen != 0 &&
+        parser->pos - start > parser->limits.max_strlen) {
+        /* Primitive is longer than max_strlen */
+        parser->pos = start;
+        return JSMN_ERROR_LIMIT;
+    }
+#if JSMN_ENGINE_STRICT
+    /* In strict mode primitive must be followed by a comma/object/array */
+    parser->pos = start;
+    return JSMN_ERROR_PART;
+#endif
+
+found:
+#if JSMN_ENGINE_PADDED
+    if (parser->limits.max_strlen != 0 &&
+        parser->pos - start > parser->limits.max_strlen) {
+        parser->pos = start;
+        return JSMN_ERROR_LIMIT;
+    }
+#endif
+    if (parser->tokens == NULL) {
+        parser->pos--;
+        return 0;
+    }
+    token = jsmn_alloc_token(parser);
+    if (token == NULL) {
+        parser->pos = start;
+        return JSMN_ERROR_NOMEM;
+    }
+    jsmn_fill_token(token, JSMN_PRIMITIVE, &js[start], parser->pos - start);
+    token->subtype =
+        classify_primitive(&js[start], parser->pos - start, fraction);
+#if JSMN_ENGINE_PARENT_LINKS
+    token->parent_index = parser->parent_index;
+#endif
+    parser->pos--;
+    return 0;
+}
+
+static unsigned char classify_primitive(const char *s, int len,
+                                        bool fraction) {
+    switch (s[0]) {
+    case 't':
+        return len == 4 && memcmp(s, "true", 4) == 0 ? JSMN_CLASS_TRUE
+                                                      : JSMN_CLASS_OTHER;
+    case 'f':
+        return len == 5 && memcmp(s, "false", 5) == 0 ? JSMN_CLASS_FALSE
+                                                       : JSMN_CLASS_OTHER;
+    case 'n':
+        return len == 4 && memcmp(s, "null", 4) == 0 ? JSMN_CLASS_NULL
+                                                      : JSMN_CLASS_OTHER;
+    case '-':
+        if (len < 2 || s[1] < '0' || s[1] > '9') {
+            return JSMN_CLASS_OTHER;
+        }
+        return JSMN_CLASS_NEGATIVE |
+               (fraction ? JSMN_CLASS_FLOAT : JSMN_CLASS_INTEGER);
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        return fraction ? JSMN_CLASS_FLOAT : JSMN_CLASS_INTEGER;
+    default:
+        return JSMN_CLASS_OTHER;
+    }
+}
+
+static int jsmn_parse_string(jsmn_parser_t *parser, const char *js,
+                             const size_t len) {
+    jsmn_token_t *token;
+
+    int start = parser->pos; // index, not char pointer!
+    size_t end = len;
+
+#if !JSMN_ENGINE_PADDED
+    if (parser->limits.max_strlen != 0 &&
+        start + (size_t)parser->limits.max_strlen + 2 < len) {
+        /* Room for both quotes around max_strlen bytes */
+        end = start + (size_t)parser->limits.max_strlen + 2;
+    }
+#endif
+
+    /* Skip starting quote */
+    parser->pos++;
+
+#if JSMN_ENGINE_TABLE
+    /* Next state by state and string class of the byte.  A backslash ends
+     * the text only where a bytewise scan sees a byte after it. */
+#if JSMN_ENGINE_PADDED
+#define ESCAPED_NUL JSMN_SS_STOP
+#elif JSMN_ENGINE_TRUSTED
+#define ESCAPED_NUL JSMN_SS_IN
+#else
+#define ESCAPED_NUL JSMN_SS_BAD
+#endif
+    static const unsigned char next[JSMN_SS_DONE][JSMN_SC_COUNT] = {
+        // plain, quote, backslash, escape, esc/hex, u, hex, NUL
+        {0, JSMN_SS_DONE, JSMN_SS_ESCAPE, 0, 0, 0, 0, JSMN_SS_STOP},
+#if JSMN_ENGINE_TRUSTED
+        /* Skip the escaped char; \uXXXX digits are ordinary chars */
+        {0, 0, 0, 0, 0, 0, 0, ESCAPED_NUL},
+#else
+        {JSMN_SS_BAD, 0, 0, 0, 0, JSMN_SS_U1, JSMN_SS_BAD, ESCAPED_NUL},
+#endif
+        {JSMN_SS_BAD, JSMN_SS_BAD, JSMN_SS_BAD, JSMN_SS_BAD, 3, JSMN_SS_BAD,
+         3, JSMN_SS_STOP},
+        {JSMN_SS_BAD, JSMN_SS_BAD, JSMN_SS_BAD, JSMN_SS_BAD, 4, JSMN_SS_BAD,
+         4, JSMN_SS_STOP},
+        {JSMN_SS_BAD, JSMN_SS_BAD, JSMN_SS_BAD, JSMN_SS_BAD, 5, JSMN_SS_BAD,
+         5, JSMN_SS_STOP},
+        {JSMN_SS_BAD, JSMN_SS_BAD, JSMN_SS_BAD, JSMN_SS_BAD, 0, JSMN_SS_BAD,
+         0, JSMN_SS_STOP},
+    };
+#undef ESCAPED_NUL
+    unsigned int state = JSMN_SS_IN;
+
+#if JSMN_ENGINE_PADDED
+    for (;; parser->pos++) {
+#else
+    for (; parser->pos < end; parser->pos++) {
+#endif
+        unsigned int sc;
+        if (state == JSMN_SS_IN) {
+            /* Pass over plain text to the next quote, backslash or NUL */
+            parser->pos += ENGINE_SCAN_STRING(js, parser->pos, end);
+#if !JSMN_ENGINE_PADDED
+            if (parser->pos >= end) {
+                break;
+            }
+#endif
+        }
+        sc = jsmn_engine_chars[(unsigned char)js[parser->pos]] >> JSMN_SC_SHIFT;
+#if JSMN_ENGINE_STATS
+        unsigned int prev = state;
+#endif
+        state = next[state][sc];
+        ENGINE_STAT_ADD(parser, escapes,
+                        prev == JSMN_SS_ESCAPE && state != JSMN_SS_STOP);
+        if (state >= JSMN_SS_DONE) {
+            break;
+        }
+    }
+    if (state == JSMN_SS_DONE) {
+        goto found;
+    }
+    if (state == JSMN_SS_BAD) {
+        int err = ENGINE_INVAL(parser, start, 1);
+        parser->pos = start;
+        return err;
+    }
+#else
+    for (; ENGINE_MORE(js, parser->pos, end); parser->pos++) {
+        /* Pass over plain text to the next quote, backslash or NUL */
+        parser->pos += ENGINE_SCAN_STRING(js, parser->pos, end);
+        if (!ENGINE_MORE(js, parser->pos, end)) {
+            break;
+        }
+        char c = js[parser->pos];
+
+        /* Quote: end of string */
+        if (c == '\"') {
+            goto found;
+        }
+
+        /* Backslash: Quoted symbol expected */
+#if JSMN_ENGINE_PADDED
+        if (c == '\\' && js[parser->pos + 1] != '\0') {
+#else
+        if (c == '\\' && parser->pos + 1 < end) {
+#endif
+            ENGINE_STAT_ADD(parser, escapes, 1);
+            parser->pos++;
+#if JSMN_ENGINE_TRUSTED
+            /* Skip the escaped char; \uXXXX digits are ordinary chars */
+            continue;
+#else
+            int i;
+            switch (js[parser->pos]) {
+            /* Allowed escaped symbols */
+            case '\"':
+            case '/':
+            case '\\':
+            case 'b':
+            case 'f':
+            case 'r':
+            case 'n':
+            case 't':
+                break;
+            /* Allows escaped symbol \uXXXX */
+            case 'u':
+                parser->pos++;
+                for (i = 0;
+                     i < 4 && ENGINE_MORE(js, parser->pos, end);
+                     i++) {
+                    /* If it isn't a hex character we have an error */
+                    if (!((js[parser->pos] >= 48 &&
+                           js[parser->pos] <= 57) || /* 0-9 */
+                          (js[parser->pos] >= 65 &&
+                           js[parser->pos] <= 70) || /* A-F */
+                          (js[parser->pos] >= 97 &&
+                           js[parser->pos] <= 102))) { /* a-f */
+                        int err = ENGINE_INVAL(parser, start, 1);
+                        parser->pos = start;
+                        return err;
+                    }
+                    parser->pos++;
+                }
+                parser->pos--;
+                break;
+            /* Unexpected symbol */
+            default: {
+                int err = ENGINE_INVAL(parser, start, 1);
+                parser->pos = start;
+                return err;
+            }
+            }
+#endif
+        }
+    }
+#endif
+    if (parser->limits.max_strlen != 0 &&
+        parser->pos - start - 1 > parser->limits.max_strlen) {
+        /* String is longer than max_strlen */
+        parser->pos = start;
+        return JSMN_ERROR_LIMIT;
+    }
+    parser->pos = start;
+    return JSMN_ERROR_PART;
+
+found:
+#if JSMN_ENGINE_PADDED
+    if (parser->limits.max_strlen != 0 &&
+        parser->pos - start - 1 > parser->limits.max_strlen) {
+        /* String is longer than max_strlen */
+        parser->pos = start;
+        return JSMN_ERROR_LIMIT;
+    }
+#endif
+    if (parser->tokens == NULL) {
+        return 0;
+    }
+    token = jsmn_alloc_token(parser);
+    if (token == NULL) {
+        parser->pos = start;
+        return JSMN_ERROR_NOMEM;
+    }
+    jsmn_fill_token(token, JSMN_STRING, &js[start + 1],
+                    parser->pos - start - 1);
+#if JSMN_ENGINE_PARENT_LINKS
+    token->parent_index = parser->parent_index;
+#endif
+    if ((parser->symtab != NULL || parser->keyset != NULL) &&
+        parser->parent_index != -1 &&
+        parser->tokens[parser->parent_index].type == JSMN_OBJECT) {
+        /* An object key: hash it while its bytes are still hot */
+        if (parser->symtab != NULL) {
+            token->symbol = (unsigned short)jsmn_symtab_intern(
+                parser->symtab, token->start, token->strlen);
+        }
+        if (parser->keyset != NULL) {
+            int r = jsmn_keyset_insert(parser->keyset, parser->parent_index,
+                                       token->start, token->strlen);
+            if (r < 0) {
+                parser->pos = start;
+                return r;
+            }
+        }
+    }
+    return 0;
+}
+
+
+#undef reset_parser
+#undef parse_json
+#undef jsmn_alloc_token
+#undef jsmn_fill_token
+#undef jsmn_parse_primitive
+#undef jsmn_parse_string
+#undef classify_primitive
+#undef ENGINE_STAT_ADD
+#undef ENGINE_MORE
+#undef ENGINE_INVAL
+#undef ENGINE_DISPATCH
+#undef ENGINE_CASE_OPEN
+#undef ENGINE_CASE_CLOSE
+#undef ENGINE_SCAN_STRING
+#undef ENGINE_CASE_QUOTE
+#undef ENGINE_CASE_SPACE
+#undef ENGINE_CASE_COLON
+#undef ENGINE_CASE_COMMA
+#undef ENGINE_CASE_PRIMITIVE
+#undef JSMN_ENGINE_NAME
+#undef JSMN_ENGINE_STRICT
+#undef JSMN_ENGINE_PARENT_LINKS
+#undef JSMN_ENGINE_STATS
+#undef JSMN_ENGINE_TRUSTED
+#undef JSMN_ENGINE_PADDED
+#undef JSMN_ENGINE_TABLE
+#undef JSMN_ENGINE_API
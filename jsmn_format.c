@@ -0,0 +1,509 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_format.h"
+#include "jsmn_simd.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/* One open object or array in jsmn_pretty_print() */
+typedef struct {
+    char close;      // '}' or ']'
+    bool expect_key; // next token is an object key
+    int remaining;   // members or elements not yet written
+} frame_t;
+
+#define INDENT_CHUNK 64
+
+/* State of one jsmn_project() call */
+typedef struct {
+    const char *js;
+    size_t len;
+    const char *const *paths;
+    jsmn_project_mode_t mode;
+    jsmn_writer_t *writer;
+    int depth; // objects and arrays being rewritten
+} project_t;
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Append n bytes of s to the writer, copying short spans inline.  avail is
+ * the number of readable bytes at s.
+ */
+static inline int put_span(jsmn_writer_t *writer, const char *s, size_t n,
+                           size_t avail);
+
+/**
+ * Write the value at *pos, rewriting it if mask holds paths that lead into
+ * it (level segments of them already matched) or else copying it verbatim.
+ * Leaves *pos just past the value.
+ */
+static int project_value(project_t *p, size_t *pos, uint64_t mask, int level);
+
+/**
+ * Handle the object member at *pos for project_value().  *written says if
+ * a member was already written, and is set if this one is.
+ */
+static int project_member(project_t *p, size_t *pos, uint64_t mask,
+                          int level, bool *written);
+
+/**
+ * Return true if segment level of path is the len-byte key, setting *last if
+ * it is the path's final segment.
+ */
+static bool match_segment(const char *path, int level, const char *key,
+                          size_t len, bool *last);
+
+/**
+ * Move *pos past the value, or the string, starting there.
+ */
+static int skip_value(const project_t *p, size_t *pos);
+static int skip_string(const project_t *p, size_t *pos);
+
+/**
+ * Return the offset of the first non-whitespace byte at or after pos.
+ */
+static size_t skip_space(const char *js, size_t pos, size_t len);
+
+/**
+ * Write a single character.
+ */
+static int put_char(jsmn_writer_t *writer, char c);
+
+/**
+ * Write a newline followed by depth levels of indentation.
+ */
+static int put_newline(jsmn_writer_t *writer, const jsmn_pretty_opts_t *opts,
+                       int depth);
+
+/**
+ * Write a token's span of text, including the quotes around strings.
+ */
+static int put_token(jsmn_writer_t *writer, jsmn_token_t *token);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_minify(const char *js, size_t len, jsmn_writer_t *writer) {
+    size_t span = 0; // start of bytes not yet written
+    size_t pos = 0;
+
+    while (pos < len) {
+        switch (js[pos]) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+            // write out the pending span, then skip the whitespace run
+            if (put_span(writer, &js[span], pos - span, len - span) < 0) {
+                return writer->error;
+            }
+            pos++;
+            pos += jsmn_skip_space(&js[pos], len - pos);
+            span = pos;
+            break;
+        case '\"':
+            // strings stay in the pending span
+            pos++;
+            for (;;) {
+                pos += jsmn_scan_string(&js[pos], len - pos);
+                if (pos >= len || js[pos] == '\"') {
+                    break;
+                }
+                pos += 2; // skip the backslash and the escaped char
+                if (pos >= len) {
+                    break;
+                }
+            }
+            pos++;
+            break;
+        default:
+            pos += jsmn_scan_plain(&js[pos], len - pos);
+            break;
+        }
+    }
+    if (pos > len) {
+        // unterminated string
+        pos = len;
+    }
+    return put_span(writer, &js[span], pos - span, len - span);
+}
+
+int jsmn_project(const char *js, size_t len, const char *const *paths,
+                 int num_paths, jsmn_project_mode_t mode,
+                 jsmn_writer_t *writer) {
+    project_t p = {js, len, paths, mode, writer, 0};
+    size_t pos = skip_space(js, 0, len);
+
+    if (num_paths < 0 || num_paths > JSMN_PROJECT_MAX_PATHS) {
+        return JSMN_WRITER_ERROR_INVAL;
+    }
+    if (pos == len) {
+        return 0;
+    }
+    if (num_paths == 0 && mode == JSMN_PROJECT_KEEP &&
+        (js[pos] == '{' || js[pos] == '[')) {
+        // keeping nothing leaves an empty object or array
+        char open = js[pos];
+        int r;
+        if ((r = skip_value(&p, &pos)) < 0 ||
+            (r = put_char(writer, open)) < 0) {
+            return r;
+        }
+        return put_char(writer, (open == '{') ? '}' : ']');
+    }
+    uint64_t mask = (num_paths == 64) ? ~(uint64_t)0
+                                      : ((uint64_t)1 << num_paths) - 1;
+    return project_value(&p, &pos, mask, 0);
+}
+
+int jsmn_pretty_print(jsmn_parser_t *parser, int token_index,
+                      const jsmn_pretty_opts_t *opts, jsmn_writer_t *writer) {
+    static const jsmn_pretty_opts_t default_opts = {2, ' '};
+    frame_t stack[JSMN_FORMAT_MAX_DEPTH];
+    int depth = 0;
+    bool compact;
+
+    if (opts == NULL) {
+        opts = &default_opts;
+    }
+    compact = (opts->indent == 0);
+
+    for (;;) {
+        jsmn_token_t *token = jsmn_token_ref(parser, token_index++);
+        frame_t *frame = (depth > 0) ? &stack[depth - 1] : NULL;
+
+        if (token == NULL) {
+            // ran off the end of the tokens (partial parse?)
+            return JSMN_WRITER_ERROR_INVAL;
+        }
+        if (frame != NULL && frame->expect_key) {
+            frame->expect_key = false;
+            if (put_token(writer, token) < 0 ||
+                jsmn_writer_write(writer, compact ? ":" : ": ",
+                                  compact ? 1 : 2) < 0) {
+                return writer->error;
+            }
+            continue;
+        }
+
+        if (jsmn_token_is_object(token) || jsmn_token_is_array(token)) {
+            bool is_object = jsmn_token_is_object(token);
+
+            if (token->child_count == 0) {
+                if (jsmn_writer_write(writer, is_object ? "{}" : "[]", 2) < 0) {
+                    return writer->error;
+                }
+            } else {
+                if (depth >= JSMN_FORMAT_MAX_DEPTH) {
+                    return JSMN_WRITER_ERROR_INVAL;
+                }
+                frame = &stack[depth++];
+                frame->close = is_object ? '}' : ']';
+                frame->expect_key = is_object;
+                frame->remaining = token->child_count;
+                if (jsmn_writer_write(writer, is_object ? "{" : "[", 1) < 0 ||
+                    put_newline(writer, opts, depth) < 0) {
+                    return writer->error;
+                }
+                continue;
+            }
+        } else if (put_token(writer, token) < 0) {
+            return writer->error;
+        }
+
+        // a value is complete: write a separator or close finished containers
+        for (;;) {
+            if (depth == 0) {
+                return writer->error;
+            }
+            frame = &stack[depth - 1];
+            if (--frame->remaining > 0) {
+                frame->expect_key = (frame->close == '}');
+                if (jsmn_writer_write(writer, ",", 1) < 0 ||
+                    put_newline(writer, opts, depth) < 0) {
+                    return writer->error;
+                }
+                break;
+            }
+            depth--;
+            if (put_newline(writer, opts, depth) < 0 ||
+                jsmn_writer_write(writer, &frame->close, 1) < 0) {
+                return writer->error;
+            }
+        }
+    }
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static inline int put_span(jsmn_writer_t *writer, const char *s, size_t n,
+                           size_t avail) {
+    if (n <= 16 && avail >= 16 && writer->size - writer->len >= 16 &&
+        writer->error == 0) {
+        // fixed-size copy: cheaper than a memcpy() call for short spans
+        memcpy(&writer->buf[writer->len], s, 16);
+        writer->len += n;
+        writer->total += n;
+        return 0;
+    }
+    return jsmn_writer_write(writer, s, n);
+}
+
+static int put_newline(jsmn_writer_t *writer, const jsmn_pretty_opts_t *opts,
+                       int depth) {
+    char chunk[INDENT_CHUNK];
+    size_t n;
+
+    if (opts->indent == 0) {
+        return writer->error;
+    }
+    if (jsmn_writer_write(writer, "\n", 1) < 0) {
+        return writer->error;
+    }
+    n = (size_t)opts->indent * depth;
+    memset(chunk, opts->indent_char,
+           n < sizeof(chunk) ? n : sizeof(chunk));
+    while (n > 0) {
+        size_t m = n < sizeof(chunk) ? n : sizeof(chunk);
+        if (jsmn_writer_write(writer, chunk, m) < 0) {
+            return writer->error;
+        }
+        n -= m;
+    }
+    return 0;
+}
+
+static int put_token(jsmn_writer_t *writer, jsmn_token_t *token) {
+    const char *s = jsmn_token_string(token);
+    size_t n = jsmn_token_strlen(token);
+
+    if (jsmn_token_is_string(token)) {
+        s--;
+        n += 2;
+    }
+    return jsmn_writer_write(writer, s, n);
+}
+
+static int project_value(project_t *p, size_t *pos, uint64_t mask, int level) {
+    const char *js = p->js;
+    size_t start = *pos;
+    char open = js[start];
+    int r;
+
+    if (mask == 0 || (open != '{' && open != '[')) {
+        // nothing to take out: copy it as it stands
+        if ((r = skip_value(p, pos)) < 0) {
+            return r;
+        }
+        return put_span(p->writer, &js[start], *pos - start, p->len - start);
+    }
+    if (++p->depth > JSMN_FORMAT_MAX_DEPTH) {
+        return JSMN_WRITER_ERROR_INVAL;
+    }
+    char close = (open == '{') ? '}' : ']';
+    bool written = false;
+    bool seen = false;
+    if ((r = put_char(p->writer, open)) < 0) {
+        return r;
+    }
+    (*pos)++;
+    for (;;) {
+        *pos = skip_space(js, *pos, p->len);
+        if (*pos < p->len && js[*pos] == close) {
+            (*pos)++;
+            break;
+        }
+        if (seen) {
+            if (*pos >= p->len || js[*pos] != ',') {
+                return JSMN_WRITER_ERROR_INVAL;
+            }
+            *pos = skip_space(js, *pos + 1, p->len);
+        }
+        if (*pos >= p->len) {
+            return JSMN_WRITER_ERROR_INVAL;
+        }
+        seen = true;
+        if (close == '}') {
+            r = project_member(p, pos, mask, level, &written);
+        } else if (p->mode == JSMN_PROJECT_KEEP && js[*pos] != '{' &&
+                   js[*pos] != '[') {
+            // a scalar cannot hold a kept member
+            r = skip_value(p, pos);
+        } else {
+            // arrays are looked through: elements stay at the same level
+            if (written && (r = put_char(p->writer, ',')) < 0) {
+                return r;
+            }
+            written = true;
+            r = project_value(p, pos, mask, level);
+        }
+        if (r < 0) {
+            return r;
+        }
+    }
+    p->depth--;
+    return put_char(p->writer, close);
+}
+
+static int project_member(project_t *p, size_t *pos, uint64_t mask,
+                          int level, bool *written) {
+    const char *js = p->js;
+    size_t key = *pos;
+    uint64_t full = 0;
+    uint64_t partial = 0;
+    int r;
+
+    if (js[key] != '\"' || (r = skip_string(p, pos)) < 0) {
+        return JSMN_WRITER_ERROR_INVAL;
+    }
+    size_t key_end = *pos;
+    *pos = skip_space(js, *pos, p->len);
+    if (*pos >= p->len || js[*pos] != ':') {
+        return JSMN_WRITER_ERROR_INVAL;
+    }
+    *pos = skip_space(js, *pos + 1, p->len);
+    if (*pos >= p->len) {
+        return JSMN_WRITER_ERROR_INVAL;
+    }
+
+    for (int i = 0; mask >> i != 0; i++) {
+        bool last;
+        if ((mask >> i & 1) != 0 &&
+            match_segment(p->paths[i], level, &js[key + 1], key_end - key - 2,
+                          &last)) {
+            if (last) {
+                full |= (uint64_t)1 << i;
+            } else {
+                partial |= (uint64_t)1 << i;
+            }
+        }
+    }
+    bool container = js[*pos] == '{' || js[*pos] == '[';
+    bool keep;
+    if (p->mode == JSMN_PROJECT_KEEP) {
+        keep = full != 0 || (partial != 0 && container);
+        partial = (full != 0) ? 0 : partial;
+    } else {
+        keep = full == 0;
+    }
+    if (!keep) {
+        return skip_value(p, pos);
+    }
+    if (*written && (r = put_char(p->writer, ',')) < 0) {
+        return r;
+    }
+    *written = true;
+    if ((r = put_span(p->writer, &js[key], key_end - key, p->len - key)) < 0 ||
+        (r = put_char(p->writer, ':')) < 0) {
+        return r;
+    }
+    return project_value(p, pos, partial, level + 1);
+}
+
+static bool match_segment(const char *path, int level, const char *key,
+                          size_t len, bool *last) {
+    for (int i = 0; i < level; i++) {
+        path = strchr(path, '.');
+        if (path == NULL) {
+            return false;
+        }
+        path++;
+    }
+    const char *end = strchr(path, '.');
+    size_t n = (end != NULL) ? (size_t)(end - path) : strlen(path);
+    *last = (end == NULL);
+    return n == len && memcmp(path, key, len) == 0;
+}
+
+static int skip_value(const project_t *p, size_t *pos) {
+    const char *js = p->js;
+    size_t start = *pos;
+    int depth = 0;
+
+    switch (js[start]) {
+    case '\"':
+        return skip_string(p, pos);
+    case '{':
+    case '[':
+        while (*pos < p->len) {
+            char c = js[*pos];
+            if (c == '\"') {
+                if (skip_string(p, pos) < 0) {
+                    return JSMN_WRITER_ERROR_INVAL;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                (*pos)++;
+                return 0;
+            }
+            (*pos)++;
+        }
+        return JSMN_WRITER_ERROR_INVAL;
+    default:
+        // a primitive runs to the next delimiter or whitespace
+        while (*pos < p->len &&
+               memchr(",:]}\" \t\r\n", js[*pos], 9) == NULL) {
+            (*pos)++;
+        }
+        return (*pos > start) ? 0 : JSMN_WRITER_ERROR_INVAL;
+    }
+}
+
+static int skip_string(const project_t *p, size_t *pos) {
+    size_t i = *pos + 1;
+    for (;;) {
+        if (i >= p->len) {
+            return JSMN_WRITER_ERROR_INVAL;
+        }
+        i += jsmn_scan_string(&p->js[i], p->len - i);
+        if (i >= p->len) {
+            return JSMN_WRITER_ERROR_INVAL;
+        }
+        if (p->js[i] == '\"') {
+            *pos = i + 1;
+            return 0;
+        }
+        i += 2; // the backslash and the escaped char
+    }
+}
+
+static size_t skip_space(const char *js, size_t pos, size_t len) {
+    return (pos < len) ? pos + jsmn_skip_space(&js[pos], len - pos) : pos;
+}
+
+static int put_char(jsmn_writer_t *writer, char c) {
+    return jsmn_writer_write(writer, &c, 1);
+}
@@ -0,0 +1,111 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_FORMAT_H
+#define JSMN_FORMAT_H
+
+#include "jsmn.h"
+#include "jsmn_writer.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Most paths a single jsmn_project() call can take.
+ */
+#define JSMN_PROJECT_MAX_PATHS 64
+
+/**
+ * Deepest nesting of objects and arrays jsmn_pretty_print() and
+ * jsmn_project() handle.  The pretty printer keeps 8 bytes per level on the
+ * stack, the projection one recursive call per level along its paths.  May
+ * be overridden at build time; to format every document a parser accepts,
+ * pass the same max_depth to jsmn_set_limits().
+ */
+#ifndef JSMN_FORMAT_MAX_DEPTH
+#define JSMN_FORMAT_MAX_DEPTH 1024
+#endif
+
+/**
+ * What jsmn_project() does with the members it is given.
+ */
+typedef enum {
+  JSMN_PROJECT_KEEP, // keep only these members (a whitelist)
+  JSMN_PROJECT_DROP  // keep everything but these members (a blacklist)
+} jsmn_project_mode_t;
+
+/**
+ * Layout options for jsmn_pretty_print().
+ */
+typedef struct {
+  unsigned int indent; // indent_char repeats per level, 0 for compact output
+  char indent_char;    // usually ' ' or '\t'
+} jsmn_pretty_opts_t;
+
+/**
+ * @brief Copy len bytes of JSON to writer with all whitespace outside of
+ * strings removed.  Works directly on the text without tokenizing it, so the
+ * input is not validated.  Returns 0 or a negative jsmn_writer_err_t.
+ */
+int jsmn_minify(const char *js, size_t len, jsmn_writer_t *writer);
+
+/**
+ * @brief Copy the first JSON value in js (len bytes) to writer keeping, or
+ * dropping, the members named by paths, in a single pass over the text and
+ * without tokens.
+ *
+ * A path names members from the top-level object down, separated by dots
+ * ("user.name"), compared with keys as written.  Arrays are looked through,
+ * so "items.price" is the price of every element of items.  Kept values and
+ * members off every path are copied verbatim; only the objects and arrays
+ * along the paths are rewritten, without whitespace.  When keeping, array
+ * elements that are not objects or arrays are dropped from arrays along a
+ * path.
+ *
+ * The text is checked only as far as the projection needs; malformed input
+ * fails with JSMN_WRITER_ERROR_INVAL, as do more than JSMN_PROJECT_MAX_PATHS
+ * paths and nesting along the paths deeper than JSMN_FORMAT_MAX_DEPTH.
+ * Returns 0 or a negative jsmn_writer_err_t.
+ */
+int jsmn_project(const char *js, size_t len, const char *const *paths,
+                 int num_paths, jsmn_project_mode_t mode,
+                 jsmn_writer_t *writer);
+
+/**
+ * @brief Write the value at token_index, including its subtree, one member
+ * or element per line.  Strings and primitives are copied verbatim from the
+ * parsed text.  If opts is NULL, two spaces per level are used; an indent of
+ * 0 writes compact output instead.  Nesting deeper than
+ * JSMN_FORMAT_MAX_DEPTH fails with JSMN_WRITER_ERROR_INVAL.  Returns 0 or a
+ * negative jsmn_writer_err_t.
+ */
+int jsmn_pretty_print(jsmn_parser_t *parser, int token_index,
+                      const jsmn_pretty_opts_t *opts, jsmn_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_FORMAT_H */
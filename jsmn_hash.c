@@ -0,0 +1,510 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_hash.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/* Multiplier and seed of the hash (64-bit golden ratio, FNV offset) */
+#define HASH_PRIME 0x9e3779b97f4a7c15ULL
+#define HASH_SEED 0xcbf29ce484222325ULL
+
+/* Numbers with up to this many significant digits (DBL_DIG) map to
+ * distinct doubles, within MAX_EXACT_EXPONENT */
+#define MAX_EXACT_DIGITS 15
+#define MAX_EXACT_EXPONENT 300
+
+/* Exponents are clamped to this, far beyond any real document */
+#define MAX_EXPONENT 1000000000000000LL
+
+/* What a hash was made from, so that e.g. "1" and 1 differ */
+typedef enum {
+    TAG_OBJECT = 1,
+    TAG_ARRAY,
+    TAG_MEMBER,
+    TAG_STRING,
+    TAG_NUMBER,      // hashed by value
+    TAG_NUMBER_TEXT, // hashed by text
+    TAG_TRUE,
+    TAG_FALSE,
+    TAG_NULL,
+    TAG_OTHER
+} tag_t;
+
+/* A number as 0.<digits> * 10^exponent, without leading or trailing zeros */
+typedef struct {
+    bool negative;
+    const char *first; // first significant digit in the text, NULL for 0
+    const char *last;  // last significant digit in the text
+    const char *point; // decimal point between them, or NULL
+    int digits;        // significant digits
+    long long exponent;
+} number_t;
+
+/* Bytes being hashed a word at a time */
+typedef struct {
+    uint64_t h;             // hash of the whole words so far
+    unsigned char word[8];  // bytes of the word being filled
+    unsigned int fill;      // bytes in word
+    uint64_t len;           // bytes so far
+} stream_t;
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Fold one 64-bit word into hash h.
+ */
+static uint64_t mix(uint64_t h, uint64_t word);
+
+/**
+ * Scramble h so that nearby inputs differ in every bit.
+ */
+static uint64_t finish(uint64_t h);
+
+/**
+ * Start hashing bytes of a value of kind tag.
+ */
+static void stream_init(stream_t *st, tag_t tag);
+
+/**
+ * Hash n bytes at p.
+ */
+static void stream_bytes(stream_t *st, const char *p, size_t n);
+
+/**
+ * Hash the partial last word and the length, and return the hash.
+ */
+static uint64_t stream_end(stream_t *st);
+
+/**
+ * Hash the text of a string token, with its escapes decoded.
+ */
+static uint64_t hash_string(const char *s, int len);
+
+/**
+ * Decode the escape at s[i] into UTF-8 bytes in out, storing their count in
+ * *n.  Return the length of the escape.  An escape that is cut short or
+ * unknown stands for itself.
+ */
+static int decode_escape(const char *s, int len, int i, char *out, int *n);
+
+/**
+ * Return the value of the four hex digits at p, or -1.
+ */
+static long hex4(const char *p);
+
+/**
+ * Hash a primitive token.
+ */
+static uint64_t hash_primitive(jsmn_token_t *token);
+
+/**
+ * Split the len-byte number at s into num.  Return false if it is not a
+ * JSON number after all.
+ */
+static bool split_number(const char *s, int len, number_t *num);
+
+/**
+ * Hash a number by its value, however it is written.
+ */
+static uint64_t hash_number(const number_t *num);
+
+/**
+ * Hash the object at token i, whose members are already hashed.  Each key's
+ * hash is replaced by the hash of its whole member.
+ */
+static uint64_t hash_object(const jsmn_token_t *tokens, uint64_t *hashes,
+                            int i, unsigned int flags);
+
+/**
+ * Hash the array at token i, whose elements are already hashed.
+ */
+static uint64_t hash_array(const jsmn_token_t *tokens, const uint64_t *hashes,
+                           int i);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_hash_tokens(const jsmn_parser_t *parser, uint64_t *hashes,
+                     unsigned int num_hashes, unsigned int flags) {
+    jsmn_token_t *tokens = parser->tokens;
+    int count = (int)parser->token_count;
+
+    if (tokens == NULL) {
+        return JSMN_HASH_ERROR_INVAL;
+    }
+    if (num_hashes < parser->token_count) {
+        return JSMN_HASH_ERROR_NOMEM;
+    }
+    // children come after their container, so by the time a container is
+    // reached every value inside it has its hash
+    for (int i = count - 1; i >= 0; i--) {
+        jsmn_token_t *token = &tokens[i];
+        switch (token->type) {
+        case JSMN_OBJECT:
+            hashes[i] = hash_object(tokens, hashes, i, flags);
+            break;
+        case JSMN_ARRAY:
+            hashes[i] = hash_array(tokens, hashes, i);
+            break;
+        case JSMN_STRING:
+            hashes[i] = hash_string(token->start, token->strlen);
+            break;
+        default:
+            hashes[i] = hash_primitive(token);
+            break;
+        }
+    }
+    return count;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static uint64_t mix(uint64_t h, uint64_t word) {
+    h = (h ^ word) * HASH_PRIME;
+    return h ^ (h >> 32);
+}
+
+static uint64_t finish(uint64_t h) {
+    h ^= h >> 33;
+    h *= HASH_PRIME;
+    h ^= h >> 29;
+    return h;
+}
+
+static void stream_init(stream_t *st, tag_t tag) {
+    st->h = mix(HASH_SEED, tag);
+    st->fill = 0;
+    st->len = 0;
+}
+
+static void stream_bytes(stream_t *st, const char *p, size_t n) {
+    uint64_t word;
+
+    st->len += n;
+    while (n > 0 && st->fill != 0) {
+        st->word[st->fill++] = (unsigned char)*p++;
+        n--;
+        if (st->fill == sizeof(word)) {
+            memcpy(&word, st->word, sizeof(word));
+            st->h = mix(st->h, word);
+            st->fill = 0;
+        }
+    }
+    for (; n >= sizeof(word); p += sizeof(word), n -= sizeof(word)) {
+        memcpy(&word, p, sizeof(word));
+        st->h = mix(st->h, word);
+    }
+    if (n > 0) {
+        // the word was empty, or n would be 0
+        memcpy(st->word, p, n);
+        st->fill = (unsigned int)n;
+    }
+}
+
+static uint64_t stream_end(stream_t *st) {
+    uint64_t word = 0;
+
+    memcpy(&word, st->word, st->fill);
+    return finish(mix(mix(st->h, word), st->len));
+}
+
+static uint64_t hash_string(const char *s, int len) {
+    stream_t st;
+    char utf8[8];
+    int n;
+
+    stream_init(&st, TAG_STRING);
+    for (int i = 0; i < len;) {
+        const char *esc =
+            (const char *)memchr(&s[i], '\\', (size_t)(len - i));
+        int run = (esc == NULL) ? len - i : (int)(esc - &s[i]);
+        stream_bytes(&st, &s[i], (size_t)run);
+        i += run;
+        if (i < len) {
+            i += decode_escape(s, len, i, utf8, &n);
+            stream_bytes(&st, utf8, (size_t)n);
+        }
+    }
+    return stream_end(&st);
+}
+
+static int decode_escape(const char *s, int len, int i, char *out, int *n) {
+    static const char from[] = "\"\\/bfnrt";
+    static const char to[] = "\"\\/\b\f\n\r\t";
+    const char *c;
+    long u;
+    int used = 6;
+
+    if (i + 1 >= len) {
+        out[0] = s[i];
+        *n = 1;
+        return 1;
+    }
+    if (s[i + 1] != 'u') {
+        c = (s[i + 1] != '\0') ? strchr(from, s[i + 1]) : NULL;
+        if (c == NULL) {
+            out[0] = s[i];
+            out[1] = s[i + 1];
+            *n = 2;
+        } else {
+            out[0] = to[c - from];
+            *n = 1;
+        }
+        return 2;
+    }
+    if (i + 6 > len || (u = hex4(&s[i + 2])) < 0) {
+        out[0] = s[i];
+        *n = 1;
+        return 1;
+    }
+    if (u >= 0xd800 && u <= 0xdbff && i + 12 <= len && s[i + 6] == '\\' &&
+        s[i + 7] == 'u') {
+        long lo = hex4(&s[i + 8]);
+        if (lo >= 0xdc00 && lo <= 0xdfff) {
+            u = 0x10000 + ((u - 0xd800) << 10) + (lo - 0xdc00);
+            used = 12;
+        }
+    }
+    // UTF-8, as the same character would be written unescaped; a lone
+    // surrogate gets the three bytes it would have if it were allowed
+    if (u < 0x80) {
+        out[0] = (char)u;
+        *n = 1;
+    } else if (u < 0x800) {
+        out[0] = (char)(0xc0 | (u >> 6));
+        out[1] = (char)(0x80 | (u & 0x3f));
+        *n = 2;
+    } else if (u < 0x10000) {
+        out[0] = (char)(0xe0 | (u >> 12));
+        out[1] = (char)(0x80 | ((u >> 6) & 0x3f));
+        out[2] = (char)(0x80 | (u & 0x3f));
+        *n = 3;
+    } else {
+        out[0] = (char)(0xf0 | (u >> 18));
+        out[1] = (char)(0x80 | ((u >> 12) & 0x3f));
+        out[2] = (char)(0x80 | ((u >> 6) & 0x3f));
+        out[3] = (char)(0x80 | (u & 0x3f));
+        *n = 4;
+    }
+    return used;
+}
+
+static long hex4(const char *p) {
+    long u = 0;
+
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        int d;
+        if (c >= '0' && c <= '9') {
+            d = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            d = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            d = c - 'A' + 10;
+        } else {
+            return -1;
+        }
+        u = (u << 4) | d;
+    }
+    return u;
+}
+
+static uint64_t hash_primitive(jsmn_token_t *token) {
+    stream_t st;
+    number_t num;
+
+    switch (jsmn_token_class(token)) {
+    case JSMN_CLASS_TRUE:
+        return finish(mix(HASH_SEED, TAG_TRUE));
+    case JSMN_CLASS_FALSE:
+        return finish(mix(HASH_SEED, TAG_FALSE));
+    case JSMN_CLASS_NULL:
+        return finish(mix(HASH_SEED, TAG_NULL));
+    case JSMN_CLASS_INTEGER:
+    case JSMN_CLASS_FLOAT:
+        if (split_number(token->start, token->strlen, &num)) {
+            return hash_number(&num);
+        }
+        // fall through
+    default:
+        stream_init(&st, TAG_OTHER);
+        stream_bytes(&st, token->start, (size_t)token->strlen);
+        return stream_end(&st);
+    }
+}
+
+static bool split_number(const char *s, int len, number_t *num) {
+    const char *end = s + len;
+    int seen = 0;     // mantissa digits so far
+    int whole = -1;   // mantissa digits before the point
+    int first = 0;    // mantissa digits before the first significant one
+    int last = 0;     // mantissa digits up to the last significant one
+    long long exponent = 0;
+    bool negative_exponent = false;
+
+    num->negative = (s < end && *s == '-');
+    s += num->negative;
+    num->first = NULL;
+    num->last = NULL;
+    num->point = NULL;
+    for (; s < end && ((*s >= '0' && *s <= '9') || *s == '.'); s++) {
+        if (*s == '.') {
+            if (whole >= 0) {
+                return false;
+            }
+            whole = seen;
+            num->point = s;
+            continue;
+        }
+        seen++;
+        if (*s != '0') {
+            if (num->first == NULL) {
+                num->first = s;
+                first = seen - 1;
+            }
+            num->last = s;
+            last = seen;
+        }
+    }
+    if (seen == 0) {
+        return false;
+    }
+    if (whole < 0) {
+        whole = seen;
+    }
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        s++;
+        if (s < end && (*s == '+' || *s == '-')) {
+            negative_exponent = (*s++ == '-');
+        }
+        if (s == end) {
+            return false;
+        }
+        for (; s < end && *s >= '0' && *s <= '9'; s++) {
+            if (exponent < MAX_EXPONENT) {
+                exponent = exponent * 10 + (*s - '0');
+            }
+        }
+    }
+    if (s != end) {
+        return false;
+    }
+    if (num->first == NULL) {
+        num->digits = 0;
+        num->exponent = 0;
+        return true;
+    }
+    if (num->point != NULL &&
+        (num->point < num->first || num->point > num->last)) {
+        num->point = NULL; // not between the significant digits
+    }
+    num->digits = last - first;
+    num->exponent =
+        (negative_exponent ? -exponent : exponent) + whole - first;
+    return true;
+}
+
+static uint64_t hash_number(const number_t *num) {
+    stream_t st;
+    char buf[64];
+    uint64_t bits;
+    double value = 0; // 0 and -0 alike
+    int n = 0;
+
+    if (num->digits > MAX_EXACT_DIGITS ||
+        num->exponent > MAX_EXACT_EXPONENT ||
+        num->exponent < -MAX_EXACT_EXPONENT) {
+        // beyond what a double tells apart: hash the digits and exponent
+        stream_init(&st, TAG_NUMBER_TEXT);
+        stream_bytes(&st, num->negative ? "-" : "+", 1);
+        if (num->point != NULL) {
+            stream_bytes(&st, num->first, (size_t)(num->point - num->first));
+            stream_bytes(&st, num->point + 1,
+                         (size_t)(num->last - num->point));
+        } else {
+            stream_bytes(&st, num->first,
+                         (size_t)(num->last - num->first + 1));
+        }
+        n = snprintf(buf, sizeof(buf), "e%lld", num->exponent);
+        stream_bytes(&st, buf, (size_t)n);
+        return stream_end(&st);
+    }
+    if (num->digits > 0) {
+        buf[n++] = num->negative ? '-' : '+';
+        buf[n++] = '.';
+        for (const char *p = num->first; p <= num->last; p++) {
+            if (p != num->point) {
+                buf[n++] = *p;
+            }
+        }
+        snprintf(&buf[n], sizeof(buf) - (size_t)n, "e%lld", num->exponent);
+        value = strtod(buf, NULL);
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    return finish(mix(mix(HASH_SEED, TAG_NUMBER), bits));
+}
+
+static uint64_t hash_object(const jsmn_token_t *tokens, uint64_t *hashes,
+                            int i, unsigned int flags) {
+    uint64_t h = mix(HASH_SEED, TAG_OBJECT);
+    uint64_t sum = 0;
+    uint64_t n = 0;
+    int next;
+
+    for (int k = i + 1; k < tokens[i].end_index; k = next, n++) {
+        if (tokens[k].child_count != 0) {
+            hashes[k] = finish(
+                mix(mix(mix(HASH_SEED, TAG_MEMBER), hashes[k]), hashes[k + 1]));
+            next = tokens[k + 1].end_index;
+        } else {
+            // a key without a value (lenient parsers only)
+            next = tokens[k].end_index;
+        }
+        if (flags & JSMN_HASH_UNORDERED) {
+            sum += hashes[k];
+        } else {
+            h = mix(h, hashes[k]);
+        }
+    }
+    return finish(mix(mix(h, sum), n));
+}
+
+static uint64_t hash_array(const jsmn_token_t *tokens, const uint64_t *hashes,
+                           int i) {
+    uint64_t h = mix(HASH_SEED, TAG_ARRAY);
+    uint64_t n = 0;
+
+    for (int c = i + 1; c < tokens[i].end_index; c = tokens[c].end_index, n++) {
+        h = mix(h, hashes[c]);
+    }
+    return finish(mix(h, n));
+}
@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef JSMN_HASH_H
+#define JSMN_HASH_H
+
+#include "jsmn.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Subtree hashes: one 64-bit hash per token, covering the token and
+ * everything nested in it, so that two values (of one document or of two)
+ * can be compared by comparing their hashes, and a diff can skip equal
+ * subtrees without looking inside them.
+ *
+ * The hashes ignore how a value is written: whitespace, escapes in strings
+ * ("\u0041" and "A" hash alike) and the spelling of numbers (1, 1.0 and
+ * 1e0 hash alike, and so do 0 and -0).  Numbers are compared by their
+ * exact decimal value, so 1e20 and 100000000000000000000 hash alike while
+ * distinct large IDs stay apart.  Equal values always have equal hashes;
+ * different values have different hashes with all but negligible (2^-64)
+ * odds.  Unlike jsmn_canonicalize(), which rounds numbers to doubles,
+ * numbers with more than 15 significant digits that round to the same
+ * double still hash apart.
+ */
+
+/* Flags of jsmn_hash_tokens() */
+typedef enum {
+  /* Objects with the same members in any order hash alike */
+  JSMN_HASH_UNORDERED = 1 << 0
+} jsmn_hash_flag_t;
+
+typedef enum {
+  /* The hashes array is shorter than the token array */
+  JSMN_HASH_ERROR_NOMEM = -1,
+  /* The parser has no tokens */
+  JSMN_HASH_ERROR_INVAL = -2
+} jsmn_hash_err_t;
+
+/**
+ * @brief Hash every token of the last (successful) parse, in one pass from
+ * the last token to the first, storing the hash of token i in hashes[i].
+ * num_hashes is the length of hashes.  Returns the number of tokens hashed,
+ * JSMN_HASH_ERROR_NOMEM or JSMN_HASH_ERROR_INVAL.
+ *
+ * The hash of an object key covers the key and its value, i.e. the whole
+ * member; the value's own hash is the one after it.  flags is a set of
+ * jsmn_hash_flag_t.
+ */
+int jsmn_hash_tokens(const jsmn_parser_t *parser, uint64_t *hashes,
+                     unsigned int num_hashes, unsigned int flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_HASH_H */
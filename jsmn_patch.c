@@ -0,0 +1,885 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_patch.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/* Longest number text "test" compares by value; longer ones by text */
+#define MAX_NUMBER 63
+
+/* A location named by a JSON Pointer */
+typedef struct {
+    int parent;       // containing object or array, or -1 for the root
+    int target;       // the value at the location, or -1 if there is none
+    int key;          // the member's key token (objects only), or -1
+    int prev;         // value of the preceding member or element, or -1
+    int position;     // member or element number within parent
+    int count;        // members or elements in parent
+    const char *name; // last reference token, still ~-escaped
+    size_t name_len;
+} location_t;
+
+/* A member or element to be skipped while resolving a "move" target */
+typedef struct {
+    int parent;
+    int position;
+} removal_t;
+
+/* One splice: [from, to) of the document becomes pre name value post */
+typedef struct {
+    const char *from;
+    const char *to;
+    const char *pre;  // "," or NULL
+    const char *name; // member name to insert (~-escaped) or NULL
+    size_t name_len;
+    const char *value; // replacement value or NULL
+    size_t value_len;
+    const char *post; // "," or NULL
+} edit_t;
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Return the index of the first token after the subtree rooted at index.
+ */
+static int subtree_end(jsmn_parser_t *parser, int index);
+
+/**
+ * Return the first / one past the last char of a token's text, including the
+ * quotes around strings.
+ */
+static const char *token_begin(jsmn_token_t *token);
+static const char *token_end(jsmn_token_t *token);
+
+/**
+ * Write a token's text, including the quotes around strings.
+ */
+static int put_token(jsmn_writer_t *writer, jsmn_token_t *token);
+
+/**
+ * Return true if two tokens' text (quotes excluded) is identical.
+ */
+static bool same_text(jsmn_token_t *a, jsmn_token_t *b);
+
+/**
+ * Return true if two strings hold the same characters once their escapes
+ * are decoded, so "\u0041" and "A" are the same.
+ */
+static bool same_string(jsmn_token_t *a, jsmn_token_t *b);
+
+/**
+ * Return the code point at s[*i] (len bytes of string text), an escape
+ * decoded or a UTF-8 sequence, and move *i past it.
+ */
+static long next_code_point(const char *s, int len, int *i);
+
+/**
+ * Return the value of the four hex digits at p, or -1.
+ */
+static long hex4(const char *p);
+
+/**
+ * Read a number token into *value.  Return false if its text is too long.
+ */
+static bool token_number(jsmn_token_t *token, double *value);
+
+/**
+ * Return true if a token's text is exactly literal.
+ */
+static bool text_eq(jsmn_token_t *token, const char *literal);
+
+/**
+ * Return the value index of the member of object obj whose key holds the same
+ * characters as key (see same_string()), or -1.
+ */
+static int find_member(jsmn_parser_t *parser, int obj, jsmn_token_t *key);
+
+/**
+ * Return the value index of the member named name in object obj of patch, or
+ * -1.  name is the token text of a JSON string, e.g. "op".
+ */
+static int find_field(jsmn_parser_t *patch, int obj, const char *name);
+
+/**
+ * Recursive step of jsmn_merge_patch(): write target (a value index of doc,
+ * or -1 if there is none) merged with the patch value at p.
+ */
+static int merge(jsmn_parser_t *doc, int target, jsmn_parser_t *patch, int p,
+                 jsmn_writer_t *writer, int depth);
+
+/**
+ * Resolve a JSON Pointer (the text of a JSON string) against doc.  If
+ * removal is not NULL, array indices are interpreted as if that element had
+ * already been removed.
+ */
+static int resolve(jsmn_parser_t *doc, jsmn_token_t *pointer,
+                   const removal_t *removal, location_t *loc);
+
+/**
+ * Return true if the pointer text a names the same location as b or a
+ * location inside it.
+ */
+static bool pointer_within(jsmn_token_t *a, jsmn_token_t *b);
+
+/**
+ * Compare a key token with a ~-escaped reference token.
+ */
+static bool name_eq(jsmn_token_t *key, const char *name, size_t len);
+
+/**
+ * Fill an edit that deletes the member or element at loc.
+ */
+static void remove_edit(jsmn_parser_t *doc, const location_t *loc,
+                        edit_t *edit);
+
+/**
+ * Fill an edit that puts value at loc, inserting or replacing as "add" does.
+ * count is the number of members or elements the parent will have once any
+ * pending removal from it is done.
+ */
+static void add_edit(jsmn_parser_t *doc, const location_t *loc, int count,
+                     jsmn_token_t *value, edit_t *edit);
+
+/**
+ * Fill an edit that replaces the existing value at loc with value.
+ */
+static void replace_edit(jsmn_parser_t *doc, const location_t *loc,
+                         jsmn_token_t *value, edit_t *edit);
+
+/**
+ * Write the document with the edits spliced in.
+ */
+static int apply_edits(jsmn_parser_t *doc, edit_t *edits, int n,
+                       jsmn_writer_t *writer);
+
+/**
+ * Return true if two values are equal in the sense of the "test" operation.
+ */
+static bool values_equal(jsmn_parser_t *pa, int a, jsmn_parser_t *pb, int b);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_merge_patch(jsmn_parser_t *doc, jsmn_parser_t *patch,
+                     jsmn_writer_t *writer) {
+    if (jsmn_token_ref(patch, 0) == NULL) {
+        return JSMN_PATCH_ERROR_INVAL;
+    }
+    return merge(doc, jsmn_token_ref(doc, 0) ? 0 : -1, patch, 0, writer, 0);
+}
+
+int jsmn_json_patch_op(jsmn_parser_t *doc, jsmn_parser_t *patch, int op_index,
+                       jsmn_writer_t *writer) {
+    jsmn_token_t *op;
+    jsmn_token_t *path;
+    jsmn_token_t *from = NULL;
+    jsmn_token_t *value = NULL;
+    location_t loc;
+    location_t src;
+    edit_t edits[2];
+    int n = 0;
+    int i = -1; // index of the "value" member
+    int r;
+
+    if (!jsmn_token_is_object(jsmn_token_ref(patch, op_index))) {
+        return JSMN_PATCH_ERROR_INVAL;
+    }
+    op = jsmn_token_ref(patch, find_field(patch, op_index, "op"));
+    path = jsmn_token_ref(patch, find_field(patch, op_index, "path"));
+    if (!jsmn_token_is_string(op) || !jsmn_token_is_string(path)) {
+        return JSMN_PATCH_ERROR_INVAL;
+    }
+    if (text_eq(op, "move") || text_eq(op, "copy")) {
+        from = jsmn_token_ref(patch, find_field(patch, op_index, "from"));
+        if (!jsmn_token_is_string(from)) {
+            return JSMN_PATCH_ERROR_INVAL;
+        }
+        if ((r = resolve(doc, from, NULL, &src)) < 0) {
+            return r;
+        }
+        if (src.target < 0) {
+            return JSMN_PATCH_ERROR_PATH;
+        }
+        value = jsmn_token_ref(doc, src.target);
+    } else if (!text_eq(op, "remove")) {
+        i = find_field(patch, op_index, "value");
+        if (i < 0) {
+            return JSMN_PATCH_ERROR_INVAL;
+        }
+        value = jsmn_token_ref(patch, i);
+    }
+
+    if (text_eq(op, "move")) {
+        removal_t removal;
+
+        if (same_text(from, path)) {
+            // moving a value onto itself changes nothing
+            return apply_edits(doc, edits, 0, writer);
+        }
+        if (pointer_within(path, from) || src.parent < 0) {
+            // can't move a value into itself
+            return JSMN_PATCH_ERROR_INVAL;
+        }
+        removal.parent = src.parent;
+        removal.position = src.position;
+        if ((r = resolve(doc, path, &removal, &loc)) < 0) {
+            return r;
+        }
+        if (loc.target < 0 && loc.position > loc.count) {
+            return JSMN_PATCH_ERROR_PATH;
+        }
+        if (loc.parent < 0 && loc.target >= 0) {
+            // the whole document is replaced; the removal is moot
+            add_edit(doc, &loc, loc.count, value, &edits[n++]);
+        } else {
+            remove_edit(doc, &src, &edits[n++]);
+            add_edit(doc, &loc,
+                     loc.parent == src.parent ? loc.count - 1 : loc.count,
+                     value, &edits[n]);
+            if (edits[n].from <= edits[0].from && edits[n].to >= edits[0].to) {
+                // the replaced value contains the removed one
+                edits[0] = edits[n];
+            } else {
+                n++;
+            }
+        }
+        return apply_edits(doc, edits, n, writer);
+    }
+
+    if ((r = resolve(doc, path, NULL, &loc)) < 0) {
+        return r;
+    }
+    if (text_eq(op, "add") || text_eq(op, "copy")) {
+        if (loc.target < 0 && loc.position > loc.count) {
+            // array index past the end
+            return JSMN_PATCH_ERROR_PATH;
+        }
+        add_edit(doc, &loc, loc.count, value, &edits[n++]);
+    } else if (loc.target < 0) {
+        return JSMN_PATCH_ERROR_PATH;
+    } else if (text_eq(op, "remove")) {
+        if (loc.parent < 0) {
+            return JSMN_PATCH_ERROR_INVAL;
+        }
+        remove_edit(doc, &loc, &edits[n++]);
+    } else if (text_eq(op, "replace")) {
+        replace_edit(doc, &loc, value, &edits[n++]);
+    } else if (text_eq(op, "test")) {
+        if (!values_equal(doc, loc.target, patch, i)) {
+            return JSMN_PATCH_ERROR_TEST;
+        }
+    } else {
+        return JSMN_PATCH_ERROR_INVAL;
+    }
+    return apply_edits(doc, edits, n, writer);
+}
+
+int jsmn_json_patch(jsmn_parser_t *doc, jsmn_parser_t *patch, char *scratch,
+                    size_t scratch_size, jsmn_token_t *tokens,
+                    unsigned int num_tokens, jsmn_writer_t *writer) {
+    jsmn_token_t *ops = jsmn_token_ref(patch, 0);
+    jsmn_parser_t parser;
+    jsmn_parser_t *current = doc;
+    size_t half = scratch_size / 2;
+    int op = 1;
+    int i;
+
+    if (!jsmn_token_is_array(ops)) {
+        return JSMN_PATCH_ERROR_INVAL;
+    }
+    if (ops->child_count == 0) {
+        return apply_edits(doc, NULL, 0, writer);
+    }
+    for (i = 0; i < ops->child_count - 1; i++) {
+        // intermediate results alternate between the two halves of scratch
+        char *buf = &scratch[(i % 2) * half];
+        jsmn_writer_t w;
+        int r;
+
+        jsmn_writer_init(&w, buf, half, NULL, NULL);
+        r = jsmn_json_patch_op(current, patch, op, &w);
+        if (r < 0) {
+            return r == JSMN_WRITER_ERROR_NOMEM ? JSMN_PATCH_ERROR_NOMEM : r;
+        }
+        jsmn_init(&parser, tokens, num_tokens);
+        r = jsmn_parse(&parser, buf, w.len);
+        if (r < 0) {
+            return r == JSMN_ERROR_NOMEM ? JSMN_PATCH_ERROR_NOMEM
+                                         : JSMN_PATCH_ERROR_INVAL;
+        }
+        current = &parser;
+        op = subtree_end(patch, op);
+    }
+    return jsmn_json_patch_op(current, patch, op, writer);
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static int subtree_end(jsmn_parser_t *parser, int index) {
+    int pending = 1;
+
+    while (pending > 0) {
+        jsmn_token_t *token = jsmn_token_ref(parser, index);
+        if (token == NULL) {
+            break;
+        }
+        pending += token->child_count - 1;
+        index++;
+    }
+    return index;
+}
+
+static const char *token_begin(jsmn_token_t *token) {
+    return jsmn_token_is_string(token) ? token->start - 1 : token->start;
+}
+
+static const char *token_end(jsmn_token_t *token) {
+    return token->start + token->strlen + (jsmn_token_is_string(token) ? 1 : 0);
+}
+
+static int put_token(jsmn_writer_t *writer, jsmn_token_t *token) {
+    const char *begin = token_begin(token);
+    return jsmn_writer_write(writer, begin, token_end(token) - begin);
+}
+
+static bool same_text(jsmn_token_t *a, jsmn_token_t *b) {
+    return a->strlen == b->strlen && memcmp(a->start, b->start, a->strlen) == 0;
+}
+
+static bool same_string(jsmn_token_t *a, jsmn_token_t *b) {
+    int i = 0;
+    int j = 0;
+
+    if (same_text(a, b)) {
+        return true;
+    }
+    if (memchr(a->start, '\\', (size_t)a->strlen) == NULL &&
+        memchr(b->start, '\\', (size_t)b->strlen) == NULL) {
+        return false;
+    }
+    while (i < a->strlen && j < b->strlen) {
+        if (next_code_point(a->start, a->strlen, &i) !=
+            next_code_point(b->start, b->strlen, &j)) {
+            return false;
+        }
+    }
+    return i == a->strlen && j == b->strlen;
+}
+
+static long next_code_point(const char *s, int len, int *i) {
+    unsigned char c = (unsigned char)s[*i];
+    long u;
+    int n;
+
+    if (c == '\\' && *i + 1 < len) {
+        char e = s[*i + 1];
+        *i += 2;
+        switch (e) {
+        case 'b':
+            return '\b';
+        case 'f':
+            return '\f';
+        case 'n':
+            return '\n';
+        case 'r':
+            return '\r';
+        case 't':
+            return '\t';
+        case 'u':
+            if (*i + 4 > len || (u = hex4(&s[*i])) < 0) {
+                return 'u'; // cut short: stands for itself
+            }
+            *i += 4;
+            if (u >= 0xd800 && u < 0xdc00 && *i + 6 <= len &&
+                s[*i] == '\\' && s[*i + 1] == 'u') {
+                long lo = hex4(&s[*i + 2]);
+                if (lo >= 0xdc00 && lo < 0xe000) {
+                    *i += 6;
+                    u = 0x10000 + ((u - 0xd800) << 10) + (lo - 0xdc00);
+                }
+            }
+            return u;
+        default:
+            return (unsigned char)e; // '"', '\\' and '/' stand for themselves
+        }
+    }
+    n = (c >= 0xf0) ? 4 : (c >= 0xe0) ? 3 : (c >= 0xc0) ? 2 : 1;
+    if (*i + n > len) {
+        n = 1;
+    }
+    u = (n == 1) ? c : c & (0x7f >> n);
+    for (int k = 1; k < n; k++) {
+        u = (u << 6) | ((unsigned char)s[*i + k] & 0x3f);
+    }
+    *i += n;
+    return u;
+}
+
+static long hex4(const char *p) {
+    long u = 0;
+
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        int d;
+        if (c >= '0' && c <= '9') {
+            d = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            d = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            d = c - 'A' + 10;
+        } else {
+            return -1;
+        }
+        u = (u << 4) | d;
+    }
+    return u;
+}
+
+static bool token_number(jsmn_token_t *token, double *value) {
+    char buf[MAX_NUMBER + 1];
+
+    if (token->strlen > MAX_NUMBER) {
+        return false;
+    }
+    memcpy(buf, token->start, (size_t)token->strlen);
+    buf[token->strlen] = '\0';
+    *value = strtod(buf, NULL);
+    return true;
+}
+
+static bool text_eq(jsmn_token_t *token, const char *literal) {
+    size_t len = strlen(literal);
+    return (size_t)token->strlen == len && memcmp(token->start, literal, len) == 0;
+}
+
+static int find_member(jsmn_parser_t *parser, int obj, jsmn_token_t *key) {
+    jsmn_token_t *token = jsmn_token_ref(parser, obj);
+    int k = obj + 1;
+    int i;
+
+    for (i = 0; i < token->child_count; i++) {
+        jsmn_token_t *other = jsmn_token_ref(parser, k);
+        if (other == NULL) {
+            break;
+        }
+        if (same_string(other, key)) {
+            return k + 1;
+        }
+        k = subtree_end(parser, k + 1);
+    }
+    return -1;
+}
+
+static int find_field(jsmn_parser_t *patch, int obj, const char *name) {
+    jsmn_token_t key;
+
+    key.type = JSMN_STRING;
+    key.start = name;
+    key.strlen = strlen(name);
+    return find_member(patch, obj, &key);
+}
+
+static int merge(jsmn_parser_t *doc, int target, jsmn_parser_t *patch, int p,
+                 jsmn_writer_t *writer, int depth) {
+    jsmn_token_t *ptok = jsmn_token_ref(patch, p);
+    jsmn_token_t *ttok = jsmn_token_ref(doc, target);
+    bool first = true;
+    int pk;
+    int i;
+
+    if (!jsmn_token_is_object(ptok)) {
+        // anything but an object replaces the target outright
+        return put_token(writer, ptok);
+    }
+    if (depth >= JSMN_WRITER_MAX_DEPTH) {
+        return JSMN_PATCH_ERROR_INVAL;
+    }
+    if (jsmn_writer_write(writer, "{", 1) < 0) {
+        return writer->error;
+    }
+
+    if (jsmn_token_is_object(ttok)) {
+        // Copy the target's members, runs of untouched ones as one span
+        const char *run = NULL;
+        const char *run_end = NULL;
+        int k = target + 1;
+
+        for (i = 0; i < ttok->child_count; i++) {
+            jsmn_token_t *key = jsmn_token_ref(doc, k);
+            int next = subtree_end(doc, k + 1);
+            int pv = find_member(patch, p, key);
+
+            if (pv < 0) {
+                if (run == NULL) {
+                    run = token_begin(key);
+                }
+                run_end = token_end(jsmn_token_ref(doc, k + 1));
+            } else {
+                if (run != NULL) {
+                    if ((!first && jsmn_writer_write(writer, ",", 1) < 0) ||
+                        jsmn_writer_write(writer, run, run_end - run) < 0) {
+                        return writer->error;
+                    }
+                    first = false;
+                    run = NULL;
+                }
+                if (!jsmn_token_is_null(jsmn_token_ref(patch, pv))) {
+                    int r;
+                    if ((!first && jsmn_writer_write(writer, ",", 1) < 0) ||
+                        put_token(writer, key) < 0 ||
+                        jsmn_writer_write(writer, ":", 1) < 0) {
+                        return writer->error;
+                    }
+                    first = false;
+                    r = merge(doc, k + 1, patch, pv, writer, depth + 1);
+                    if (r < 0) {
+                        return r;
+                    }
+                }
+            }
+            k = next;
+        }
+        if (run != NULL) {
+            if ((!first && jsmn_writer_write(writer, ",", 1) < 0) ||
+                jsmn_writer_write(writer, run, run_end - run) < 0) {
+                return writer->error;
+            }
+            first = false;
+        }
+    }
+
+    // Members the target doesn't have yet
+    pk = p + 1;
+    for (i = 0; i < ptok->child_count; i++) {
+        jsmn_token_t *key = jsmn_token_ref(patch, pk);
+        int pv = pk + 1;
+
+        if (!jsmn_token_is_null(jsmn_token_ref(patch, pv)) &&
+            (!jsmn_token_is_object(ttok) || find_member(doc, target, key) < 0)) {
+            int r;
+            if ((!first && jsmn_writer_write(writer, ",", 1) < 0) ||
+                put_token(writer, key) < 0 ||
+                jsmn_writer_write(writer, ":", 1) < 0) {
+                return writer->error;
+            }
+            first = false;
+            r = merge(doc, -1, patch, pv, writer, depth + 1);
+            if (r < 0) {
+                return r;
+            }
+        }
+        pk = subtree_end(patch, pv);
+    }
+    return jsmn_writer_write(writer, "}", 1);
+}
+
+static int resolve(jsmn_parser_t *doc, jsmn_token_t *pointer,
+                   const removal_t *removal, location_t *loc) {
+    const char *p = pointer->start;
+    const char *end = pointer->start + pointer->strlen;
+    int current = 0;
+
+    loc->parent = -1;
+    loc->target = 0;
+    loc->key = -1;
+    loc->prev = -1;
+    loc->position = 0;
+    loc->count = 1;
+    loc->name = NULL;
+    loc->name_len = 0;
+    if (jsmn_token_ref(doc, 0) == NULL) {
+        return JSMN_PATCH_ERROR_PATH;
+    }
+    if (p < end && *p != '/') {
+        return JSMN_PATCH_ERROR_INVAL;
+    }
+
+    while (p < end) {
+        jsmn_token_t *container = jsmn_token_ref(doc, current);
+        const char *name = p + 1;
+        const char *name_end = memchr(name, '/', end - name);
+        int child = current + 1;
+        int i;
+
+        if (name_end == NULL) {
+            name_end = end;
+        }
+        if (container == NULL) {
+            // an intermediate location doesn't exist
+            return JSMN_PATCH_ERROR_PATH;
+        }
+        loc->parent = current;
+        loc->target = -1;
+        loc->key = -1;
+        loc->prev = -1;
+        loc->count = container->child_count;
+        loc->name = name;
+        loc->name_len = name_end - name;
+
+        if (jsmn_token_is_object(container)) {
+            for (i = 0; i < container->child_count; i++) {
+                if (name_eq(jsmn_token_ref(doc, child), name, loc->name_len)) {
+                    loc->key = child;
+                    loc->target = child + 1;
+                    break;
+                }
+                loc->prev = child + 1;
+                child = subtree_end(doc, child + 1);
+            }
+            loc->position = i;
+        } else if (jsmn_token_is_array(container)) {
+            int index = 0;
+            const char *q;
+
+            if (loc->name_len == 1 && *name == '-') {
+                index = container->child_count;
+            } else {
+                if (loc->name_len == 0 ||
+                    (*name == '0' && loc->name_len > 1)) {
+                    return JSMN_PATCH_ERROR_INVAL;
+                }
+                for (q = name; q < name_end; q++) {
+                    if (*q < '0' || *q > '9' || index > 100000000) {
+                        return JSMN_PATCH_ERROR_INVAL;
+                    }
+                    index = index * 10 + (*q - '0');
+                }
+                if (removal != NULL && removal->parent == current &&
+                    index >= removal->position) {
+                    // skip over the element that is being moved away
+                    index++;
+                }
+            }
+            for (i = 0; i < index && i < container->child_count; i++) {
+                loc->prev = child;
+                child = subtree_end(doc, child);
+            }
+            loc->position = index;
+            if (index < container->child_count) {
+                loc->target = child;
+            }
+        } else {
+            return JSMN_PATCH_ERROR_PATH;
+        }
+        current = loc->target;
+        p = name_end;
+    }
+    return 0;
+}
+
+static bool pointer_within(jsmn_token_t *a, jsmn_token_t *b) {
+    return a->strlen > b->strlen && memcmp(a->start, b->start, b->strlen) == 0 &&
+           a->start[b->strlen] == '/';
+}
+
+static bool name_eq(jsmn_token_t *key, const char *name, size_t len) {
+    const char *k = key->start;
+    const char *k_end = key->start + key->strlen;
+    const char *end = name + len;
+
+    while (name < end) {
+        char c = *name++;
+        if (c == '~' && name < end) {
+            c = (*name++ == '0') ? '~' : '/';
+        }
+        if (k == k_end || *k++ != c) {
+            return false;
+        }
+    }
+    return k == k_end;
+}
+
+static void remove_edit(jsmn_parser_t *doc, const location_t *loc,
+                        edit_t *edit) {
+    jsmn_token_t *target = jsmn_token_ref(doc, loc->target);
+
+    memset(edit, 0, sizeof(*edit));
+    edit->from = token_begin(jsmn_token_ref(doc, loc->key >= 0 ? loc->key
+                                                                : loc->target));
+    edit->to = token_end(target);
+    if (loc->position < loc->count - 1) {
+        // up to the next member, taking the comma with it
+        edit->to = token_begin(
+            jsmn_token_ref(doc, subtree_end(doc, loc->target)));
+    } else if (loc->prev >= 0) {
+        // last of several: take the comma in front of it
+        edit->from = token_end(jsmn_token_ref(doc, loc->prev));
+    }
+}
+
+static void add_edit(jsmn_parser_t *doc, const location_t *loc, int count,
+                     jsmn_token_t *value, edit_t *edit) {
+    jsmn_token_t *parent = jsmn_token_ref(doc, loc->parent);
+
+    if (loc->target >= 0 &&
+        (parent == NULL || jsmn_token_is_object(parent))) {
+        // an existing member (or the whole document) is replaced
+        replace_edit(doc, loc, value, edit);
+        return;
+    }
+    memset(edit, 0, sizeof(*edit));
+    edit->value = token_begin(value);
+    edit->value_len = token_end(value) - edit->value;
+    if (loc->target >= 0) {
+        // insert in front of an existing element
+        edit->from = edit->to = token_begin(jsmn_token_ref(doc, loc->target));
+        edit->post = ",";
+    } else {
+        // append just before the closing bracket
+        edit->from = edit->to = parent->start + parent->strlen - 1;
+        edit->pre = count > 0 ? "," : NULL;
+        if (jsmn_token_is_object(parent)) {
+            edit->name = loc->name;
+            edit->name_len = loc->name_len;
+        }
+    }
+}
+
+static void replace_edit(jsmn_parser_t *doc, const location_t *loc,
+                         jsmn_token_t *value, edit_t *edit) {
+    jsmn_token_t *target = jsmn_token_ref(doc, loc->target);
+
+    memset(edit, 0, sizeof(*edit));
+    edit->from = token_begin(target);
+    edit->to = token_end(target);
+    edit->value = token_begin(value);
+    edit->value_len = token_end(value) - edit->value;
+}
+
+static int apply_edits(jsmn_parser_t *doc, edit_t *edits, int n,
+                       jsmn_writer_t *writer) {
+    jsmn_token_t *root = jsmn_token_ref(doc, 0);
+    const char *pos;
+    int i;
+
+    if (root == NULL) {
+        return JSMN_PATCH_ERROR_PATH;
+    }
+    if (n == 2 && (edits[1].from < edits[0].from ||
+                   (edits[1].from == edits[0].from &&
+                    edits[1].from == edits[1].to))) {
+        // in document order, insertions first
+        edit_t tmp = edits[0];
+        edits[0] = edits[1];
+        edits[1] = tmp;
+    }
+    pos = token_begin(root);
+    for (i = 0; i < n; i++) {
+        edit_t *e = &edits[i];
+
+        if (jsmn_writer_write(writer, pos, e->from - pos) < 0 ||
+            (e->pre && jsmn_writer_write(writer, e->pre, 1) < 0)) {
+            return writer->error;
+        }
+        if (e->name != NULL) {
+            // decode ~0 and ~1, the rest is already JSON string text
+            const char *s = e->name;
+            const char *end = e->name + e->name_len;
+
+            if (jsmn_writer_write(writer, "\"", 1) < 0) {
+                return writer->error;
+            }
+            while (s < end) {
+                const char *tilde = memchr(s, '~', end - s);
+                if (tilde == NULL || tilde + 1 == end) {
+                    tilde = end;
+                }
+                if (jsmn_writer_write(writer, s, tilde - s) < 0) {
+                    return writer->error;
+                }
+                if (tilde < end &&
+                    jsmn_writer_write(writer, tilde[1] == '0' ? "~" : "/",
+                                      1) < 0) {
+                    return writer->error;
+                }
+                s = tilde + 2;
+            }
+            if (jsmn_writer_write(writer, "\":", 2) < 0) {
+                return writer->error;
+            }
+        }
+        if ((e->value &&
+             jsmn_writer_write(writer, e->value, e->value_len) < 0) ||
+            (e->post && jsmn_writer_write(writer, e->post, 1) < 0)) {
+            return writer->error;
+        }
+        pos = e->to;
+    }
+    return jsmn_writer_write(writer, pos, token_end(root) - pos);
+}
+
+static bool values_equal(jsmn_parser_t *pa, int a, jsmn_parser_t *pb, int b) {
+    jsmn_token_t *ta = jsmn_token_ref(pa, a);
+    jsmn_token_t *tb = jsmn_token_ref(pb, b);
+    double va;
+    double vb;
+    int i;
+
+    if (ta == NULL || tb == NULL || ta->type != tb->type) {
+        return false;
+    }
+    if (jsmn_token_is_number(ta) && jsmn_token_is_number(tb) &&
+        token_number(ta, &va) && token_number(tb, &vb)) {
+        // 1 and 1.0 are the same number
+        return va == vb;
+    }
+    if (jsmn_token_is_string(ta)) {
+        return same_string(ta, tb);
+    }
+    if (!jsmn_token_is_object(ta) && !jsmn_token_is_array(ta)) {
+        return same_text(ta, tb);
+    }
+    if (ta->child_count != tb->child_count) {
+        return false;
+    }
+    if (jsmn_token_is_array(ta)) {
+        a++;
+        b++;
+        for (i = 0; i < ta->child_count; i++) {
+            if (!values_equal(pa, a, pb, b)) {
+                return false;
+            }
+            a = subtree_end(pa, a);
+            b = subtree_end(pb, b);
+        }
+        return true;
+    }
+    // objects: members may come in any order
+    for (i = 0, a = a + 1; i < ta->child_count; i++) {
+        int other = find_member(pb, tb - pb->tokens, jsmn_token_ref(pa, a));
+        if (other < 0 || !values_equal(pa, a + 1, pb, other)) {
+            return false;
+        }
+        a = subtree_end(pa, a + 1);
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_PATCH_H
+#define JSMN_PATCH_H
+
+#include "jsmn.h"
+#include "jsmn_writer.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Patch errors.  They don't overlap jsmn_writer_err_t, which the patch
+ * functions also return when writing the output fails.
+ */
+typedef enum {
+  /* The patch is not a valid merge patch or JSON Patch document */
+  JSMN_PATCH_ERROR_INVAL = -4,
+  /* A path or "from" location does not exist in the document */
+  JSMN_PATCH_ERROR_PATH = -5,
+  /* A "test" operation did not match */
+  JSMN_PATCH_ERROR_TEST = -6,
+  /* Scratch space for intermediate results is too small */
+  JSMN_PATCH_ERROR_NOMEM = -7
+} jsmn_patch_err_t;
+
+/**
+ * @brief Apply an RFC 7396 merge patch.  doc and patch hold parsed documents;
+ * the patched document is written to writer.  Members the patch doesn't touch
+ * are copied verbatim from the document text, runs of them in a single span.
+ * Member names are compared in their escaped form.  Returns 0 or a negative
+ * jsmn_patch_err_t / jsmn_writer_err_t.
+ */
+int jsmn_merge_patch(jsmn_parser_t *doc, jsmn_parser_t *patch,
+                     jsmn_writer_t *writer);
+
+/**
+ * @brief Apply the single RFC 6902 operation at token op_index of patch (one
+ * object from the patch array) to doc, writing the result to writer.  The
+ * document text is copied around the edited spans.  Returns 0 or a negative
+ * jsmn_patch_err_t / jsmn_writer_err_t.
+ */
+int jsmn_json_patch_op(jsmn_parser_t *doc, jsmn_parser_t *patch, int op_index,
+                       jsmn_writer_t *writer);
+
+/**
+ * @brief Apply a whole RFC 6902 patch (an array of operations) to doc,
+ * writing the result to writer.  Operations apply in sequence, so every
+ * intermediate result is kept in scratch, which must hold two of them, and
+ * re-tokenized into tokens.  A single-operation patch needs no scratch.
+ * Returns 0 or a negative jsmn_patch_err_t / jsmn_writer_err_t.
+ */
+int jsmn_json_patch(jsmn_parser_t *doc, jsmn_parser_t *patch, char *scratch,
+                    size_t scratch_size, jsmn_token_t *tokens,
+                    unsigned int num_tokens, jsmn_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_PATCH_H */
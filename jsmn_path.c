@@ -0,0 +1,602 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_path.h"
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/* Longest number text converted for a filter comparison */
+#define MAX_NUMBER 63
+
+/* Expression being compiled */
+typedef struct {
+    const char *p;        // next character
+    jsmn_path_op_t *code; // output
+    int count;            // instructions emitted
+    int size;             // room in code
+} compiler_t;
+
+/* Evaluation in progress */
+typedef struct {
+    const jsmn_path_t *path;
+    jsmn_parser_t *parser;
+    int *matches;
+    int max_matches;
+    int count; // matches found
+} eval_t;
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Append an instruction.  Return it, or NULL if code is full.
+ */
+static jsmn_path_op_t *emit(compiler_t *c, jsmn_path_opcode_t op);
+
+/**
+ * Compile one selector after `.`: a name or `*`.
+ */
+static int compile_dot(compiler_t *c);
+
+/**
+ * Compile one bracketed selector, from just inside the `[`.
+ */
+static int compile_bracket(compiler_t *c);
+
+/**
+ * Compile a filter, from just after the `?`.
+ */
+static int compile_filter(compiler_t *c);
+
+/**
+ * Compile the literal of a filter comparison into op.
+ */
+static int compile_literal(compiler_t *c, jsmn_path_op_t *op);
+
+/**
+ * Read a quoted name at c->p into op->name / op->len.
+ */
+static int read_quoted(compiler_t *c, jsmn_path_op_t *op);
+
+/**
+ * Read an optionally signed integer.  Return false if there is none.
+ */
+static bool read_int(compiler_t *c, int *value);
+
+static void skip_space(compiler_t *c);
+
+/**
+ * Step over ch if it is next.  Return false, without moving, if it is not.
+ */
+static bool expect(compiler_t *c, char ch);
+
+/**
+ * Continue the evaluation at instruction pc with token as the current node.
+ */
+static void run(eval_t *e, int pc, int token);
+
+/**
+ * Apply the selector at pc to token, continuing with each node it selects.
+ */
+static void select_children(eval_t *e, int pc, int token);
+
+/**
+ * Return the index of the instruction after the one at pc.
+ */
+static int next_pc(const jsmn_path_t *path, int pc);
+
+/**
+ * Return the value of member name (len bytes) of the object at index, or -1.
+ */
+static int find_member(jsmn_parser_t *parser, int index, const char *name,
+                       int len);
+
+/**
+ * Return true if the child of a filter at pc passes its test.
+ */
+static bool test_filter(eval_t *e, int pc, int child);
+
+/**
+ * Compare token with the literal of the filter op.
+ */
+static bool compare(jsmn_parser_t *parser, int token, const jsmn_path_op_t *op);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_path_compile(jsmn_path_t *path, const char *expr,
+                      jsmn_path_op_t *code, int code_size) {
+    compiler_t c = {expr, code, 0, code_size};
+    int r = 0;
+
+    if (!expect(&c, '$')) {
+        return JSMN_PATH_ERROR_INVAL;
+    }
+    while (r == 0 && *c.p != '\0') {
+        if (c.p[0] == '.' && c.p[1] == '.') {
+            c.p += 2;
+            if (emit(&c, JSMN_PATH_OP_DESCEND) == NULL) {
+                return JSMN_PATH_ERROR_NOMEM;
+            }
+            if (*c.p == '[') {
+                c.p++;
+                r = compile_bracket(&c);
+            } else {
+                r = compile_dot(&c);
+            }
+        } else if (*c.p == '.') {
+            c.p++;
+            r = compile_dot(&c);
+        } else if (*c.p == '[') {
+            c.p++;
+            r = compile_bracket(&c);
+        } else {
+            r = JSMN_PATH_ERROR_INVAL;
+        }
+    }
+    if (r < 0) {
+        return r;
+    }
+    path->code = code;
+    path->count = c.count;
+    return c.count;
+}
+
+int jsmn_path_eval(const jsmn_path_t *path, jsmn_parser_t *parser, int root,
+                   int *matches, int max_matches) {
+    eval_t e = {path, parser, matches, max_matches, 0};
+
+    if (jsmn_token_ref(parser, root) == NULL) {
+        return 0;
+    }
+    run(&e, 0, root);
+    return e.count;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static jsmn_path_op_t *emit(compiler_t *c, jsmn_path_opcode_t op) {
+    if (c->count >= c->size) {
+        return NULL;
+    }
+    jsmn_path_op_t *ins = &c->code[c->count++];
+    memset(ins, 0, sizeof(*ins));
+    ins->op = (unsigned char)op;
+    return ins;
+}
+
+static int compile_dot(compiler_t *c) {
+    if (*c->p == '*') {
+        c->p++;
+        return emit(c, JSMN_PATH_OP_WILDCARD) ? 0 : JSMN_PATH_ERROR_NOMEM;
+    }
+    const char *name = c->p;
+    // a name runs to the next selector, or the operator or end of a filter
+    while (*c->p != '\0' && strchr(".[]()=!<> ", *c->p) == NULL) {
+        c->p++;
+    }
+    if (c->p == name) {
+        return JSMN_PATH_ERROR_INVAL;
+    }
+    jsmn_path_op_t *op = emit(c, JSMN_PATH_OP_CHILD);
+    if (op == NULL) {
+        return JSMN_PATH_ERROR_NOMEM;
+    }
+    op->name = name;
+    op->len = (int)(c->p - name);
+    return 0;
+}
+
+static int compile_bracket(compiler_t *c) {
+    jsmn_path_op_t *op;
+    int r = 0;
+
+    skip_space(c);
+    if (*c->p == '*') {
+        c->p++;
+        op = emit(c, JSMN_PATH_OP_WILDCARD);
+    } else if (*c->p == '\'' || *c->p == '"') {
+        op = emit(c, JSMN_PATH_OP_CHILD);
+        r = (op == NULL) ? 0 : read_quoted(c, op);
+    } else if (*c->p == '?') {
+        c->p++;
+        return compile_filter(c);
+    } else {
+        int start = 0;
+        bool has_start = read_int(c, &start);
+        skip_space(c);
+        if (*c->p != ':') {
+            if (!has_start) {
+                return JSMN_PATH_ERROR_INVAL;
+            }
+            op = emit(c, JSMN_PATH_OP_INDEX);
+            if (op != NULL) {
+                op->start = start;
+            }
+        } else {
+            c->p++;
+            op = emit(c, JSMN_PATH_OP_SLICE);
+            if (op != NULL) {
+                op->start = start;
+                op->end = read_int(c, &op->end) ? op->end : INT_MAX;
+                op->step = 1;
+                skip_space(c);
+                if (*c->p == ':') {
+                    c->p++;
+                    if (read_int(c, &op->step) && op->step <= 0) {
+                        return JSMN_PATH_ERROR_INVAL;
+                    }
+                }
+            }
+        }
+    }
+    if (op == NULL) {
+        return JSMN_PATH_ERROR_NOMEM;
+    }
+    if (r < 0) {
+        return r;
+    }
+    skip_space(c);
+    return expect(c, ']') ? 0 : JSMN_PATH_ERROR_INVAL;
+}
+
+static int compile_filter(compiler_t *c) {
+    static const struct {
+        const char *text;
+        jsmn_path_cmp_t cmp;
+    } ops[] = {
+        {"==", JSMN_PATH_CMP_EQ}, {"!=", JSMN_PATH_CMP_NE},
+        {"<=", JSMN_PATH_CMP_LE}, {">=", JSMN_PATH_CMP_GE},
+        {"<", JSMN_PATH_CMP_LT},  {">", JSMN_PATH_CMP_GT},
+    };
+    jsmn_path_op_t *filter = emit(c, JSMN_PATH_OP_FILTER);
+    int first = c->count;
+    int r;
+
+    if (filter == NULL) {
+        return JSMN_PATH_ERROR_NOMEM;
+    }
+    skip_space(c);
+    if (!expect(c, '(')) {
+        return JSMN_PATH_ERROR_INVAL;
+    }
+    skip_space(c);
+    if (!expect(c, '@')) {
+        return JSMN_PATH_ERROR_INVAL;
+    }
+    // the @-path: names and indices only
+    for (;;) {
+        jsmn_path_op_t *op;
+        if (*c->p == '.') {
+            c->p++;
+            if (*c->p == '*') {
+                return JSMN_PATH_ERROR_INVAL;
+            }
+            if ((r = compile_dot(c)) < 0) {
+                return r;
+            }
+        } else if (*c->p == '[') {
+            c->p++;
+            skip_space(c);
+            if (*c->p == '\'' || *c->p == '"') {
+                if ((op = emit(c, JSMN_PATH_OP_CHILD)) == NULL) {
+                    return JSMN_PATH_ERROR_NOMEM;
+                }
+                if ((r = read_quoted(c, op)) < 0) {
+                    return r;
+                }
+            } else {
+                if ((op = emit(c, JSMN_PATH_OP_INDEX)) == NULL) {
+                    return JSMN_PATH_ERROR_NOMEM;
+                }
+                if (!read_int(c, &op->start)) {
+                    return JSMN_PATH_ERROR_INVAL;
+                }
+            }
+            skip_space(c);
+            if (!expect(c, ']')) {
+                return JSMN_PATH_ERROR_INVAL;
+            }
+        } else {
+            break;
+        }
+    }
+    filter->start = c->count - first;
+
+    skip_space(c);
+    filter->cmp = JSMN_PATH_CMP_EXISTS;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        size_t n = strlen(ops[i].text);
+        if (strncmp(c->p, ops[i].text, n) == 0) {
+            c->p += n;
+            filter->cmp = (unsigned char)ops[i].cmp;
+            skip_space(c);
+            if ((r = compile_literal(c, filter)) < 0) {
+                return r;
+            }
+            skip_space(c);
+            break;
+        }
+    }
+    if (!expect(c, ')')) {
+        return JSMN_PATH_ERROR_INVAL;
+    }
+    skip_space(c);
+    return expect(c, ']') ? 0 : JSMN_PATH_ERROR_INVAL;
+}
+
+static int compile_literal(compiler_t *c, jsmn_path_op_t *op) {
+    static const struct {
+        const char *text;
+        jsmn_class_t lit;
+    } words[] = {
+        {"true", JSMN_CLASS_TRUE},
+        {"false", JSMN_CLASS_FALSE},
+        {"null", JSMN_CLASS_NULL},
+    };
+    if (*c->p == '\'' || *c->p == '"') {
+        op->lit = JSMN_CLASS_NONE;
+        return read_quoted(c, op);
+    }
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        size_t n = strlen(words[i].text);
+        if (strncmp(c->p, words[i].text, n) == 0) {
+            c->p += n;
+            op->lit = (unsigned char)words[i].lit;
+            return 0;
+        }
+    }
+    char *end;
+    op->num = strtod(c->p, &end);
+    if (end == c->p) {
+        return JSMN_PATH_ERROR_INVAL;
+    }
+    c->p = end;
+    op->lit = JSMN_CLASS_FLOAT;
+    return 0;
+}
+
+static int read_quoted(compiler_t *c, jsmn_path_op_t *op) {
+    char quote = *c->p++;
+    op->name = c->p;
+    for (; *c->p != quote; c->p++) {
+        if (*c->p == '\0') {
+            return JSMN_PATH_ERROR_INVAL;
+        }
+        if (*c->p == '\\' && c->p[1] != '\0') {
+            c->p++;
+        }
+    }
+    op->len = (int)(c->p++ - op->name);
+    return 0;
+}
+
+static bool read_int(compiler_t *c, int *value) {
+    char *end;
+    skip_space(c);
+    long v = strtol(c->p, &end, 10);
+    if (end == c->p || v < INT_MIN || v > INT_MAX) {
+        return false;
+    }
+    c->p = end;
+    *value = (int)v;
+    return true;
+}
+
+static void skip_space(compiler_t *c) {
+    while (*c->p == ' ') {
+        c->p++;
+    }
+}
+
+static bool expect(compiler_t *c, char ch) {
+    if (*c->p != ch) {
+        return false;
+    }
+    c->p++;
+    return true;
+}
+
+static void run(eval_t *e, int pc, int token) {
+    const jsmn_path_t *path = e->path;
+    const jsmn_token_t *tokens = e->parser->tokens;
+
+    if (pc == path->count) {
+        if (e->count < e->max_matches) {
+            e->matches[e->count] = token;
+        }
+        e->count++;
+        return;
+    }
+    if (path->code[pc].op == JSMN_PATH_OP_DESCEND) {
+        // every container in the subtree is a node at some depth; keys are
+        // strings, so they never come up here
+        int end = tokens[token].end_index;
+        for (int node = token; node < end; node++) {
+            if (tokens[node].type == JSMN_OBJECT ||
+                tokens[node].type == JSMN_ARRAY) {
+                select_children(e, pc + 1, node);
+            }
+        }
+        return;
+    }
+    select_children(e, pc, token);
+}
+
+static void select_children(eval_t *e, int pc, int token) {
+    const jsmn_path_op_t *op = &e->path->code[pc];
+    jsmn_parser_t *parser = e->parser;
+    const jsmn_token_t *tok = &parser->tokens[token];
+    int next = next_pc(e->path, pc);
+    bool is_object = tok->type == JSMN_OBJECT;
+    int child;
+
+    switch (op->op) {
+    case JSMN_PATH_OP_CHILD:
+        child = find_member(parser, token, op->name, op->len);
+        if (child >= 0) {
+            run(e, next, child);
+        }
+        break;
+    case JSMN_PATH_OP_INDEX:
+        if (tok->type == JSMN_ARRAY) {
+            int n = (op->start < 0) ? op->start + tok->child_count : op->start;
+            child = jsmn_array_get(parser, token, n);
+            if (child >= 0) {
+                run(e, next, child);
+            }
+        }
+        break;
+    case JSMN_PATH_OP_SLICE:
+        if (tok->type == JSMN_ARRAY) {
+            int size = tok->child_count;
+            int start = (op->start < 0) ? op->start + size : op->start;
+            int end = (op->end < 0) ? op->end + size : op->end;
+            start = (start < 0) ? 0 : start;
+            end = (end > size) ? size : end;
+            child = jsmn_array_get(parser, token, start);
+            for (int i = start; child >= 0 && i < end;) {
+                run(e, next, child);
+                // hop to the next selected element, never past the last
+                for (int s = 0; s < op->step && ++i < end; s++) {
+                    child = parser->tokens[child].end_index;
+                }
+            }
+        }
+        break;
+    case JSMN_PATH_OP_WILDCARD:
+    case JSMN_PATH_OP_FILTER:
+        if (!is_object && tok->type != JSMN_ARRAY) {
+            break;
+        }
+        // a value starts each member (after its key) or element
+        child = token + 1;
+        for (int i = 0; i < tok->child_count; i++) {
+            int value = is_object ? child + 1 : child;
+            if (op->op == JSMN_PATH_OP_WILDCARD ||
+                test_filter(e, pc, value)) {
+                run(e, next, value);
+            }
+            child = parser->tokens[value].end_index;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static int next_pc(const jsmn_path_t *path, int pc) {
+    const jsmn_path_op_t *op = &path->code[pc];
+    return (op->op == JSMN_PATH_OP_FILTER) ? pc + 1 + op->start : pc + 1;
+}
+
+static int find_member(jsmn_parser_t *parser, int index, const char *name,
+                       int len) {
+    const jsmn_token_t *obj = &parser->tokens[index];
+    if (obj->type != JSMN_OBJECT) {
+        return -1;
+    }
+    int key = index + 1;
+    for (int i = 0; i < obj->child_count; i++) {
+        const jsmn_token_t *tok = &parser->tokens[key];
+        if (tok->strlen == len && memcmp(tok->start, name, len) == 0) {
+            return key + 1;
+        }
+        key = parser->tokens[key + 1].end_index;
+    }
+    return -1;
+}
+
+static bool test_filter(eval_t *e, int pc, int child) {
+    const jsmn_path_op_t *filter = &e->path->code[pc];
+    jsmn_parser_t *parser = e->parser;
+    int node = child;
+
+    for (int i = 1; i <= filter->start && node >= 0; i++) {
+        const jsmn_path_op_t *op = &filter[i];
+        if (op->op == JSMN_PATH_OP_CHILD) {
+            node = find_member(parser, node, op->name, op->len);
+        } else {
+            const jsmn_token_t *arr = &parser->tokens[node];
+            int n = (op->start < 0) ? op->start + arr->child_count : op->start;
+            node = jsmn_array_get(parser, node, n);
+        }
+    }
+    if (node < 0) {
+        return false;
+    }
+    return filter->cmp == JSMN_PATH_CMP_EXISTS ||
+           compare(parser, node, filter);
+}
+
+static bool compare(jsmn_parser_t *parser, int token,
+                    const jsmn_path_op_t *op) {
+    jsmn_token_t *tok = &parser->tokens[token];
+    int order;
+
+    if (op->lit == JSMN_CLASS_NONE) {
+        if (tok->type != JSMN_STRING) {
+            return op->cmp == JSMN_PATH_CMP_NE;
+        }
+        int n = (tok->strlen < op->len) ? tok->strlen : op->len;
+        order = memcmp(tok->start, op->name, (size_t)n);
+        if (order == 0) {
+            order = (tok->strlen > op->len) - (tok->strlen < op->len);
+        }
+    } else if (op->lit == JSMN_CLASS_FLOAT) {
+        char buf[MAX_NUMBER + 1];
+        if (!jsmn_token_is_number(tok) || tok->strlen > MAX_NUMBER) {
+            return op->cmp == JSMN_PATH_CMP_NE;
+        }
+        memcpy(buf, tok->start, (size_t)tok->strlen);
+        buf[tok->strlen] = '\0';
+        double v = strtod(buf, NULL);
+        order = (v > op->num) - (v < op->num);
+    } else {
+        // true, false and null only test for (in)equality
+        bool same = jsmn_token_class(tok) == op->lit;
+        return (op->cmp == JSMN_PATH_CMP_EQ && same) ||
+               (op->cmp == JSMN_PATH_CMP_NE && !same);
+    }
+    switch (op->cmp) {
+    case JSMN_PATH_CMP_EQ:
+        return order == 0;
+    case JSMN_PATH_CMP_NE:
+        return order != 0;
+    case JSMN_PATH_CMP_LT:
+        return order < 0;
+    case JSMN_PATH_CMP_LE:
+        return order <= 0;
+    case JSMN_PATH_CMP_GT:
+        return order > 0;
+    default:
+        return order >= 0;
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_PATH_H
+#define JSMN_PATH_H
+
+#include "jsmn.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  /* The expression is not one jsmn_path_compile() understands */
+  JSMN_PATH_ERROR_INVAL = -1,
+  /* The code array is too small for the expression */
+  JSMN_PATH_ERROR_NOMEM = -2
+} jsmn_path_err_t;
+
+typedef enum {
+  JSMN_PATH_OP_CHILD,    // member `name` of an object
+  JSMN_PATH_OP_WILDCARD, // every element or member value
+  JSMN_PATH_OP_INDEX,    // element `start` of an array (negative: from end)
+  JSMN_PATH_OP_SLICE,    // elements start:end:step of an array
+  JSMN_PATH_OP_FILTER,   // elements or member values passing a test
+  JSMN_PATH_OP_DESCEND   // apply the next op at every depth (`..`)
+} jsmn_path_opcode_t;
+
+typedef enum {
+  JSMN_PATH_CMP_EXISTS, // the @-path leads somewhere
+  JSMN_PATH_CMP_EQ,
+  JSMN_PATH_CMP_NE,
+  JSMN_PATH_CMP_LT,
+  JSMN_PATH_CMP_LE,
+  JSMN_PATH_CMP_GT,
+  JSMN_PATH_CMP_GE
+} jsmn_path_cmp_t;
+
+/**
+ * One bytecode instruction.  A FILTER is followed by the `start` CHILD and
+ * INDEX instructions of its @-path, which it runs itself.
+ */
+typedef struct {
+  unsigned char op;  // jsmn_path_opcode_t
+  unsigned char cmp; // FILTER: jsmn_path_cmp_t
+  unsigned char lit; // FILTER: literal class, JSMN_CLASS_FLOAT for any
+                     // number, JSMN_CLASS_NONE for a string
+  int start;         // INDEX / SLICE start; FILTER: length of its @-path
+  int end;           // SLICE end (exclusive)
+  int step;          // SLICE step
+  const char *name;  // CHILD name or FILTER string literal, in the expression
+  int len;           // length of name
+  double num;        // FILTER number literal
+} jsmn_path_op_t;
+
+/**
+ * A compiled expression.  Points into the expression text and the code
+ * array, which must outlive it.
+ */
+typedef struct {
+  const jsmn_path_op_t *code; // instructions
+  int count;                  // number of instructions
+} jsmn_path_t;
+
+/**
+ * @brief Compile the JSONPath expression expr into code (code_size
+ * instructions).
+ *
+ * Supported: `$`, `.name`, `['name']`, `.*`, `[*]`, `..` before any
+ * selector, `[n]` (negative counts from the end), slices `[a:b]` and
+ * `[a:b:step]` with a positive step, and filters `[?(@...)]` whose @-path
+ * uses names and indices and optionally compares with ==, !=, <, <=, > or >=
+ * against a number, a quoted string, true, false or null.  Names and string
+ * literals are compared as written, escapes included.
+ *
+ * Returns the number of instructions, JSMN_PATH_ERROR_INVAL or
+ * JSMN_PATH_ERROR_NOMEM.
+ */
+int jsmn_path_compile(jsmn_path_t *path, const char *expr,
+                      jsmn_path_op_t *code, int code_size);
+
+/**
+ * @brief Run path over the tokens of parser, with `$` as token root.  The
+ * indices of matching tokens (values, never keys) are stored in matches, up
+ * to max_matches of them.  Returns the total number of matches, which may
+ * exceed max_matches.
+ *
+ * Subtrees are skipped with their end_index, and array indexing uses the
+ * parser's child index when one is attached (see jsmn_set_child_index()).
+ */
+int jsmn_path_eval(const jsmn_path_t *path, jsmn_parser_t *parser, int root,
+                   int *matches, int max_matches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_PATH_H */
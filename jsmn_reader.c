@@ -0,0 +1,252 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _POSIX_C_SOURCE 200809L // read()
+
+#include "jsmn_reader.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// local types and definitions
+
+#define IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Advance the boundary scanner over the bytes read so far.  Return true once
+ * it reaches the end of a value, leaving scan just past it.
+ */
+static bool scan_value(jsmn_reader_t *reader);
+
+/**
+ * Make room at the end of the window, by dropping released bytes or growing
+ * it, and read into it.  Return 0 or a jsmn_reader_err_t.
+ */
+static int fill(jsmn_reader_t *reader);
+
+/**
+ * Return true if c ends a primitive.
+ */
+static bool ends_primitive(char c);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_reader_init(jsmn_reader_t *reader, int fd, jsmn_parse_fn parse,
+                     size_t initial_size, size_t max_size) {
+    memset(reader, 0, sizeof(*reader));
+    if (initial_size == 0 || initial_size > max_size) {
+        return JSMN_READER_ERROR_NOMEM;
+    }
+    reader->buf = (char *)malloc(initial_size);
+    if (reader->buf == NULL) {
+        return JSMN_READER_ERROR_NOMEM;
+    }
+    reader->fd = fd;
+    reader->parse = parse;
+    reader->size = initial_size;
+    reader->max_size = max_size;
+    return 0;
+}
+
+int jsmn_reader_next(jsmn_reader_t *reader, jsmn_parser_t *parser,
+                     const char **value, size_t *len) {
+    jsmn_reader_release(reader);
+    while (!scan_value(reader)) {
+        if (reader->eof) {
+            if (reader->kind == 0) {
+                return 0;
+            }
+            break; // the stream ends inside a value: deliver what there is
+        }
+        int r = fill(reader);
+        if (r < 0) {
+            return r;
+        }
+    }
+    *value = &reader->buf[reader->start];
+    *len = reader->scan - reader->start;
+    // strict parsers want a primitive followed by a delimiter: pass along
+    // the whitespace that ended it
+    size_t parse_len = *len;
+    if (reader->kind == 'p' && reader->scan < reader->end &&
+        IS_SPACE(reader->buf[reader->scan])) {
+        parse_len++;
+    }
+    reader->held = true;
+    reader->kind = 0;
+    reader->depth = 0;
+    reader->in_string = false;
+    reader->escape = false;
+    return reader->parse(parser, *value, parse_len);
+}
+
+void jsmn_reader_release(jsmn_reader_t *reader) {
+    if (!reader->held) {
+        return;
+    }
+    reader->held = false;
+    reader->start = reader->scan;
+    if (reader->start == reader->end) {
+        // nothing left in the window: rewind it for free
+        reader->start = reader->scan = reader->end = 0;
+    }
+}
+
+void jsmn_reader_free(jsmn_reader_t *reader) {
+    free(reader->buf);
+    reader->buf = NULL;
+    reader->size = 0;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static bool scan_value(jsmn_reader_t *reader) {
+    const char *buf = reader->buf;
+
+    for (; reader->scan < reader->end; reader->scan++) {
+        char c = buf[reader->scan];
+        if (reader->kind == 0) {
+            if (IS_SPACE(c)) {
+                reader->start = reader->scan + 1;
+                continue;
+            }
+            switch (c) {
+            case '{':
+            case '[':
+                reader->kind = '{';
+                reader->depth = 1;
+                break;
+            case '"':
+                reader->kind = '"';
+                reader->in_string = true;
+                break;
+            case '}':
+            case ']':
+            case ',':
+            case ':':
+                // a stray delimiter: hand it over alone for the parser to
+                // reject
+                reader->kind = 'p';
+                reader->scan++;
+                return true;
+            default:
+                reader->kind = 'p';
+                break;
+            }
+        } else if (reader->in_string) {
+            if (reader->escape) {
+                reader->escape = false;
+            } else if (c == '\\') {
+                reader->escape = true;
+            } else if (c == '"') {
+                reader->in_string = false;
+                if (reader->kind == '"') {
+                    reader->scan++;
+                    return true;
+                }
+            }
+        } else if (reader->kind == 'p') {
+            if (ends_primitive(c)) {
+                return true;
+            }
+        } else if (c == '"') {
+            reader->in_string = true;
+        } else if (c == '{' || c == '[') {
+            reader->depth++;
+        } else if ((c == '}' || c == ']') && --reader->depth == 0) {
+            reader->scan++;
+            return true;
+        }
+    }
+    // a primitive is only known to be over at the end of the stream
+    return reader->eof && reader->kind == 'p';
+}
+
+static int fill(jsmn_reader_t *reader) {
+    if (reader->end == reader->size) {
+        if (reader->start > 0) {
+            // slide the unfinished value to the front of the window
+            size_t keep = reader->end - reader->start;
+            memmove(reader->buf, &reader->buf[reader->start], keep);
+            reader->scan -= reader->start;
+            reader->end = keep;
+            reader->start = 0;
+        } else {
+            if (reader->size >= reader->max_size) {
+                return JSMN_READER_ERROR_NOMEM;
+            }
+            size_t size = reader->size * 2;
+            if (size > reader->max_size || size < reader->size) {
+                size = reader->max_size;
+            }
+            char *buf = (char *)realloc(reader->buf, size);
+            if (buf == NULL) {
+                return JSMN_READER_ERROR_NOMEM;
+            }
+            reader->buf = buf;
+            reader->size = size;
+        }
+    }
+    for (;;) {
+        ssize_t n = read(reader->fd, &reader->buf[reader->end],
+                         reader->size - reader->end);
+        if (n > 0) {
+            reader->end += (size_t)n;
+            return 0;
+        } else if (n == 0) {
+            reader->eof = true;
+            return 0;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return JSMN_READER_ERROR_AGAIN;
+        } else if (errno != EINTR) {
+            return JSMN_READER_ERROR_IO;
+        }
+    }
+}
+
+static bool ends_primitive(char c) {
+    switch (c) {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+    case ',':
+    case ':':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+    case '"':
+        return true;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_READER_H
+#define JSMN_READER_H
+
+#include "jsmn.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Errors of the reader itself.  They lie below the jsmn_err_t codes, which
+ * jsmn_reader_next() passes through from the parser.
+ */
+typedef enum {
+  /* read() failed; errno says why */
+  JSMN_READER_ERROR_IO = -16,
+  /* A non-blocking descriptor has no data yet: poll it and call again */
+  JSMN_READER_ERROR_AGAIN = -17,
+  /* A value does not fit in max_size bytes, or out of memory */
+  JSMN_READER_ERROR_NOMEM = -18
+} jsmn_reader_err_t;
+
+/**
+ * Reads a stream of whitespace separated top-level JSON values (NDJSON,
+ * concatenated JSON) from a file descriptor, one value at a time, through a
+ * sliding window.  Bytes of released values are dropped from the front of
+ * the window, so it only grows to hold the largest single value.
+ */
+typedef struct {
+  int fd;              // descriptor read from
+  jsmn_parse_fn parse; // parser applied to each value
+  char *buf;           // the window
+  size_t size;         // bytes allocated for buf
+  size_t max_size;     // most bytes buf may grow to
+  size_t start;        // start of the current value; bytes before are done
+  size_t scan;         // next byte for the boundary scanner
+  size_t end;          // bytes of buf holding data
+  int depth;           // bracket nesting of the current value
+  char kind;           // '{', '"', 'p' (primitive) or 0 between values
+  bool in_string;      // scanner is inside a string
+  bool escape;         // ... just after a backslash
+  bool held;           // a delivered value is not yet released
+  bool eof;            // read() has returned 0
+} jsmn_reader_t;
+
+/**
+ * @brief Set up reader over fd, parsing each value with parse.  The window
+ * starts at initial_size bytes and may grow to max_size.  Returns 0 or
+ * JSMN_READER_ERROR_NOMEM.
+ */
+int jsmn_reader_init(jsmn_reader_t *reader, int fd, jsmn_parse_fn parse,
+                     size_t initial_size, size_t max_size);
+
+/**
+ * @brief Release the last value, read up to the end of the next one, and
+ * parse it into parser.
+ *
+ * Returns what the parser returns (the token count or a jsmn_err_t), 0 at
+ * the end of the stream, or a jsmn_reader_err_t.  Whenever a value was
+ * found, *value and *len give its text even if it did not parse, e.g. to
+ * retry with more tokens.  The text and the tokens stay valid until the
+ * value is released.  A stream ending inside a value yields that value,
+ * which fails to parse with JSMN_ERROR_PART.  As with jsmn_parse_strict()
+ * itself, strict parsers also reject a top-level primitive that is not
+ * followed by whitespace.
+ */
+int jsmn_reader_next(jsmn_reader_t *reader, jsmn_parser_t *parser,
+                     const char **value, size_t *len);
+
+/**
+ * @brief Let the reader reuse the space of the last value.  Its text and
+ * tokens must not be used afterwards.
+ */
+void jsmn_reader_release(jsmn_reader_t *reader);
+
+/**
+ * @brief Free the window.  Does not close the descriptor.
+ */
+void jsmn_reader_free(jsmn_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_READER_H */
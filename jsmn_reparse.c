@@ -0,0 +1,199 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_reparse.h"
+#include <string.h>
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Return the index of the deepest object or array whose interior holds the
+ * bytes [start, end) of old_js, or -1 if there is none.
+ */
+static int find_enclosing(const jsmn_parser_t *parser, const char *old_js,
+                          size_t start, size_t end);
+
+/**
+ * Point the token at the same byte of js that it had in old_js, moved by
+ * delta if it lay at or past offset edit_end.
+ */
+static void rebase(jsmn_token_t *tok, const char *old_js, const char *js,
+                   size_t edit_end, long delta);
+
+/**
+ * Give the keys among n tokens their symbol IDs, keeping the symbols the
+ * last parse interned.
+ */
+static void intern_keys(jsmn_symtab_t *symtab, jsmn_token_t *tokens, int n);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_reparse(jsmn_parser_t *parser, jsmn_parse_fn parse,
+                 const char *old_js, const char *js, size_t len,
+                 const jsmn_edit_t *edit) {
+    size_t edit_end = edit->start + edit->old_len;
+    long delta = (long)edit->new_len - (long)edit->old_len;
+    jsmn_token_t *tokens = parser->tokens;
+    jsmn_parser_t sub;
+    int count = (int)parser->token_count;
+
+    int t = (tokens == NULL) ? -1
+                             : find_enclosing(parser, old_js, edit->start,
+                                              edit_end);
+    if (t < 0 || (parser->limits.max_bytes != 0 &&
+                  len > parser->limits.max_bytes)) {
+        return parse(parser, js, len);
+    }
+    jsmn_token_t old = tokens[t];
+    size_t t_start = (size_t)(old.start - old_js);
+    size_t sub_len = (size_t)((long)old.strlen + delta);
+    int old_n = old.end_index - t;
+
+    // size the new subtree and make room for it, within the parser's limits
+    jsmn_init(&sub, NULL, 0);
+    sub.limits = parser->limits;
+    if (sub.limits.max_depth != 0) {
+        if (sub.limits.max_depth <= (unsigned int)old.level) {
+            return parse(parser, js, len);
+        }
+        sub.limits.max_depth -= (unsigned int)old.level;
+    }
+    if (sub.limits.max_tokens != 0) {
+        if (sub.limits.max_tokens <= (unsigned int)(count - old_n)) {
+            return parse(parser, js, len);
+        }
+        sub.limits.max_tokens -= (unsigned int)(count - old_n);
+    }
+    int new_n = parse(&sub, &js[t_start], sub_len);
+    if (new_n <= 0) {
+        return parse(parser, js, len);
+    }
+    if ((unsigned int)(count - old_n + new_n) > parser->num_tokens) {
+        return JSMN_ERROR_NOMEM;
+    }
+    memmove(&tokens[t + new_n], &tokens[t + old_n],
+            sizeof(jsmn_token_t) * (size_t)(count - t - old_n));
+
+    sub.tokens = &tokens[t];
+    sub.num_tokens = (unsigned int)new_n;
+    // only the new subtree can have gained a duplicate key
+    sub.keyset = parser->keyset;
+    if (parse(&sub, &js[t_start], sub_len) != new_n ||
+        tokens[t].type != old.type || (size_t)tokens[t].strlen != sub_len) {
+        // the edit reaches past the container: start over
+        return parse(parser, js, len);
+    }
+
+    // graft the subtree in under the container's old parent
+    for (int i = t; i < t + new_n; i++) {
+        jsmn_token_t *tok = &tokens[i];
+        tok->level += old.level;
+        tok->end_index += t;
+        if (tok->parent_index != -1) {
+            tok->parent_index += t;
+        }
+    }
+    tokens[t].parent_index = old.parent_index;
+    if (parser->symtab != NULL) {
+        intern_keys(parser->symtab, &tokens[t], new_n);
+    }
+
+    // ancestors grow by the edit; tokens before them keep their place
+    for (int i = 0; i < t; i++) {
+        jsmn_token_t *tok = &tokens[i];
+        if (js != old_js) {
+            rebase(tok, old_js, js, edit_end, 0);
+        }
+        if (tok->end_index > t) {
+            tok->end_index += new_n - old_n;
+            if (tok->type == JSMN_OBJECT || tok->type == JSMN_ARRAY) {
+                tok->strlen += (int)delta;
+            }
+        }
+    }
+    // tokens after the subtree all lie past the edit
+    count += new_n - old_n;
+    for (int i = t + new_n; i < count; i++) {
+        jsmn_token_t *tok = &tokens[i];
+        rebase(tok, old_js, js, edit_end, delta);
+        tok->end_index += new_n - old_n;
+        if (tok->parent_index >= t + old_n) {
+            tok->parent_index += new_n - old_n;
+        }
+    }
+    parser->token_count = (unsigned int)count;
+    parser->pos = (unsigned int)len;
+    jsmn_child_index_invalidate(parser);
+    return count;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static int find_enclosing(const jsmn_parser_t *parser, const char *old_js,
+                          size_t start, size_t end) {
+    const jsmn_token_t *tokens = parser->tokens;
+    int found = -1;
+
+    for (int i = 0; i < (int)parser->token_count;) {
+        const jsmn_token_t *tok = &tokens[i];
+        size_t open = (size_t)(tok->start - old_js);
+        if (open >= end) {
+            break; // past the edit
+        }
+        if ((tok->type == JSMN_OBJECT || tok->type == JSMN_ARRAY) &&
+            open < start && end < open + (size_t)tok->strlen) {
+            // the edit is inside: look among the children for a deeper one
+            found = i++;
+        } else if (tok->type == JSMN_STRING && tok->child_count != 0) {
+            // a key: its value comes next
+            i++;
+        } else {
+            i = tok->end_index;
+        }
+    }
+    return found;
+}
+
+static void rebase(jsmn_token_t *tok, const char *old_js, const char *js,
+                   size_t edit_end, long delta) {
+    size_t offset = (size_t)(tok->start - old_js);
+    if (offset >= edit_end) {
+        offset = (size_t)((long)offset + delta);
+    }
+    tok->start = js + offset;
+}
+
+static void intern_keys(jsmn_symtab_t *symtab, jsmn_token_t *tokens, int n) {
+    for (int i = 0; i < n; i++) {
+        jsmn_token_t *tok = &tokens[i];
+        // a string with a child is a key holding its value
+        if (tok->type == JSMN_STRING && tok->child_count == 1) {
+            tok->symbol = (unsigned short)jsmn_symtab_intern(
+                symtab, tok->start, (size_t)tok->strlen);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_REPARSE_H
+#define JSMN_REPARSE_H
+
+#include "jsmn.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * One edit of a JSON buffer: old_len bytes at offset start were replaced by
+ * new_len bytes.
+ */
+typedef struct {
+  size_t start;   // offset of the edit
+  size_t old_len; // bytes removed
+  size_t new_len; // bytes inserted in their place
+} jsmn_edit_t;
+
+/**
+ * @brief Bring the tokens of a parse of old_js up to date with js (len
+ * bytes), which is old_js after edit.  js may be old_js edited in place or
+ * a new buffer; old_js is only used to locate the old tokens, never read.
+ *
+ * Only the smallest object or array that encloses the edit (brackets
+ * excluded) is tokenized again.  Tokens after it are shifted to their new
+ * offsets and indices, and the lengths and subtree ends of its ancestors are
+ * adjusted.  If no container encloses the edit, or the edit changes the
+ * container's extent (e.g. adds a closing bracket), the whole of js is
+ * parsed instead, so the result always matches parse(js).
+ *
+ * parse must be the entry point the tokens came from, and not
+ * jsmn_parse_padded(), which cannot parse a slice of js.  Returns what parse
+ * would: the new token count or a jsmn error.
+ */
+int jsmn_reparse(jsmn_parser_t *parser, jsmn_parse_fn parse,
+                 const char *old_js, const char *js, size_t len,
+                 const jsmn_edit_t *edit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_REPARSE_H */
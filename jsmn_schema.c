@@ -0,0 +1,603 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_schema.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/* Longest number text converted for a comparison */
+#define MAX_NUMBER 63
+
+/* Schema being compiled */
+typedef struct {
+    jsmn_parser_t *parser;  // tokens of the schema text
+    jsmn_schema_op_t *code; // output
+    int count;              // instructions emitted
+    int size;               // room in code
+} compiler_t;
+
+/* Validation in progress */
+typedef struct {
+    const jsmn_schema_op_t *code;
+    jsmn_parser_t *parser;
+    jsmn_schema_error_t *errors;
+    int max_errors;
+    int count; // failed checks found
+} check_t;
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Append an instruction.  Return it, or NULL if code is full.
+ */
+static jsmn_schema_op_t *emit(compiler_t *c, jsmn_schema_opcode_t op);
+
+/**
+ * Compile the schema object at token.
+ */
+static int compile_schema(compiler_t *c, int token);
+
+/**
+ * Compile the keyword whose key is at token key into the SCHEMA op at index
+ * at.
+ */
+static int compile_keyword(compiler_t *c, int at, int key);
+
+/**
+ * Compile the value of `type` into a set of jsmn_schema_type_t bits.
+ */
+static int compile_types(compiler_t *c, int token);
+
+/**
+ * Compile the array of strings at token into REQUIRED ops of the SCHEMA op
+ * at index at.
+ */
+static int compile_required(compiler_t *c, int at, int token);
+
+/**
+ * Compile the array of literals at token into ENUM ops.
+ */
+static int compile_enum(compiler_t *c, int token);
+
+/**
+ * Compile the object of schemas at token into PROPERTY ops.
+ */
+static int compile_properties(compiler_t *c, int token);
+
+/**
+ * Return true if token is the string literal, as written.
+ */
+static bool token_is(const jsmn_token_t *token, const char *literal);
+
+/**
+ * Convert a number token.  Return false if token is not a number.
+ */
+static bool token_number(jsmn_token_t *token, double *value);
+
+/**
+ * Return the jsmn_schema_type_t bits that token is an instance of.
+ */
+static int instance_types(jsmn_token_t *token);
+
+/**
+ * Check the value at token against the SCHEMA op at pc.
+ */
+static void check_value(check_t *v, int pc, int token);
+
+/**
+ * Check the members of the object at token against the SCHEMA op at pc.
+ */
+static void check_members(check_t *v, int pc, int token);
+
+/**
+ * Return true if token equals the literal of the ENUM op.
+ */
+static bool enum_matches(jsmn_token_t *token, const jsmn_schema_op_t *op);
+
+/**
+ * Record a failed check.
+ */
+static void fail(check_t *v, int token, jsmn_schema_fail_t keyword, int pc);
+
+/**
+ * Return the number of code points in the len bytes of string text at s.
+ */
+static int code_points(const char *s, int len);
+
+// *****************************************************************************
+// public functions
+
+int jsmn_schema_compile(jsmn_schema_t *schema, jsmn_parser_t *parser, int root,
+                        jsmn_schema_op_t *code, int code_size) {
+    compiler_t c = {parser, code, 0, code_size};
+
+    if (jsmn_token_ref(parser, root) == NULL) {
+        return JSMN_SCHEMA_ERROR_INVAL;
+    }
+    int r = compile_schema(&c, root);
+    if (r < 0) {
+        return r;
+    }
+    schema->code = code;
+    schema->count = c.count;
+    return c.count;
+}
+
+int jsmn_schema_validate(const jsmn_schema_t *schema, jsmn_parser_t *parser,
+                         int root, jsmn_schema_error_t *errors,
+                         int max_errors) {
+    check_t v = {schema->code, parser, errors, max_errors, 0};
+
+    if (jsmn_token_ref(parser, root) == NULL || schema->count == 0) {
+        return 0;
+    }
+    check_value(&v, 0, root);
+    return v.count;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static jsmn_schema_op_t *emit(compiler_t *c, jsmn_schema_opcode_t op) {
+    if (c->count >= c->size) {
+        return NULL;
+    }
+    jsmn_schema_op_t *ins = &c->code[c->count++];
+    memset(ins, 0, sizeof(*ins));
+    ins->op = (unsigned char)op;
+    return ins;
+}
+
+static int compile_schema(compiler_t *c, int token) {
+    const jsmn_token_t *tokens = c->parser->tokens;
+    int at = c->count;
+
+    if (tokens[token].type != JSMN_OBJECT) {
+        return JSMN_SCHEMA_ERROR_INVAL;
+    }
+    if (emit(c, JSMN_SCHEMA_OP_SCHEMA) == NULL) {
+        return JSMN_SCHEMA_ERROR_NOMEM;
+    }
+    int key = token + 1;
+    for (int i = 0; i < tokens[token].child_count; i++) {
+        int r = compile_keyword(c, at, key);
+        if (r < 0) {
+            return r;
+        }
+        key = tokens[key + 1].end_index;
+    }
+    c->code[at].span = c->count - at;
+    return 0;
+}
+
+static int compile_keyword(compiler_t *c, int at, int key) {
+    jsmn_token_t *k = &c->parser->tokens[key];
+    jsmn_token_t *value = k + 1;
+    jsmn_schema_op_t *op = &c->code[at];
+    double num;
+
+    if (token_is(k, "type")) {
+        int types = compile_types(c, key + 1);
+        if (types < 0) {
+            return types;
+        }
+        op->types = (unsigned char)types;
+        return 0;
+    }
+    if (token_is(k, "required")) {
+        return compile_required(c, at, key + 1);
+    }
+    if (token_is(k, "enum")) {
+        return compile_enum(c, key + 1);
+    }
+    if (token_is(k, "properties")) {
+        return compile_properties(c, key + 1);
+    }
+    if (token_is(k, "items")) {
+        if (emit(c, JSMN_SCHEMA_OP_ITEMS) == NULL) {
+            return JSMN_SCHEMA_ERROR_NOMEM;
+        }
+        return compile_schema(c, key + 1);
+    }
+    if (token_is(k, "minimum") || token_is(k, "maximum")) {
+        if (!token_number(value, &num)) {
+            return JSMN_SCHEMA_ERROR_INVAL;
+        }
+        if (k->start[1] == 'i') {
+            op->minimum = num;
+            op->bounds |= JSMN_SCHEMA_HAS_MINIMUM;
+        } else {
+            op->maximum = num;
+            op->bounds |= JSMN_SCHEMA_HAS_MAXIMUM;
+        }
+        return 0;
+    }
+    if (token_is(k, "minLength") || token_is(k, "maxLength")) {
+        if (jsmn_token_class(value) != JSMN_CLASS_INTEGER ||
+            jsmn_token_is_negative(value) || !token_number(value, &num) ||
+            num > INT32_MAX) {
+            return JSMN_SCHEMA_ERROR_INVAL;
+        }
+        if (k->start[1] == 'i') {
+            op->min_length = (int)num;
+            op->bounds |= JSMN_SCHEMA_HAS_MIN_LENGTH;
+        } else {
+            op->max_length = (int)num;
+            op->bounds |= JSMN_SCHEMA_HAS_MAX_LENGTH;
+        }
+        return 0;
+    }
+    // annotations and anything else we do not check
+    return 0;
+}
+
+static int compile_types(compiler_t *c, int token) {
+    static const char *const names[] = {"object",  "array",   "string",
+                                        "number",  "integer", "boolean",
+                                        "null"};
+    const jsmn_token_t *tokens = c->parser->tokens;
+    int count = 1;
+    int types = 0;
+
+    if (tokens[token].type == JSMN_ARRAY) {
+        count = tokens[token].child_count;
+        token++;
+    }
+    for (int i = 0; i < count; i++, token++) {
+        int bit = 0;
+        for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); n++) {
+            if (token_is(&tokens[token], names[n])) {
+                bit = 1 << n;
+                break;
+            }
+        }
+        if (bit == 0) {
+            return JSMN_SCHEMA_ERROR_INVAL;
+        }
+        types |= bit;
+    }
+    return types;
+}
+
+static int compile_required(compiler_t *c, int at, int token) {
+    const jsmn_token_t *tokens = c->parser->tokens;
+    int count = tokens[token].child_count;
+
+    if (tokens[token].type != JSMN_ARRAY) {
+        return JSMN_SCHEMA_ERROR_INVAL;
+    }
+    // validation tracks the names in a bitmask, so count any listed before
+    int total = count;
+    for (int i = at + 1; i < c->count;) {
+        if (c->code[i].op == JSMN_SCHEMA_OP_REQUIRED) {
+            total++;
+        }
+        bool nested = c->code[i].op == JSMN_SCHEMA_OP_PROPERTY ||
+                      c->code[i].op == JSMN_SCHEMA_OP_ITEMS;
+        i += nested ? 1 + c->code[i + 1].span : 1;
+    }
+    if (total > JSMN_SCHEMA_MAX_REQUIRED) {
+        return JSMN_SCHEMA_ERROR_INVAL;
+    }
+    for (int i = 0; i < count; i++) {
+        const jsmn_token_t *name = &tokens[token + 1 + i];
+        if (name->type != JSMN_STRING) {
+            return JSMN_SCHEMA_ERROR_INVAL;
+        }
+        jsmn_schema_op_t *op = emit(c, JSMN_SCHEMA_OP_REQUIRED);
+        if (op == NULL) {
+            return JSMN_SCHEMA_ERROR_NOMEM;
+        }
+        op->name = name->start;
+        op->len = name->strlen;
+    }
+    return 0;
+}
+
+static int compile_enum(compiler_t *c, int token) {
+    jsmn_token_t *tokens = c->parser->tokens;
+    int count = tokens[token].child_count;
+
+    if (tokens[token].type != JSMN_ARRAY) {
+        return JSMN_SCHEMA_ERROR_INVAL;
+    }
+    for (int i = 0; i < count; i++) {
+        jsmn_token_t *lit = &tokens[token + 1 + i];
+        jsmn_schema_op_t *op = emit(c, JSMN_SCHEMA_OP_ENUM);
+        if (op == NULL) {
+            return JSMN_SCHEMA_ERROR_NOMEM;
+        }
+        if (lit->type == JSMN_STRING) {
+            op->lit = JSMN_CLASS_NONE;
+            op->name = lit->start;
+            op->len = lit->strlen;
+        } else if (token_number(lit, &op->num)) {
+            op->lit = JSMN_CLASS_FLOAT;
+        } else if (jsmn_token_class(lit) >= JSMN_CLASS_TRUE &&
+                   jsmn_token_class(lit) <= JSMN_CLASS_NULL) {
+            op->lit = (unsigned char)jsmn_token_class(lit);
+        } else {
+            // objects and arrays in enum are not supported
+            return JSMN_SCHEMA_ERROR_INVAL;
+        }
+    }
+    return 0;
+}
+
+static int compile_properties(compiler_t *c, int token) {
+    const jsmn_token_t *tokens = c->parser->tokens;
+
+    if (tokens[token].type != JSMN_OBJECT) {
+        return JSMN_SCHEMA_ERROR_INVAL;
+    }
+    int key = token + 1;
+    for (int i = 0; i < tokens[token].child_count; i++) {
+        jsmn_schema_op_t *op = emit(c, JSMN_SCHEMA_OP_PROPERTY);
+        if (op == NULL) {
+            return JSMN_SCHEMA_ERROR_NOMEM;
+        }
+        op->name = tokens[key].start;
+        op->len = tokens[key].strlen;
+        int r = compile_schema(c, key + 1);
+        if (r < 0) {
+            return r;
+        }
+        key = tokens[key + 1].end_index;
+    }
+    return 0;
+}
+
+static bool token_is(const jsmn_token_t *token, const char *literal) {
+    size_t n = strlen(literal);
+    return token->type == JSMN_STRING && (size_t)token->strlen == n &&
+           memcmp(token->start, literal, n) == 0;
+}
+
+static bool token_number(jsmn_token_t *token, double *value) {
+    char buf[MAX_NUMBER + 1];
+
+    if (!jsmn_token_is_number(token) || token->strlen > MAX_NUMBER) {
+        return false;
+    }
+    memcpy(buf, token->start, (size_t)token->strlen);
+    buf[token->strlen] = '\0';
+    *value = strtod(buf, NULL);
+    return true;
+}
+
+static int instance_types(jsmn_token_t *token) {
+    double num;
+
+    switch (token->type) {
+    case JSMN_OBJECT:
+        return JSMN_SCHEMA_TYPE_OBJECT;
+    case JSMN_ARRAY:
+        return JSMN_SCHEMA_TYPE_ARRAY;
+    case JSMN_STRING:
+        return JSMN_SCHEMA_TYPE_STRING;
+    default:
+        break;
+    }
+    switch (jsmn_token_class(token)) {
+    case JSMN_CLASS_INTEGER:
+        return JSMN_SCHEMA_TYPE_NUMBER | JSMN_SCHEMA_TYPE_INTEGER;
+    case JSMN_CLASS_FLOAT:
+        // 1.0 and 1e2 are integers too
+        if (token_number(token, &num) && num > -9.2e18 && num < 9.2e18 &&
+            num == (double)(long long)num) {
+            return JSMN_SCHEMA_TYPE_NUMBER | JSMN_SCHEMA_TYPE_INTEGER;
+        }
+        return JSMN_SCHEMA_TYPE_NUMBER;
+    case JSMN_CLASS_TRUE:
+    case JSMN_CLASS_FALSE:
+        return JSMN_SCHEMA_TYPE_BOOLEAN;
+    case JSMN_CLASS_NULL:
+        return JSMN_SCHEMA_TYPE_NULL;
+    default:
+        return 0;
+    }
+}
+
+static void check_value(check_t *v, int pc, int token) {
+    const jsmn_schema_op_t *op = &v->code[pc];
+    jsmn_token_t *tokens = v->parser->tokens;
+    jsmn_token_t *tok = &tokens[token];
+    bool has_enum = false;
+    bool in_enum = false;
+    bool has_members = false;
+    int items = -1;
+    double num;
+
+    if (op->types != 0 && (instance_types(tok) & op->types) == 0) {
+        fail(v, token, JSMN_SCHEMA_FAIL_TYPE, pc);
+        return;
+    }
+    for (int i = pc + 1; i < pc + op->span;) {
+        const jsmn_schema_op_t *ins = &v->code[i];
+        switch (ins->op) {
+        case JSMN_SCHEMA_OP_ENUM:
+            has_enum = true;
+            in_enum = in_enum || enum_matches(tok, ins);
+            i++;
+            break;
+        case JSMN_SCHEMA_OP_REQUIRED:
+            has_members = true;
+            i++;
+            break;
+        case JSMN_SCHEMA_OP_PROPERTY:
+            has_members = true;
+            i += 1 + v->code[i + 1].span;
+            break;
+        default: // ITEMS
+            items = i + 1;
+            i += 1 + v->code[i + 1].span;
+            break;
+        }
+    }
+    if (has_enum && !in_enum) {
+        fail(v, token, JSMN_SCHEMA_FAIL_ENUM, pc);
+    }
+    if ((op->bounds & (JSMN_SCHEMA_HAS_MINIMUM | JSMN_SCHEMA_HAS_MAXIMUM)) &&
+        token_number(tok, &num)) {
+        if ((op->bounds & JSMN_SCHEMA_HAS_MINIMUM) && num < op->minimum) {
+            fail(v, token, JSMN_SCHEMA_FAIL_MINIMUM, pc);
+        }
+        if ((op->bounds & JSMN_SCHEMA_HAS_MAXIMUM) && num > op->maximum) {
+            fail(v, token, JSMN_SCHEMA_FAIL_MAXIMUM, pc);
+        }
+    }
+    if ((op->bounds &
+         (JSMN_SCHEMA_HAS_MIN_LENGTH | JSMN_SCHEMA_HAS_MAX_LENGTH)) &&
+        tok->type == JSMN_STRING) {
+        int n = code_points(tok->start, tok->strlen);
+        if ((op->bounds & JSMN_SCHEMA_HAS_MIN_LENGTH) && n < op->min_length) {
+            fail(v, token, JSMN_SCHEMA_FAIL_MIN_LENGTH, pc);
+        }
+        if ((op->bounds & JSMN_SCHEMA_HAS_MAX_LENGTH) && n > op->max_length) {
+            fail(v, token, JSMN_SCHEMA_FAIL_MAX_LENGTH, pc);
+        }
+    }
+    if (has_members && tok->type == JSMN_OBJECT) {
+        check_members(v, pc, token);
+    }
+    if (items >= 0 && tok->type == JSMN_ARRAY) {
+        int child = token + 1;
+        for (int i = 0; i < tok->child_count; i++) {
+            check_value(v, items, child);
+            child = tokens[child].end_index;
+        }
+    }
+}
+
+static void check_members(check_t *v, int pc, int token) {
+    const jsmn_schema_op_t *op = &v->code[pc];
+    const jsmn_token_t *tokens = v->parser->tokens;
+    uint64_t seen = 0;
+
+    // one walk over the members: each key is looked up among the required
+    // names and the properties, and its value checked in place
+    int key = token + 1;
+    for (int m = 0; m < tokens[token].child_count; m++) {
+        const jsmn_token_t *k = &tokens[key];
+        bool checked = false;
+        int bit = 0;
+        for (int i = pc + 1; i < pc + op->span;) {
+            const jsmn_schema_op_t *ins = &v->code[i];
+            bool match = (ins->op == JSMN_SCHEMA_OP_REQUIRED ||
+                          ins->op == JSMN_SCHEMA_OP_PROPERTY) &&
+                         ins->len == k->strlen &&
+                         memcmp(ins->name, k->start, (size_t)k->strlen) == 0;
+            if (ins->op == JSMN_SCHEMA_OP_REQUIRED) {
+                if (match) {
+                    seen |= (uint64_t)1 << bit;
+                }
+                bit++;
+                i++;
+            } else if (ins->op == JSMN_SCHEMA_OP_PROPERTY) {
+                if (match && !checked) {
+                    check_value(v, i + 1, key + 1);
+                    checked = true;
+                }
+                i += 1 + v->code[i + 1].span;
+            } else if (ins->op == JSMN_SCHEMA_OP_ITEMS) {
+                i += 1 + v->code[i + 1].span;
+            } else {
+                i++;
+            }
+        }
+        key = tokens[key + 1].end_index;
+    }
+
+    int bit = 0;
+    for (int i = pc + 1; i < pc + op->span;) {
+        const jsmn_schema_op_t *ins = &v->code[i];
+        if (ins->op == JSMN_SCHEMA_OP_REQUIRED) {
+            if ((seen >> bit & 1) == 0) {
+                fail(v, token, JSMN_SCHEMA_FAIL_REQUIRED, i);
+            }
+            bit++;
+            i++;
+        } else if (ins->op == JSMN_SCHEMA_OP_PROPERTY ||
+                   ins->op == JSMN_SCHEMA_OP_ITEMS) {
+            i += 1 + v->code[i + 1].span;
+        } else {
+            i++;
+        }
+    }
+}
+
+static bool enum_matches(jsmn_token_t *token, const jsmn_schema_op_t *op) {
+    double num;
+
+    if (op->lit == JSMN_CLASS_NONE) {
+        return token->type == JSMN_STRING && token->strlen == op->len &&
+               memcmp(token->start, op->name, (size_t)op->len) == 0;
+    }
+    if (op->lit == JSMN_CLASS_FLOAT) {
+        return token_number(token, &num) && num == op->num;
+    }
+    return jsmn_token_class(token) == op->lit;
+}
+
+static void fail(check_t *v, int token, jsmn_schema_fail_t keyword, int pc) {
+    if (v->count < v->max_errors) {
+        jsmn_schema_error_t *e = &v->errors[v->count];
+        e->token = token;
+        e->keyword = keyword;
+        e->op = pc;
+    }
+    v->count++;
+}
+
+static int code_points(const char *s, int len) {
+    int n = 0;
+
+    for (int i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '\\' && i + 1 < len) {
+            if (s[i + 1] == 'u' && i + 5 < len) {
+                // the low half of a surrogate pair was counted with the high
+                char hex[5];
+                memcpy(hex, &s[i + 2], 4);
+                hex[4] = '\0';
+                long u = strtol(hex, NULL, 16);
+                n += (u < 0xdc00 || u > 0xdfff);
+                i += 5;
+            } else {
+                n++;
+                i++;
+            }
+        } else if ((c & 0xc0) != 0x80) {
+            // count UTF-8 lead bytes, not continuation bytes
+            n++;
+        }
+    }
+    return n;
+}
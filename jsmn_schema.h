@@ -0,0 +1,158 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_SCHEMA_H
+#define JSMN_SCHEMA_H
+
+#include "jsmn.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Most `required` names a single (sub)schema may list */
+#define JSMN_SCHEMA_MAX_REQUIRED 64
+
+typedef enum {
+  /* The schema uses something jsmn_schema_compile() does not support */
+  JSMN_SCHEMA_ERROR_INVAL = -1,
+  /* The code array is too small for the schema */
+  JSMN_SCHEMA_ERROR_NOMEM = -2
+} jsmn_schema_err_t;
+
+typedef enum {
+  JSMN_SCHEMA_OP_SCHEMA,   // a (sub)schema: type and bounds, then its ops
+  JSMN_SCHEMA_OP_REQUIRED, // member `name` must be present
+  JSMN_SCHEMA_OP_ENUM,     // one allowed value
+  JSMN_SCHEMA_OP_PROPERTY, // member `name` is checked against the next op
+  JSMN_SCHEMA_OP_ITEMS     // every element is checked against the next op
+} jsmn_schema_opcode_t;
+
+/* Bits of jsmn_schema_op_t.types, one per `type` name */
+typedef enum {
+  JSMN_SCHEMA_TYPE_OBJECT = 1 << 0,
+  JSMN_SCHEMA_TYPE_ARRAY = 1 << 1,
+  JSMN_SCHEMA_TYPE_STRING = 1 << 2,
+  JSMN_SCHEMA_TYPE_NUMBER = 1 << 3,
+  JSMN_SCHEMA_TYPE_INTEGER = 1 << 4,
+  JSMN_SCHEMA_TYPE_BOOLEAN = 1 << 5,
+  JSMN_SCHEMA_TYPE_NULL = 1 << 6
+} jsmn_schema_type_t;
+
+/* Bits of jsmn_schema_op_t.bounds: which limits a SCHEMA op sets */
+typedef enum {
+  JSMN_SCHEMA_HAS_MINIMUM = 1 << 0,
+  JSMN_SCHEMA_HAS_MAXIMUM = 1 << 1,
+  JSMN_SCHEMA_HAS_MIN_LENGTH = 1 << 2,
+  JSMN_SCHEMA_HAS_MAX_LENGTH = 1 << 3
+} jsmn_schema_bound_t;
+
+/* The keyword a value failed */
+typedef enum {
+  JSMN_SCHEMA_FAIL_TYPE,
+  JSMN_SCHEMA_FAIL_REQUIRED,
+  JSMN_SCHEMA_FAIL_ENUM,
+  JSMN_SCHEMA_FAIL_MINIMUM,
+  JSMN_SCHEMA_FAIL_MAXIMUM,
+  JSMN_SCHEMA_FAIL_MIN_LENGTH,
+  JSMN_SCHEMA_FAIL_MAX_LENGTH
+} jsmn_schema_fail_t;
+
+/**
+ * One instruction.  A SCHEMA op is followed by its REQUIRED, ENUM, PROPERTY
+ * and ITEMS ops, `span` instructions in all counting itself; PROPERTY and
+ * ITEMS are each followed by the SCHEMA op they apply.
+ */
+typedef struct {
+  unsigned char op;     // jsmn_schema_opcode_t
+  unsigned char types;  // SCHEMA: jsmn_schema_type_t bits, 0 for any
+  unsigned char bounds; // SCHEMA: jsmn_schema_bound_t bits
+  unsigned char lit;    // ENUM: literal class, JSMN_CLASS_FLOAT for any
+                        // number, JSMN_CLASS_NONE for a string
+  int span;             // SCHEMA: instructions in the schema
+  int min_length;       // SCHEMA: minLength
+  int max_length;       // SCHEMA: maxLength
+  double minimum;       // SCHEMA: minimum
+  double maximum;       // SCHEMA: maximum
+  double num;           // ENUM: number literal
+  const char *name;     // REQUIRED / PROPERTY name, ENUM string literal,
+                        // in the schema text
+  int len;              // length of name
+} jsmn_schema_op_t;
+
+/**
+ * A compiled schema.  Points into the schema text and the code array, which
+ * must outlive it.
+ */
+typedef struct {
+  const jsmn_schema_op_t *code; // instructions
+  int count;                    // number of instructions
+} jsmn_schema_t;
+
+/**
+ * A failed check: the token that failed it, the keyword, and the
+ * instruction holding the keyword (the REQUIRED op for a missing member).
+ */
+typedef struct {
+  int token;   // index of the failing value, the object for `required`
+  int keyword; // jsmn_schema_fail_t
+  int op;      // index of the instruction in the schema's code
+} jsmn_schema_error_t;
+
+/**
+ * @brief Compile the JSON Schema at token root of parser, which has parsed
+ * the schema text, into code (code_size instructions).
+ *
+ * Supported keywords: `type` (a name or an array of names), `required`,
+ * `properties`, `enum` with string, number, true, false and null values,
+ * `minimum`, `maximum`, `minLength`, `maxLength` and `items` with a single
+ * schema.  Other keywords, such as `$schema`, `title` and `description`, are
+ * ignored.  Names and string values are compared as written, escapes
+ * included.  A schema may list at most JSMN_SCHEMA_MAX_REQUIRED required
+ * names.
+ *
+ * Returns the number of instructions, JSMN_SCHEMA_ERROR_INVAL or
+ * JSMN_SCHEMA_ERROR_NOMEM.
+ */
+int jsmn_schema_compile(jsmn_schema_t *schema, jsmn_parser_t *parser, int root,
+                        jsmn_schema_op_t *code, int code_size);
+
+/**
+ * @brief Check the value at token root of parser against schema, in one pass
+ * over its tokens.  Failed checks are stored in errors, up to max_errors of
+ * them.  Returns the total number of failed checks, 0 if the value is valid;
+ * the total may exceed max_errors.
+ *
+ * A value of the wrong type is not checked further.  String lengths count
+ * code points, with each escape counted as the character it stands for.
+ */
+int jsmn_schema_validate(const jsmn_schema_t *schema, jsmn_parser_t *parser,
+                         int root, jsmn_schema_error_t *errors,
+                         int max_errors);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_SCHEMA_H */
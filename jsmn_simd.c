@@ -0,0 +1,561 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_simd.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+// *****************************************************************************
+// local types and definitions
+
+typedef size_t (*scan_fn)(const char *s, size_t n);
+typedef size_t (*scan_padded_fn)(const char *s);
+
+/* One implementation of every kernel */
+typedef struct {
+    scan_fn scan_string;
+    scan_fn scan_string_nul;
+    scan_padded_fn scan_string_padded;
+    scan_fn scan_unescaped;
+    scan_fn scan_plain;
+    scan_fn skip_space;
+    scan_fn scan_utf8;
+} kernels_t;
+
+/*
+ * The kernels in use, NULL until the first call picks them.  Racing first
+ * calls pick the same ones, so the pointer only needs to be read and written
+ * whole.
+ */
+static const kernels_t *s_active;
+
+#if defined(__GNUC__)
+#define LOAD_ACTIVE() __atomic_load_n(&s_active, __ATOMIC_ACQUIRE)
+#define STORE_ACTIVE(k) __atomic_store_n(&s_active, (k), __ATOMIC_RELEASE)
+#else
+#define LOAD_ACTIVE() (s_active)
+#define STORE_ACTIVE(k) (s_active = (k))
+#endif
+
+/*
+ * Define name(): the offset of the first byte that mask() flags, taking
+ * width bytes at a time, with tail() finishing the last few bytes.  mask()
+ * returns one bit per byte, lowest for the first.
+ */
+#define FIND_KERNEL(name, target, width, mask, tail)                           \
+    target static size_t name(const char *s, size_t n) {                       \
+        size_t i = 0;                                                          \
+        for (; i + (width) <= n; i += (width)) {                               \
+            uint64_t m = mask(&s[i]);                                          \
+            if (m != 0) {                                                      \
+                return i + (size_t)__builtin_ctzll(m);                         \
+            }                                                                  \
+        }                                                                      \
+        return tail(s, i, n);                                                  \
+    }
+
+/*
+ * Define name(): the offset of the first byte that mask() flags, with no
+ * length.  The caller's NUL sentinel is flagged, and every block read
+ * starts at or before it, so the padding behind it covers the widest one.
+ */
+#define PADDED_KERNEL(name, target, width, mask)                               \
+    target static size_t name(const char *s) {                                 \
+        for (size_t i = 0;; i += (width)) {                                    \
+            uint64_t m = mask(&s[i]);                                          \
+            if (m != 0) {                                                      \
+                return i + (size_t)__builtin_ctzll(m);                         \
+            }                                                                  \
+        }                                                                      \
+    }
+
+/*
+ * Define name(): jsmn_scan_utf8() skipping width bytes at a time while
+ * ascii() flags no byte at or above 0x80, and decoding the rest one
+ * sequence at a time.
+ */
+#define UTF8_KERNEL(name, target, width, ascii)                                \
+    target static size_t name(const char *s, size_t n) {                       \
+        size_t i = 0;                                                          \
+        while (i + (width) <= n) {                                             \
+            uint64_t m = ascii(&s[i]);                                         \
+            if (m == 0) {                                                      \
+                i += (width);                                                  \
+                continue;                                                      \
+            }                                                                  \
+            i += (size_t)__builtin_ctzll(m);                                   \
+            size_t len = utf8_sequence((const unsigned char *)&s[i], n - i);   \
+            if (len == 0) {                                                    \
+                return i;                                                      \
+            }                                                                  \
+            i += len;                                                          \
+        }                                                                      \
+        return utf8_tail(s, i, n);                                             \
+    }
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Return the kernels in use, picking them on the first call.
+ */
+static const kernels_t *active(void);
+
+/**
+ * Return the best instruction set the CPU supports.
+ */
+static jsmn_isa_t best_isa(void);
+
+/**
+ * Portable versions of the kernels, from offset i on.  They also finish the
+ * bytes left over by the wide ones.
+ */
+static size_t string_tail(const char *s, size_t i, size_t n);
+static size_t string_nul_tail(const char *s, size_t i, size_t n);
+static size_t unescaped_tail(const char *s, size_t i, size_t n);
+static size_t plain_tail(const char *s, size_t i, size_t n);
+static size_t space_tail(const char *s, size_t i, size_t n);
+static size_t utf8_tail(const char *s, size_t i, size_t n);
+
+static size_t scan_string_scalar(const char *s, size_t n);
+static size_t scan_string_nul_scalar(const char *s, size_t n);
+static size_t scan_string_padded_scalar(const char *s);
+static size_t scan_unescaped_scalar(const char *s, size_t n);
+static size_t scan_plain_scalar(const char *s, size_t n);
+static size_t skip_space_scalar(const char *s, size_t n);
+static size_t scan_utf8_scalar(const char *s, size_t n);
+
+/**
+ * Return the length of the valid UTF-8 sequence at s (n bytes available),
+ * or 0 if it is invalid.
+ */
+static size_t utf8_sequence(const unsigned char *s, size_t n);
+
+static const kernels_t s_kernels[JSMN_ISA_AVX512 + 1];
+
+// *****************************************************************************
+// public functions
+
+jsmn_isa_t jsmn_simd_isa(void) {
+    return (jsmn_isa_t)(active() - s_kernels);
+}
+
+int jsmn_simd_select(jsmn_isa_t isa) {
+    if ((int)isa < 0 || isa > best_isa() ||
+        s_kernels[isa].scan_string == NULL) {
+        return -1;
+    }
+    STORE_ACTIVE(&s_kernels[isa]);
+    return 0;
+}
+
+size_t jsmn_scan_string(const char *s, size_t n) {
+    return active()->scan_string(s, n);
+}
+
+size_t jsmn_scan_string_nul(const char *s, size_t n) {
+    return active()->scan_string_nul(s, n);
+}
+
+size_t jsmn_scan_string_padded(const char *s) {
+    return active()->scan_string_padded(s);
+}
+
+size_t jsmn_scan_unescaped(const char *s, size_t n) {
+    return active()->scan_unescaped(s, n);
+}
+
+size_t jsmn_scan_plain(const char *s, size_t n) {
+    return active()->scan_plain(s, n);
+}
+
+size_t jsmn_skip_space(const char *s, size_t n) {
+    return active()->skip_space(s, n);
+}
+
+size_t jsmn_scan_utf8(const char *s, size_t n) {
+    return active()->scan_utf8(s, n);
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static const kernels_t *active(void) {
+    const kernels_t *k = LOAD_ACTIVE();
+    if (k == NULL) {
+        k = &s_kernels[best_isa()];
+        STORE_ACTIVE(k);
+    }
+    return k;
+}
+
+static jsmn_isa_t best_isa(void) {
+#if SIMD_X86
+    __builtin_cpu_init();
+    // the checks include the OS saving the wider registers
+    if (__builtin_cpu_supports("avx512bw")) {
+        return JSMN_ISA_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return JSMN_ISA_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return JSMN_ISA_SSE2;
+    }
+#endif
+    return JSMN_ISA_SCALAR;
+}
+
+static size_t string_tail(const char *s, size_t i, size_t n) {
+    for (; i < n; i++) {
+        if (s[i] == '\"' || s[i] == '\\') {
+            break;
+        }
+    }
+    return i;
+}
+
+static size_t string_nul_tail(const char *s, size_t i, size_t n) {
+    for (; i < n; i++) {
+        if (s[i] == '\"' || s[i] == '\\' || s[i] == '\0') {
+            break;
+        }
+    }
+    return i;
+}
+
+static size_t unescaped_tail(const char *s, size_t i, size_t n) {
+    for (; i < n; i++) {
+        unsigned char c = s[i];
+        if (c < 0x20 || c == '\"' || c == '\\') {
+            break;
+        }
+    }
+    return i;
+}
+
+static size_t plain_tail(const char *s, size_t i, size_t n) {
+    for (; i < n; i++) {
+        char c = s[i];
+        if (c == '\"' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            break;
+        }
+    }
+    return i;
+}
+
+static size_t space_tail(const char *s, size_t i, size_t n) {
+    for (; i < n; i++) {
+        char c = s[i];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            break;
+        }
+    }
+    return i;
+}
+
+static size_t utf8_tail(const char *s, size_t i, size_t n) {
+    while (i < n) {
+        size_t len = utf8_sequence((const unsigned char *)&s[i], n - i);
+        if (len == 0) {
+            break;
+        }
+        i += len;
+    }
+    return i;
+}
+
+static size_t scan_string_scalar(const char *s, size_t n) {
+    return string_tail(s, 0, n);
+}
+
+static size_t scan_string_nul_scalar(const char *s, size_t n) {
+    return string_nul_tail(s, 0, n);
+}
+
+static size_t scan_string_padded_scalar(const char *s) {
+    size_t i = 0;
+    while (s[i] != '\"' && s[i] != '\\' && s[i] != '\0') {
+        i++;
+    }
+    return i;
+}
+
+static size_t scan_unescaped_scalar(const char *s, size_t n) {
+    return unescaped_tail(s, 0, n);
+}
+
+static size_t scan_plain_scalar(const char *s, size_t n) {
+    return plain_tail(s, 0, n);
+}
+
+static size_t skip_space_scalar(const char *s, size_t n) {
+    return space_tail(s, 0, n);
+}
+
+static size_t scan_utf8_scalar(const char *s, size_t n) {
+    return utf8_tail(s, 0, n);
+}
+
+static size_t utf8_sequence(const unsigned char *s, size_t n) {
+    unsigned char c = s[0];
+    unsigned char lo = 0x80; // range of the second byte
+    unsigned char hi = 0xbf;
+    size_t len;
+
+    if (c < 0x80) {
+        return 1;
+    }
+    if (c < 0xc2) {
+        // a continuation byte, or the lead of an overlong 2-byte form
+        return 0;
+    }
+    if (c < 0xe0) {
+        len = 2;
+    } else if (c < 0xf0) {
+        len = 3;
+        lo = (c == 0xe0) ? 0xa0 : lo; // overlong
+        hi = (c == 0xed) ? 0x9f : hi; // surrogates
+    } else if (c < 0xf5) {
+        len = 4;
+        lo = (c == 0xf0) ? 0x90 : lo; // overlong
+        hi = (c == 0xf4) ? 0x8f : hi; // above U+10FFFF
+    } else {
+        return 0;
+    }
+    if (n < len || s[1] < lo || s[1] > hi) {
+        return 0;
+    }
+    for (size_t i = 2; i < len; i++) {
+        if ((s[i] & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+    return len;
+}
+
+#if SIMD_X86
+
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+// SSE2: 16 bytes, compare results gathered with movemask
+
+TARGET_SSE2 static inline uint64_t sse2_string(const char *p) {
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    return (unsigned)_mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\"')),
+                     _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'))));
+}
+
+TARGET_SSE2 static inline uint64_t sse2_string_nul(const char *p) {
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    return (unsigned)_mm_movemask_epi8(
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\"')),
+                                  _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'))),
+                     _mm_cmpeq_epi8(x, _mm_setzero_si128())));
+}
+
+TARGET_SSE2 static inline uint64_t sse2_unescaped(const char *p) {
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    __m128i control = _mm_set1_epi8(0x1f);
+    // x <= 0x1f (unsigned) iff max(x, 0x1f) == 0x1f
+    return (unsigned)_mm_movemask_epi8(_mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\"')),
+                     _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'))),
+        _mm_cmpeq_epi8(_mm_max_epu8(x, control), control)));
+}
+
+TARGET_SSE2 static inline __m128i sse2_spaces(__m128i x) {
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                                     _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'))),
+                        _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\r')),
+                                     _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'))));
+}
+
+TARGET_SSE2 static inline uint64_t sse2_plain(const char *p) {
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    return (unsigned)_mm_movemask_epi8(
+        _mm_or_si128(sse2_spaces(x), _mm_cmpeq_epi8(x, _mm_set1_epi8('\"'))));
+}
+
+TARGET_SSE2 static inline uint64_t sse2_nonspace(const char *p) {
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    return ~(unsigned)_mm_movemask_epi8(sse2_spaces(x)) & 0xffffu;
+}
+
+TARGET_SSE2 static inline uint64_t sse2_nonascii(const char *p) {
+    return (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p));
+}
+
+FIND_KERNEL(scan_string_sse2, TARGET_SSE2, 16, sse2_string, string_tail)
+FIND_KERNEL(scan_string_nul_sse2, TARGET_SSE2, 16, sse2_string_nul,
+            string_nul_tail)
+PADDED_KERNEL(scan_string_padded_sse2, TARGET_SSE2, 16, sse2_string_nul)
+FIND_KERNEL(scan_unescaped_sse2, TARGET_SSE2, 16, sse2_unescaped,
+            unescaped_tail)
+FIND_KERNEL(scan_plain_sse2, TARGET_SSE2, 16, sse2_plain, plain_tail)
+FIND_KERNEL(skip_space_sse2, TARGET_SSE2, 16, sse2_nonspace, space_tail)
+UTF8_KERNEL(scan_utf8_sse2, TARGET_SSE2, 16, sse2_nonascii)
+
+// AVX2: the same 32 bytes at a time
+
+TARGET_AVX2 static inline uint64_t avx2_string(const char *p) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)p);
+    return (uint32_t)_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\"')),
+                        _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\'))));
+}
+
+TARGET_AVX2 static inline uint64_t avx2_string_nul(const char *p) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)p);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\"')),
+                        _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\'))),
+        _mm256_cmpeq_epi8(x, _mm256_setzero_si256())));
+}
+
+TARGET_AVX2 static inline uint64_t avx2_unescaped(const char *p) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)p);
+    __m256i control = _mm256_set1_epi8(0x1f);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\"')),
+                        _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\'))),
+        _mm256_cmpeq_epi8(_mm256_max_epu8(x, control), control)));
+}
+
+TARGET_AVX2 static inline __m256i avx2_spaces(__m256i x) {
+    return _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r')),
+                        _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'))));
+}
+
+TARGET_AVX2 static inline uint64_t avx2_plain(const char *p) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)p);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(
+        avx2_spaces(x), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\"'))));
+}
+
+TARGET_AVX2 static inline uint64_t avx2_nonspace(const char *p) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)p);
+    return ~(uint32_t)_mm256_movemask_epi8(avx2_spaces(x)) & 0xffffffffu;
+}
+
+TARGET_AVX2 static inline uint64_t avx2_nonascii(const char *p) {
+    return (uint32_t)_mm256_movemask_epi8(
+        _mm256_loadu_si256((const __m256i *)p));
+}
+
+FIND_KERNEL(scan_string_avx2, TARGET_AVX2, 32, avx2_string, string_tail)
+FIND_KERNEL(scan_string_nul_avx2, TARGET_AVX2, 32, avx2_string_nul,
+            string_nul_tail)
+PADDED_KERNEL(scan_string_padded_avx2, TARGET_AVX2, 32, avx2_string_nul)
+FIND_KERNEL(scan_unescaped_avx2, TARGET_AVX2, 32, avx2_unescaped,
+            unescaped_tail)
+FIND_KERNEL(scan_plain_avx2, TARGET_AVX2, 32, avx2_plain, plain_tail)
+FIND_KERNEL(skip_space_avx2, TARGET_AVX2, 32, avx2_nonspace, space_tail)
+UTF8_KERNEL(scan_utf8_avx2, TARGET_AVX2, 32, avx2_nonascii)
+
+// AVX-512BW: 64 bytes, compares straight into mask registers
+
+TARGET_AVX512 static inline uint64_t avx512_string(const char *p) {
+    __m512i x = _mm512_loadu_si512((const void *)p);
+    return _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\"')) |
+           _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\\'));
+}
+
+TARGET_AVX512 static inline uint64_t avx512_string_nul(const char *p) {
+    __m512i x = _mm512_loadu_si512((const void *)p);
+    return _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\"')) |
+           _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\\')) |
+           _mm512_testn_epi8_mask(x, x);
+}
+
+TARGET_AVX512 static inline uint64_t avx512_unescaped(const char *p) {
+    __m512i x = _mm512_loadu_si512((const void *)p);
+    return _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\"')) |
+           _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\\')) |
+           _mm512_cmple_epu8_mask(x, _mm512_set1_epi8(0x1f));
+}
+
+TARGET_AVX512 static inline uint64_t avx512_spaces(__m512i x) {
+    return _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(' ')) |
+           _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\t')) |
+           _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\r')) |
+           _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\n'));
+}
+
+TARGET_AVX512 static inline uint64_t avx512_plain(const char *p) {
+    __m512i x = _mm512_loadu_si512((const void *)p);
+    return avx512_spaces(x) | _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\"'));
+}
+
+TARGET_AVX512 static inline uint64_t avx512_nonspace(const char *p) {
+    return ~avx512_spaces(_mm512_loadu_si512((const void *)p));
+}
+
+TARGET_AVX512 static inline uint64_t avx512_nonascii(const char *p) {
+    return _mm512_movepi8_mask(_mm512_loadu_si512((const void *)p));
+}
+
+FIND_KERNEL(scan_string_avx512, TARGET_AVX512, 64, avx512_string,
+            string_tail)
+FIND_KERNEL(scan_string_nul_avx512, TARGET_AVX512, 64, avx512_string_nul,
+            string_nul_tail)
+PADDED_KERNEL(scan_string_padded_avx512, TARGET_AVX512, 64,
+              avx512_string_nul)
+FIND_KERNEL(scan_unescaped_avx512, TARGET_AVX512, 64, avx512_unescaped,
+            unescaped_tail)
+FIND_KERNEL(scan_plain_avx512, TARGET_AVX512, 64, avx512_plain, plain_tail)
+FIND_KERNEL(skip_space_avx512, TARGET_AVX512, 64, avx512_nonspace,
+            space_tail)
+UTF8_KERNEL(scan_utf8_avx512, TARGET_AVX512, 64, avx512_nonascii)
+
+#endif /* SIMD_X86 */
+
+/* Indexed by jsmn_isa_t; levels missing from the build are left empty */
+static const kernels_t s_kernels[JSMN_ISA_AVX512 + 1] = {
+    {scan_string_scalar, scan_string_nul_scalar, scan_string_padded_scalar,
+     scan_unescaped_scalar, scan_plain_scalar, skip_space_scalar,
+     scan_utf8_scalar},
+#if SIMD_X86
+    {scan_string_sse2, scan_string_nul_sse2, scan_string_padded_sse2,
+     scan_unescaped_sse2, scan_plain_sse2, skip_space_sse2, scan_utf8_sse2},
+    {scan_string_avx2, scan_string_nul_avx2, scan_string_padded_avx2,
+     scan_unescaped_avx2, scan_plain_avx2, skip_space_avx2, scan_utf8_avx2},
+    {scan_string_avx512, scan_string_nul_avx512, scan_string_padded_avx512,
+     scan_unescaped_avx512, scan_plain_avx512, skip_space_avx512,
+     scan_utf8_avx512},
+#endif
+};
@@ -0,0 +1,109 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_SIMD_H
+#define JSMN_SIMD_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Instruction set levels the scanning kernels are built for, lowest first.
+ * Levels other than JSMN_ISA_SCALAR exist only in x86 builds with GCC or
+ * clang; each is used only where the running CPU supports it.
+ */
+typedef enum {
+  JSMN_ISA_SCALAR, // portable C
+  JSMN_ISA_SSE2,   // 16 bytes at a time
+  JSMN_ISA_AVX2,   // 32 bytes at a time
+  JSMN_ISA_AVX512  // 64 bytes at a time (AVX-512BW)
+} jsmn_isa_t;
+
+/**
+ * @brief Return the instruction set the kernels below use.  The best one
+ * the CPU supports is picked at the first call to any of these functions,
+ * once per process.
+ */
+jsmn_isa_t jsmn_simd_isa(void);
+
+/**
+ * @brief Use the kernels for isa from now on, for tests and benchmarks.
+ * Returns 0, or -1 (changing nothing) if the CPU or the build lacks isa.
+ * Not safe to call while other threads use the kernels.
+ */
+int jsmn_simd_select(jsmn_isa_t isa);
+
+/**
+ * @brief Return the offset of the first '"' or '\\' in the n bytes at s, or
+ * n if there is none.
+ */
+size_t jsmn_scan_string(const char *s, size_t n);
+
+/**
+ * @brief Like jsmn_scan_string(), but also stopping at a NUL byte, where
+ * the parsers' input ends.  The parsers use it to pass over string text.
+ */
+size_t jsmn_scan_string_nul(const char *s, size_t n);
+
+/**
+ * @brief Like jsmn_scan_string_nul(), without a length: the text must end
+ * in a NUL followed by at least 63 more readable bytes (the JSMN_PADDING
+ * of jsmn_parse_padded()), as the kernels read whole blocks of up to 64
+ * bytes without checking where the text ends.
+ */
+size_t jsmn_scan_string_padded(const char *s);
+
+/**
+ * @brief Return the offset of the first byte JSON requires escaping in a
+ * string ('"', '\\' or a control character below 0x20), or n.
+ */
+size_t jsmn_scan_unescaped(const char *s, size_t n);
+
+/**
+ * @brief Return the offset of the first whitespace byte or '"', or n: the
+ * end of a run that minifying can copy as it stands.
+ */
+size_t jsmn_scan_plain(const char *s, size_t n);
+
+/**
+ * @brief Return the offset of the first byte that is not JSON whitespace
+ * (space, tab, CR or LF), or n.
+ */
+size_t jsmn_skip_space(const char *s, size_t n);
+
+/**
+ * @brief Return the offset of the first byte of the first invalid UTF-8
+ * sequence, or n if all n bytes are valid UTF-8.  Overlong forms,
+ * surrogates and code points above U+10FFFF are invalid, as is a sequence
+ * cut short by the end.
+ */
+size_t jsmn_scan_utf8(const char *s, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_SIMD_H */
@@ -0,0 +1,200 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_tape.h"
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/* Multiplier and seed of the checksum (64-bit golden ratio, FNV offset) */
+#define CHECKSUM_PRIME 0x9e3779b97f4a7c15ULL
+#define CHECKSUM_SEED 0xcbf29ce484222325ULL
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Fold one 64-bit word into checksum h.
+ */
+static uint64_t checksum_mix(uint64_t h, uint64_t word);
+
+// *****************************************************************************
+// public functions
+
+size_t jsmn_tape_size(int token_count) {
+    return sizeof(jsmn_tape_header_t) +
+           (size_t)token_count * sizeof(jsmn_tape_entry_t);
+}
+
+int jsmn_tape_write(const jsmn_parser_t *parser, const char *js, size_t len,
+                    void *buf, size_t buf_size) {
+    if (parser->tokens == NULL || len > UINT32_MAX) {
+        return JSMN_TAPE_ERROR_INVAL;
+    }
+    if (buf_size < jsmn_tape_size((int)parser->token_count)) {
+        return JSMN_TAPE_ERROR_NOMEM;
+    }
+    jsmn_tape_header_t header;
+    jsmn_tape_entry_t *entries =
+        (jsmn_tape_entry_t *)((char *)buf + sizeof(header));
+
+    for (unsigned int i = 0; i < parser->token_count; i++) {
+        const jsmn_token_t *tok = &parser->tokens[i];
+        jsmn_tape_entry_t entry;
+        size_t offset = (size_t)(tok->start - js);
+        if (tok->start < js || offset + (size_t)tok->strlen > len) {
+            return JSMN_TAPE_ERROR_INVAL;
+        }
+        memset(&entry, 0, sizeof(entry));
+        entry.offset = (uint32_t)offset;
+        entry.strlen = (uint32_t)tok->strlen;
+        entry.type = tok->type;
+        entry.subtype = tok->subtype;
+        entry.child_count = tok->child_count;
+        entry.parent_index = tok->parent_index;
+        entry.level = tok->level;
+        entry.end_index = tok->end_index;
+        memcpy(&entries[i], &entry, sizeof(entry));
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = JSMN_TAPE_MAGIC;
+    header.version = JSMN_TAPE_VERSION;
+    header.entry_size = sizeof(jsmn_tape_entry_t);
+    header.token_count = parser->token_count;
+    header.json_length = len;
+    header.json_checksum = jsmn_tape_checksum(js, len);
+    header.entry_checksum = jsmn_tape_checksum(
+        entries, (size_t)parser->token_count * sizeof(jsmn_tape_entry_t));
+    memcpy(buf, &header, sizeof(header));
+    return 0;
+}
+
+int jsmn_tape_open(jsmn_tape_t *tape, const void *buf, size_t buf_size,
+                   const char *js, size_t len, bool verify) {
+    jsmn_tape_header_t header;
+
+    if (buf_size < sizeof(header)) {
+        return JSMN_TAPE_ERROR_FORMAT;
+    }
+    memcpy(&header, buf, sizeof(header));
+    if (header.magic != JSMN_TAPE_MAGIC ||
+        header.version != JSMN_TAPE_VERSION ||
+        header.entry_size != sizeof(jsmn_tape_entry_t) ||
+        header.token_count > INT32_MAX) {
+        return JSMN_TAPE_ERROR_FORMAT;
+    }
+    if (buf_size < jsmn_tape_size((int)header.token_count)) {
+        return JSMN_TAPE_ERROR_NOMEM;
+    }
+    if (header.json_length != len) {
+        return JSMN_TAPE_ERROR_STALE;
+    }
+    const jsmn_tape_entry_t *entries =
+        (const jsmn_tape_entry_t *)((const char *)buf + sizeof(header));
+    if (verify &&
+        (jsmn_tape_checksum(js, len) != header.json_checksum ||
+         jsmn_tape_checksum(entries, header.token_count *
+                                         sizeof(jsmn_tape_entry_t)) !=
+             header.entry_checksum)) {
+        return JSMN_TAPE_ERROR_STALE;
+    }
+    tape->entries = entries;
+    tape->token_count = (int)header.token_count;
+    tape->js = js;
+    tape->len = len;
+    return 0;
+}
+
+int jsmn_tape_token(const jsmn_tape_t *tape, int index, jsmn_token_t *token) {
+    if (index < 0 || index >= tape->token_count) {
+        return JSMN_TAPE_ERROR_INVAL;
+    }
+    const jsmn_tape_entry_t *entry = &tape->entries[index];
+    // the checksums are optional, so check what walkers would follow
+    if ((uint64_t)entry->offset + entry->strlen > tape->len ||
+        entry->strlen > INT32_MAX || entry->end_index <= index ||
+        entry->end_index > tape->token_count || entry->parent_index < -1 ||
+        entry->parent_index >= index || entry->child_count < 0 ||
+        entry->child_count >= tape->token_count - index) {
+        return JSMN_TAPE_ERROR_FORMAT;
+    }
+    token->start = tape->js + entry->offset;
+    token->type = entry->type;
+    token->subtype = entry->subtype;
+    token->symbol = 0;
+    token->strlen = (int)entry->strlen;
+    token->child_count = entry->child_count;
+    token->parent_index = entry->parent_index;
+    token->level = entry->level;
+    token->end_index = entry->end_index;
+    return 0;
+}
+
+int jsmn_tape_load(const jsmn_tape_t *tape, jsmn_parser_t *parser) {
+    if (parser->tokens == NULL ||
+        (unsigned int)tape->token_count > parser->num_tokens) {
+        return JSMN_TAPE_ERROR_NOMEM;
+    }
+    for (int i = 0; i < tape->token_count; i++) {
+        int r = jsmn_tape_token(tape, i, &parser->tokens[i]);
+        if (r < 0) {
+            return r;
+        }
+    }
+    parser->token_count = (unsigned int)tape->token_count;
+    jsmn_child_index_invalidate(parser);
+    parser->pos = (unsigned int)tape->len;
+    parser->parent_index = -1;
+    parser->level = 0;
+    return tape->token_count;
+}
+
+uint64_t jsmn_tape_checksum(const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t h = CHECKSUM_SEED ^ len;
+    uint64_t word;
+
+    for (; len >= sizeof(word); p += sizeof(word), len -= sizeof(word)) {
+        memcpy(&word, p, sizeof(word));
+        h = checksum_mix(h, word);
+    }
+    word = 0;
+    memcpy(&word, p, len);
+    h = checksum_mix(h, word);
+    // final avalanche so nearby inputs differ in every bit
+    h ^= h >> 33;
+    h *= CHECKSUM_PRIME;
+    h ^= h >> 29;
+    return h;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static uint64_t checksum_mix(uint64_t h, uint64_t word) {
+    h = (h ^ word) * CHECKSUM_PRIME;
+    return h ^ (h >> 32);
+}
@@ -0,0 +1,157 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_TAPE_H
+#define JSMN_TAPE_H
+
+#include "jsmn.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A tape is the token array of one parse, saved in a flat binary form that
+ * can be written to a file and later mapped back in (e.g. with mmap())
+ * alongside the JSON it was made from.  Opening a tape does no parsing:
+ * tokens are read straight out of it.
+ *
+ * Layout: a jsmn_tape_header_t followed by token_count jsmn_tape_entry_t,
+ * all in the byte order of the host that wrote it.  Token strings are kept
+ * as byte offsets into the JSON, which is why the JSON must be supplied
+ * when the tape is opened.
+ */
+
+/** "JSMT" read as a little-endian word; a byte-swapped tape will not match. */
+#define JSMN_TAPE_MAGIC 0x544d534aU
+
+/** Bumped whenever the layout of the header or entries changes. */
+#define JSMN_TAPE_VERSION 1
+
+typedef enum {
+  /* The tape buffer is too small, or the token array is */
+  JSMN_TAPE_ERROR_NOMEM = -1,
+  /* Not a tape, or one of another version or byte order */
+  JSMN_TAPE_ERROR_FORMAT = -2,
+  /* The JSON or the entries do not match the tape's checksums */
+  JSMN_TAPE_ERROR_STALE = -3,
+  /* The parse has no tokens to save, or its JSON is over 4 GiB */
+  JSMN_TAPE_ERROR_INVAL = -4
+} jsmn_tape_err_t;
+
+typedef struct {
+  uint32_t magic;          // JSMN_TAPE_MAGIC
+  uint16_t version;        // JSMN_TAPE_VERSION
+  uint16_t entry_size;     // sizeof(jsmn_tape_entry_t)
+  uint32_t token_count;    // number of entries that follow
+  uint32_t reserved;       // zero
+  uint64_t json_length;    // length of the JSON the tape was made from
+  uint64_t json_checksum;  // jsmn_tape_checksum() of that JSON
+  uint64_t entry_checksum; // jsmn_tape_checksum() of the entries
+} jsmn_tape_header_t;
+
+typedef struct {
+  uint32_t offset;      // token start, as a byte offset into the JSON
+  uint32_t strlen;      // length of token string
+  uint8_t type;         // jsmn_token_type_t
+  uint8_t subtype;      // jsmn_class_t of a PRIMITIVE, else 0
+  uint16_t reserved;    // zero
+  int32_t child_count;  // as in jsmn_token_t
+  int32_t parent_index; // as in jsmn_token_t
+  int32_t level;        // as in jsmn_token_t
+  int32_t end_index;    // as in jsmn_token_t
+} jsmn_tape_entry_t;
+
+/**
+ * An opened tape.  Points into the caller's tape and JSON buffers, which
+ * must outlive it.
+ */
+typedef struct {
+  const jsmn_tape_entry_t *entries; // the tape's entries
+  int token_count;                  // number of entries
+  const char *js;                   // the JSON the entries refer to
+  size_t len;                       // its length
+} jsmn_tape_t;
+
+/**
+ * @brief Return the number of bytes needed to save a parse of token_count
+ * tokens.
+ */
+size_t jsmn_tape_size(int token_count);
+
+/**
+ * @brief Save the tokens of the last parse of js (len bytes) by parser into
+ * buf, which must hold jsmn_tape_size(parser->token_count) bytes.
+ *
+ * Returns 0, JSMN_TAPE_ERROR_NOMEM if buf is too small, or
+ * JSMN_TAPE_ERROR_INVAL if the parse did not store tokens or len does not
+ * fit a tape offset.
+ */
+int jsmn_tape_write(const jsmn_parser_t *parser, const char *js, size_t len,
+                    void *buf, size_t buf_size);
+
+/**
+ * @brief Open the tape in buf (buf_size bytes, 4-byte aligned, as a mapping
+ * is) for use with js (len bytes).
+ *
+ * The header is always checked, including that len matches the JSON the
+ * tape was made from.  With verify set the JSON and the entries are also
+ * checksummed, which catches a changed file of the same length at the cost
+ * of one pass over both.
+ *
+ * Returns 0, JSMN_TAPE_ERROR_FORMAT, JSMN_TAPE_ERROR_NOMEM if buf is
+ * shorter than the header says, or JSMN_TAPE_ERROR_STALE.
+ */
+int jsmn_tape_open(jsmn_tape_t *tape, const void *buf, size_t buf_size,
+                   const char *js, size_t len, bool verify);
+
+/**
+ * @brief Copy token index of an open tape into token.  Returns 0,
+ * JSMN_TAPE_ERROR_INVAL if index is out of range, or JSMN_TAPE_ERROR_FORMAT
+ * if the entry points outside the JSON or the tape (its string past len,
+ * its end_index or parent_index out of order), which catches damage that an
+ * unverified jsmn_tape_open() lets through.
+ */
+int jsmn_tape_token(const jsmn_tape_t *tape, int index, jsmn_token_t *token);
+
+/**
+ * @brief Expand an open tape into the token array of parser, leaving parser
+ * as the original parse left it.  Returns the number of tokens,
+ * JSMN_TAPE_ERROR_NOMEM if the token array is too small, or
+ * JSMN_TAPE_ERROR_FORMAT if an entry is out of range (see jsmn_tape_token()).
+ */
+int jsmn_tape_load(const jsmn_tape_t *tape, jsmn_parser_t *parser);
+
+/**
+ * @brief Return the 64-bit checksum a tape uses for len bytes at data.
+ */
+uint64_t jsmn_tape_checksum(const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_TAPE_H */
@@ -0,0 +1,745 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jsmn_writer.h"
+#include "jsmn_simd.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// local types and definitions
+
+/* Per-level writer state bits */
+#define WS_OBJECT 0x01    // level is an object
+#define WS_ARRAY 0x02     // level is an array
+#define WS_HAS_ITEMS 0x04 // at least one value or key written at this level
+#define WS_AFTER_KEY 0x08 // a key was written, its value is expected next
+
+/* A floating point number and its binary exponent, as used by Grisu2 */
+typedef struct {
+    uint64_t f;
+    int e;
+} diy_fp_t;
+
+static const char s_hex_digits[] = "0123456789abcdef";
+
+static const char s_digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const uint32_t s_pow10[] = {1,      10,      100,      1000,     10000,
+                                   100000, 1000000, 10000000, 100000000,
+                                   1000000000};
+
+/* Normalized 10^-348, 10^-340, ... 10^340 for Grisu2 */
+static const uint64_t s_cached_powers_f[] = {
+    0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76,
+    0xcf42894a5dce35ea, 0x9a6bb0aa55653b2d, 0xe61acf033d1a45df,
+    0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f, 0xbe5691ef416bd60c,
+    0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+    0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57,
+    0xc21094364dfb5637, 0x9096ea6f3848984f, 0xd77485cb25823ac7,
+    0xa086cfcd97bf97f4, 0xef340a98172aace5, 0xb23867fb2a35b28e,
+    0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+    0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126,
+    0xb5b5ada8aaff80b8, 0x87625f056c7c4a8b, 0xc9bcff6034c13053,
+    0x964e858c91ba2655, 0xdff9772470297ebd, 0xa6dfbd9fb8e5b88f,
+    0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+    0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06,
+    0xaa242499697392d3, 0xfd87b5f28300ca0e, 0xbce5086492111aeb,
+    0x8cbccc096f5088cc, 0xd1b71758e219652c, 0x9c40000000000000,
+    0xe8d4a51000000000, 0xad78ebc5ac620000, 0x813f3978f8940984,
+    0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068,
+    0x9f4f2726179a2245, 0xed63a231d4c4fb27, 0xb0de65388cc8ada8,
+    0x83c7088e1aab65db, 0xc45d1df942711d9a, 0x924d692ca61be758,
+    0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85,
+    0xb454e4a179dd1877, 0x865b86925b9bc5c2, 0xc83553c5c8965d3d,
+    0x952ab45cfa97a0b3, 0xde469fbd99a05fe3, 0xa59bc234db398c25,
+    0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece, 0x88fcf317f22241e2,
+    0xcc20ce9bd35c78a5, 0x98165af37b2153df, 0xe2a0b5dc971f303a,
+    0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410,
+    0x8bab8eefb6409c1a, 0xd01fef10a657842c, 0x9b10a4e5e9913129,
+    0xe7109bfba19c0c9d, 0xac2820d9623bf429, 0x80444b5e7aa7cf85,
+    0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841,
+    0x9e19db92b4e31ba9, 0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b};
+
+static const int16_t s_cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954,
+    -927, -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635,
+    -608, -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316,
+    -289, -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30, 56,
+    83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402, 428, 455,
+    481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800, 827, 853,
+    880, 907, 933, 960, 986, 1013, 1039, 1066};
+
+// *****************************************************************************
+// forward references to local functions
+
+/**
+ * Record err as the writer's error unless it already has one.
+ */
+static int fail(jsmn_writer_t *writer, int err);
+
+/**
+ * Append n bytes to the output, flushing as needed.
+ */
+static int put(jsmn_writer_t *writer, const char *s, size_t n);
+
+/**
+ * Slow path of put(): the bytes don't fit in the remaining buffer space.
+ */
+static int put_slow(jsmn_writer_t *writer, const char *s, size_t n);
+
+/**
+ * Emit whatever separator is due before a value and update the level state.
+ */
+static int begin_value(jsmn_writer_t *writer);
+
+static int begin_container(jsmn_writer_t *writer, char c, unsigned char type);
+static int end_container(jsmn_writer_t *writer, char c, unsigned char type);
+
+/**
+ * Emit whatever separator is due before a key and update the level state.
+ */
+static int begin_key(jsmn_writer_t *writer);
+
+/**
+ * Write s as a quoted, escaped JSON string.
+ */
+static int put_string(jsmn_writer_t *writer, const char *s, size_t n);
+
+/**
+ * Write the decimal digits of value so that they end just before end.
+ * Returns a pointer to the first digit.
+ */
+static char *format_uint(char *end, uint64_t value);
+
+/**
+ * Store the k digits of positive, finite value correctly rounded, such that
+ * value ~= digits * 10^K.  Returns true if they read back as value.
+ */
+static bool rounded_digits(double value, int k, char *digits, int *K);
+
+/**
+ * Write the k digits of value ~= 0.digits * 10^n at p in the form of
+ * ECMAScript's Number.prototype.toString().  Returns the end of the text.
+ */
+static char *format_decimal(char *p, const char *digits, int k, int n);
+
+/**
+ * Grisu2: produce the shortest digits (in most cases) for a positive, finite
+ * value, such that value ~= digits * 10^K.  Returns the number of digits.
+ */
+static int grisu2(double value, char *digits, int *K);
+
+// *****************************************************************************
+// public functions
+
+void jsmn_writer_init(jsmn_writer_t *writer, char *buf, size_t size,
+                      jsmn_writer_flush_fn flush, void *flush_arg) {
+    writer->buf = buf;
+    writer->size = size;
+    writer->len = 0;
+    writer->total = 0;
+    writer->flush = flush;
+    writer->flush_arg = flush_arg;
+    writer->error = 0;
+    writer->depth = 0;
+    writer->state[0] = 0;
+}
+
+int jsmn_writer_flush(jsmn_writer_t *writer) {
+    if (writer->error) {
+        return writer->error;
+    }
+    if (writer->flush != NULL && writer->len > 0) {
+        if (writer->flush(writer->flush_arg, writer->buf, writer->len) != 0) {
+            return fail(writer, JSMN_WRITER_ERROR_FLUSH);
+        }
+        writer->len = 0;
+    }
+    return 0;
+}
+
+int jsmn_writer_write(jsmn_writer_t *writer, const char *buf, size_t len) {
+    return put(writer, buf, len);
+}
+
+size_t jsmn_writer_length(jsmn_writer_t *writer) { return writer->total; }
+
+int jsmn_writer_begin_object(jsmn_writer_t *writer) {
+    return begin_container(writer, '{', WS_OBJECT);
+}
+
+int jsmn_writer_end_object(jsmn_writer_t *writer) {
+    return end_container(writer, '}', WS_OBJECT);
+}
+
+int jsmn_writer_begin_array(jsmn_writer_t *writer) {
+    return begin_container(writer, '[', WS_ARRAY);
+}
+
+int jsmn_writer_end_array(jsmn_writer_t *writer) {
+    return end_container(writer, ']', WS_ARRAY);
+}
+
+int jsmn_writer_key(jsmn_writer_t *writer, const char *key) {
+    return jsmn_writer_keyn(writer, key, strlen(key));
+}
+
+int jsmn_writer_keyn(jsmn_writer_t *writer, const char *key, size_t len) {
+    if (begin_key(writer) < 0 || put_string(writer, key, len) < 0) {
+        return writer->error;
+    }
+    return put(writer, ":", 1);
+}
+
+int jsmn_writer_string(jsmn_writer_t *writer, const char *str) {
+    return jsmn_writer_stringn(writer, str, strlen(str));
+}
+
+int jsmn_writer_stringn(jsmn_writer_t *writer, const char *str, size_t len) {
+    if (begin_value(writer) < 0) {
+        return writer->error;
+    }
+    return put_string(writer, str, len);
+}
+
+int jsmn_writer_int(jsmn_writer_t *writer, int64_t value) {
+    char buf[21];
+    char *p;
+
+    if (value < 0) {
+        p = format_uint(&buf[sizeof(buf)], (uint64_t)0 - (uint64_t)value);
+        *--p = '-';
+    } else {
+        p = format_uint(&buf[sizeof(buf)], (uint64_t)value);
+    }
+    return jsmn_writer_raw(writer, p, &buf[sizeof(buf)] - p);
+}
+
+int jsmn_writer_uint(jsmn_writer_t *writer, uint64_t value) {
+    char buf[20];
+    char *p = format_uint(&buf[sizeof(buf)], value);
+    return jsmn_writer_raw(writer, p, &buf[sizeof(buf)] - p);
+}
+
+int jsmn_writer_double(jsmn_writer_t *writer, double value) {
+    char buf[25];
+    int n = jsmn_format_double(buf, value);
+    if (n == 0) {
+        return fail(writer, JSMN_WRITER_ERROR_INVAL);
+    }
+    return jsmn_writer_raw(writer, buf, n);
+}
+
+int jsmn_writer_bool(jsmn_writer_t *writer, bool value) {
+    return value ? jsmn_writer_raw(writer, "true", 4)
+                 : jsmn_writer_raw(writer, "false", 5);
+}
+
+int jsmn_writer_null(jsmn_writer_t *writer) {
+    return jsmn_writer_raw(writer, "null", 4);
+}
+
+int jsmn_writer_raw(jsmn_writer_t *writer, const char *json, size_t len) {
+    if (begin_value(writer) < 0) {
+        return writer->error;
+    }
+    return put(writer, json, len);
+}
+
+int jsmn_writer_token(jsmn_writer_t *writer, jsmn_parser_t *parser,
+                      int token_index) {
+    jsmn_token_t *token = jsmn_token_ref(parser, token_index);
+    unsigned char state = writer->state[writer->depth];
+    const char *s;
+    size_t n;
+
+    if (token == NULL) {
+        return fail(writer, JSMN_WRITER_ERROR_INVAL);
+    }
+    s = jsmn_token_string(token);
+    n = jsmn_token_strlen(token);
+    if (jsmn_token_is_string(token)) {
+        // include the quotes
+        s--;
+        n += 2;
+    }
+    if ((state & WS_OBJECT) && !(state & WS_AFTER_KEY)) {
+        // a key is expected
+        if (!jsmn_token_is_string(token)) {
+            return fail(writer, JSMN_WRITER_ERROR_INVAL);
+        }
+        if (begin_key(writer) < 0 || put(writer, s, n) < 0) {
+            return writer->error;
+        }
+        return put(writer, ":", 1);
+    }
+    return jsmn_writer_raw(writer, s, n);
+}
+
+int jsmn_format_double(char *buf, double value) {
+    char digits[18];
+    char *p = buf;
+    int k; // number of digits
+    int K;
+
+    if (value != value || value - value != 0.0) {
+        // NaN or infinite
+        return 0;
+    }
+    if (value == 0.0) {
+        // includes -0, which ECMAScript also writes as "0"
+        *p = '0';
+        return 1;
+    }
+    if (value < 0) {
+        *p++ = '-';
+        value = -value;
+    }
+    k = grisu2(value, digits, &K);
+    return format_decimal(p, digits, k, k + K) - buf;
+}
+
+int jsmn_format_double_shortest(char *buf, double value) {
+    char digits[18];
+    char *p = buf;
+    int k;
+    int K;
+
+    if (value != value || value - value != 0.0 || value == 0.0) {
+        return jsmn_format_double(buf, value);
+    }
+    if (value < 0) {
+        *p++ = '-';
+        value = -value;
+    }
+    // Grisu2's digits read back as value, but may be a digit longer than
+    // needed, or not the closest at the last digit: the C library's
+    // correctly rounded digits settle both
+    k = grisu2(value, digits, &K);
+    while (k > 1 && rounded_digits(value, k - 1, digits, &K)) {
+        k--;
+    }
+    rounded_digits(value, k, digits, &K);
+    while (k > 1 && digits[k - 1] == '0') {
+        k--;
+        K++;
+    }
+    return format_decimal(p, digits, k, k + K) - buf;
+}
+
+// *****************************************************************************
+// local (private) functions
+
+static bool rounded_digits(double value, int k, char *digits, int *K) {
+    char text[32];
+    const char *q;
+    int m = 0;
+
+    // "d.ddde-xx": gather the digits, skipping the point, and the exponent
+    snprintf(text, sizeof(text), "%.*e", k - 1, value);
+    for (q = text; *q != 'e'; q++) {
+        if (*q >= '0' && *q <= '9') {
+            digits[m++] = *q;
+        }
+    }
+    *K = (int)strtol(q + 1, NULL, 10) + 1 - k;
+    return strtod(text, NULL) == value;
+}
+
+static char *format_decimal(char *p, const char *digits, int k, int n) {
+    // Number::toString(): see ECMA-262, section 7.1.12.1
+    if (k <= n && n <= 21) {
+        // integer: digits followed by n - k zeros
+        memcpy(p, digits, k);
+        p += k;
+        memset(p, '0', n - k);
+        p += n - k;
+    } else if (0 < n && n <= 21) {
+        // decimal point inside the digits
+        memcpy(p, digits, n);
+        p += n;
+        *p++ = '.';
+        memcpy(p, &digits[n], k - n);
+        p += k - n;
+    } else if (-6 < n && n <= 0) {
+        // 0.000ddd
+        *p++ = '0';
+        *p++ = '.';
+        memset(p, '0', -n);
+        p += -n;
+        memcpy(p, digits, k);
+        p += k;
+    } else {
+        // exponential: d.ddde+xx
+        int e = n - 1;
+        char exp[3];
+        char *q;
+
+        *p++ = digits[0];
+        if (k > 1) {
+            *p++ = '.';
+            memcpy(p, &digits[1], k - 1);
+            p += k - 1;
+        }
+        *p++ = 'e';
+        *p++ = (e < 0) ? '-' : '+';
+        q = format_uint(&exp[sizeof(exp)], e < 0 ? -e : e);
+        memcpy(p, q, &exp[sizeof(exp)] - q);
+        p += &exp[sizeof(exp)] - q;
+    }
+    return p;
+}
+
+static int fail(jsmn_writer_t *writer, int err) {
+    if (writer->error == 0) {
+        writer->error = err;
+    }
+    return writer->error;
+}
+
+static int put(jsmn_writer_t *writer, const char *s, size_t n) {
+    if (n <= writer->size - writer->len && writer->error == 0) {
+        memcpy(&writer->buf[writer->len], s, n);
+        writer->len += n;
+        writer->total += n;
+        return 0;
+    }
+    return put_slow(writer, s, n);
+}
+
+static int put_slow(jsmn_writer_t *writer, const char *s, size_t n) {
+    if (writer->error) {
+        return writer->error;
+    }
+    if (writer->flush == NULL) {
+        return fail(writer, JSMN_WRITER_ERROR_NOMEM);
+    }
+    if (jsmn_writer_flush(writer) < 0) {
+        return writer->error;
+    }
+    if (n >= writer->size) {
+        // too big to buffer: pass it straight through
+        if (writer->flush(writer->flush_arg, s, n) != 0) {
+            return fail(writer, JSMN_WRITER_ERROR_FLUSH);
+        }
+        writer->total += n;
+        return 0;
+    }
+    return put(writer, s, n);
+}
+
+static int begin_value(jsmn_writer_t *writer) {
+    unsigned char *state = &writer->state[writer->depth];
+
+    if (writer->error) {
+        return writer->error;
+    }
+    if (*state & WS_AFTER_KEY) {
+        *state &= ~WS_AFTER_KEY;
+        return 0;
+    }
+    if (*state & WS_OBJECT) {
+        // a key is required first
+        return fail(writer, JSMN_WRITER_ERROR_INVAL);
+    }
+    if (*state & WS_HAS_ITEMS) {
+        return put(writer, writer->depth == 0 ? "\n" : ",", 1);
+    }
+    *state |= WS_HAS_ITEMS;
+    return 0;
+}
+
+static int begin_container(jsmn_writer_t *writer, char c, unsigned char type) {
+    if (begin_value(writer) < 0) {
+        return writer->error;
+    }
+    if (writer->depth >= JSMN_WRITER_MAX_DEPTH) {
+        return fail(writer, JSMN_WRITER_ERROR_INVAL);
+    }
+    writer->state[++writer->depth] = type;
+    return put(writer, &c, 1);
+}
+
+static int end_container(jsmn_writer_t *writer, char c, unsigned char type) {
+    unsigned char state = writer->state[writer->depth];
+
+    if (writer->error) {
+        return writer->error;
+    }
+    if (!(state & type) || (state & WS_AFTER_KEY)) {
+        // not in a matching container, or a key is missing its value
+        return fail(writer, JSMN_WRITER_ERROR_INVAL);
+    }
+    writer->depth--;
+    return put(writer, &c, 1);
+}
+
+static int begin_key(jsmn_writer_t *writer) {
+    unsigned char *state = &writer->state[writer->depth];
+
+    if (writer->error) {
+        return writer->error;
+    }
+    if (!(*state & WS_OBJECT) || (*state & WS_AFTER_KEY)) {
+        return fail(writer, JSMN_WRITER_ERROR_INVAL);
+    }
+    if (*state & WS_HAS_ITEMS) {
+        if (put(writer, ",", 1) < 0) {
+            return writer->error;
+        }
+    }
+    *state |= WS_HAS_ITEMS | WS_AFTER_KEY;
+    return 0;
+}
+
+static int put_string(jsmn_writer_t *writer, const char *s, size_t n) {
+    if (put(writer, "\"", 1) < 0) {
+        return writer->error;
+    }
+    while (n > 0) {
+        size_t run = jsmn_scan_unescaped(s, n);
+        unsigned char c;
+        char esc[6];
+
+        if (put(writer, s, run) < 0) {
+            return writer->error;
+        }
+        s += run;
+        n -= run;
+        if (n == 0) {
+            break;
+        }
+        c = (unsigned char)*s++;
+        n--;
+        esc[0] = '\\';
+        switch (c) {
+        case '\"':
+        case '\\':
+            esc[1] = c;
+            break;
+        case '\b':
+            esc[1] = 'b';
+            break;
+        case '\f':
+            esc[1] = 'f';
+            break;
+        case '\n':
+            esc[1] = 'n';
+            break;
+        case '\r':
+            esc[1] = 'r';
+            break;
+        case '\t':
+            esc[1] = 't';
+            break;
+        default:
+            // other control characters
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = s_hex_digits[c >> 4];
+            esc[5] = s_hex_digits[c & 0xf];
+            if (put(writer, esc, 6) < 0) {
+                return writer->error;
+            }
+            continue;
+        }
+        if (put(writer, esc, 2) < 0) {
+            return writer->error;
+        }
+    }
+    return put(writer, "\"", 1);
+}
+
+static char *format_uint(char *end, uint64_t value) {
+    while (value >= 100) {
+        unsigned int i = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        end -= 2;
+        memcpy(end, &s_digit_pairs[i], 2);
+    }
+    if (value >= 10) {
+        end -= 2;
+        memcpy(end, &s_digit_pairs[value * 2], 2);
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return end;
+}
+
+static diy_fp_t diy_fp_mul(diy_fp_t a, diy_fp_t b) {
+    // upper 64 bits of the 128 bit product, rounded
+    const uint64_t M32 = 0xFFFFFFFF;
+    uint64_t ah = a.f >> 32, al = a.f & M32;
+    uint64_t bh = b.f >> 32, bl = b.f & M32;
+    uint64_t hh = ah * bh, lh = al * bh, hl = ah * bl, ll = al * bl;
+    uint64_t mid = (ll >> 32) + (hl & M32) + (lh & M32) + (1U << 31);
+    diy_fp_t r;
+
+    r.f = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+    r.e = a.e + b.e + 64;
+    return r;
+}
+
+static diy_fp_t diy_fp_normalize(diy_fp_t x) {
+    while (!(x.f & ((uint64_t)1 << 63))) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+static void grisu_round(char *digits, int len, uint64_t delta, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w ||
+            wp_w - rest > rest + ten_kappa - wp_w)) {
+        digits[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int digit_gen(diy_fp_t w, diy_fp_t mp, uint64_t delta, char *digits,
+                     int *K) {
+    diy_fp_t one;
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1;
+    uint64_t p2;
+    int kappa = 10;
+    int len = 0;
+
+    one.f = (uint64_t)1 << -mp.e;
+    one.e = mp.e;
+    p1 = (uint32_t)(mp.f >> -one.e);
+    p2 = mp.f & (one.f - 1);
+    while (kappa > 1 && p1 < s_pow10[kappa - 1]) {
+        kappa--;
+    }
+
+    // integral digits
+    while (kappa > 0) {
+        uint32_t d = p1 / s_pow10[kappa - 1];
+        uint64_t rest;
+
+        p1 %= s_pow10[kappa - 1];
+        if (d || len) {
+            digits[len++] = (char)('0' + d);
+        }
+        kappa--;
+        rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest <= delta) {
+            *K += kappa;
+            grisu_round(digits, len, delta, rest,
+                        (uint64_t)s_pow10[kappa] << -one.e, wp_w);
+            return len;
+        }
+    }
+
+    // fractional digits
+    for (;;) {
+        char d;
+
+        p2 *= 10;
+        delta *= 10;
+        d = (char)(p2 >> -one.e);
+        if (d || len) {
+            digits[len++] = (char)('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            grisu_round(digits, len, delta, p2, one.f,
+                        -kappa < 10 ? wp_w * s_pow10[-kappa] : 0);
+            return len;
+        }
+    }
+}
+
+static int grisu2(double value, char *digits, int *K) {
+    uint64_t bits;
+    diy_fp_t v, plus, minus, c_mk, w, wp, wm;
+    int biased_e;
+    int k, index, len;
+    double dk;
+
+    memcpy(&bits, &value, sizeof(bits));
+    biased_e = (int)((bits >> 52) & 0x7FF);
+    v.f = bits & (((uint64_t)1 << 52) - 1);
+    if (biased_e != 0) {
+        v.f += (uint64_t)1 << 52;
+        v.e = biased_e - 1075;
+    } else {
+        v.e = 1 - 1075;
+    }
+
+    // boundaries m+ and m-, normalized to the same exponent
+    plus.f = (v.f << 1) + 1;
+    plus.e = v.e - 1;
+    plus = diy_fp_normalize(plus);
+    if (v.f == (uint64_t)1 << 52) {
+        minus.f = (v.f << 2) - 1;
+        minus.e = v.e - 2;
+    } else {
+        minus.f = (v.f << 1) - 1;
+        minus.e = v.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    // cached power c_mk = 10^-k such that the products land in a fixed range
+    dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    k = (int)dk;
+    if (dk - k > 0.0) {
+        k++;
+    }
+    index = (k >> 3) + 1;
+    *K = -(-348 + index * 8);
+    c_mk.f = s_cached_powers_f[index];
+    c_mk.e = s_cached_powers_e[index];
+
+    w = diy_fp_mul(diy_fp_normalize(v), c_mk);
+    wp = diy_fp_mul(plus, c_mk);
+    wm = diy_fp_mul(minus, c_mk);
+    wm.f++;
+    wp.f--;
+    len = digit_gen(w, wp, wp.f - wm.f, digits, K);
+
+    // grisu_round() may leave a trailing zero behind
+    while (len > 1 && digits[len - 1] == '0') {
+        len--;
+        (*K)++;
+    }
+    return len;
+}
@@ -0,0 +1,173 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2010 Serge Zaitsev
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef JSMN_WRITER_H
+#define JSMN_WRITER_H
+
+#include "jsmn.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Deepest nesting of objects and arrays a writer can track.  May be
+ * overridden at build time.
+ */
+#ifndef JSMN_WRITER_MAX_DEPTH
+#define JSMN_WRITER_MAX_DEPTH 32
+#endif
+
+typedef enum {
+  /* Output buffer is full and there is no flush function */
+  JSMN_WRITER_ERROR_NOMEM = -1,
+  /* The flush function reported a failure */
+  JSMN_WRITER_ERROR_FLUSH = -2,
+  /* Call is not valid here (e.g. value where a key is expected) */
+  JSMN_WRITER_ERROR_INVAL = -3
+} jsmn_writer_err_t;
+
+/**
+ * Called with the buffered output when the buffer fills up and from
+ * jsmn_writer_flush().  Return 0 on success, anything else on failure.
+ */
+typedef int (*jsmn_writer_flush_fn)(void *arg, const char *buf, size_t len);
+
+/**
+ * JSON writer.  Appends JSON text to a caller supplied buffer, handing the
+ * buffer to an optional flush function whenever it fills up.  Commas and
+ * colons are inserted automatically.  Consecutive top-level values are
+ * separated by a newline.
+ */
+typedef struct {
+  char *buf;                      // output buffer
+  size_t size;                    // capacity of buf
+  size_t len;                     // bytes currently held in buf
+  size_t total;                   // bytes written, including flushed ones
+  jsmn_writer_flush_fn flush;     // called when buf fills up, or NULL
+  void *flush_arg;                // passed to flush
+  int error;                      // first error encountered, or 0
+  int depth;                      // current nesting level
+  unsigned char state[JSMN_WRITER_MAX_DEPTH + 1]; // per-level state
+} jsmn_writer_t;
+
+/**
+ * @brief Prepare a writer over buf.  If flush is NULL, output that does not
+ * fit in buf fails with JSMN_WRITER_ERROR_NOMEM.
+ */
+void jsmn_writer_init(jsmn_writer_t *writer, char *buf, size_t size,
+                      jsmn_writer_flush_fn flush, void *flush_arg);
+
+/**
+ * @brief Hand any buffered output to the flush function.  Returns 0 on
+ * success or a (sticky) negative jsmn_writer_err_t.
+ */
+int jsmn_writer_flush(jsmn_writer_t *writer);
+
+/**
+ * @brief Append len bytes verbatim, bypassing separator and nesting
+ * bookkeeping.  Intended for formatters that produce complete JSON text
+ * themselves.  Returns 0 or a negative jsmn_writer_err_t.
+ */
+int jsmn_writer_write(jsmn_writer_t *writer, const char *buf, size_t len);
+
+/**
+ * @brief Return the number of bytes written so far, including those already
+ * flushed.
+ */
+size_t jsmn_writer_length(jsmn_writer_t *writer);
+
+/**
+ * The functions below return 0 on success or a negative jsmn_writer_err_t.
+ * Errors are sticky: once a call fails, every later call returns the same
+ * error without writing anything.
+ */
+
+int jsmn_writer_begin_object(jsmn_writer_t *writer);
+int jsmn_writer_end_object(jsmn_writer_t *writer);
+int jsmn_writer_begin_array(jsmn_writer_t *writer);
+int jsmn_writer_end_array(jsmn_writer_t *writer);
+
+/**
+ * @brief Write an object key.  The key is escaped as needed.
+ */
+int jsmn_writer_key(jsmn_writer_t *writer, const char *key);
+int jsmn_writer_keyn(jsmn_writer_t *writer, const char *key, size_t len);
+
+/**
+ * @brief Write a string value.  The string is escaped as needed.
+ */
+int jsmn_writer_string(jsmn_writer_t *writer, const char *str);
+int jsmn_writer_stringn(jsmn_writer_t *writer, const char *str, size_t len);
+
+int jsmn_writer_int(jsmn_writer_t *writer, int64_t value);
+int jsmn_writer_uint(jsmn_writer_t *writer, uint64_t value);
+
+/**
+ * @brief Write value in the format of ECMAScript's Number.prototype.toString()
+ * using Grisu2: the digits always read back as value and are the shortest
+ * such digits for all but a tiny fraction of inputs.  NaN and infinities have
+ * no JSON form and fail with JSMN_WRITER_ERROR_INVAL.
+ */
+int jsmn_writer_double(jsmn_writer_t *writer, double value);
+
+int jsmn_writer_bool(jsmn_writer_t *writer, bool value);
+int jsmn_writer_null(jsmn_writer_t *writer);
+
+/**
+ * @brief Write len bytes of already-formatted JSON as a single value.
+ */
+int jsmn_writer_raw(jsmn_writer_t *writer, const char *json, size_t len);
+
+/**
+ * @brief Re-emit a parsed token, including any subtree below it, by copying
+ * its span of the original JSON verbatim.  A string token written where a
+ * key is expected becomes the key.
+ */
+int jsmn_writer_token(jsmn_writer_t *writer, jsmn_parser_t *parser,
+                      int token_index);
+
+/**
+ * @brief Format value into buf (at least 25 bytes) the way
+ * jsmn_writer_double() writes it.  Returns the length, or 0 for NaN and
+ * infinities.  No NUL terminator is written.
+ */
+int jsmn_format_double(char *buf, double value);
+
+/**
+ * @brief Like jsmn_format_double(), but exactly as ECMAScript writes value:
+ * the shortest digits that read back as value and, of those, the closest,
+ * as canonical forms require.  Grisu2's digits are checked against the C
+ * library's correctly rounded ones, which costs a couple of snprintf() and
+ * strtod() calls per value.
+ */
+int jsmn_format_double_shortest(char *buf, double value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_WRITER_H */
@@ -1,11 +1,33 @@
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
+#include <unistd.h>
+
+#include "../jsmn_bind.h"
+#include "../jsmn_cache.h"
+#include "../jsmn_canon.h"
+#include "../jsmn_format.h"
+#include "../jsmn_hash.h"
+#include "../jsmn_patch.h"
+#include "../jsmn_path.h"
+#include "../jsmn_reader.h"
+#include "../jsmn_reparse.h"
+#include "../jsmn_schema.h"
+#include "../jsmn_simd.h"
+#include "../jsmn_tape.h"
+#include "../jsmn_writer.h"
 #include "test.h"
 #include "testutil.h"
 
+/* A private parser variant, as an application would instantiate one */
+#define JSMN_ENGINE_NAME test_parse_counted
+#define JSMN_ENGINE_STRICT 1
+#define JSMN_ENGINE_STATS 1
+#define JSMN_ENGINE_API static
+#include "../jsmn_engine.h"
+
 int test_empty(void) {
   check(parse("{}", 1, 1, JSMN_OBJECT, 0, 2, 0));
   check(parse("[]", 1, 1, JSMN_ARRAY, 0, 2, 0));
@@ -711,6 +733,1835 @@ int test_find_fns(void) {
     return 0;
 }
 
+int test_stats(void) {
+#ifdef JSMN_STATS
+    jsmn_token_t tokens[8];
+    jsmn_parser_t parser;
+    jsmn_stats_t stats;
+    const char *js;
+
+    // five tokens won't fit in four
+    js = "{\"a\\n\": [1, {}]}";
+    jsmn_init(&parser, tokens, 4);
+    check(jsmn_parse(&parser, js, strlen(js)) == JSMN_ERROR_NOMEM);
+    jsmn_stats_get(&parser, &stats);
+    check(stats.nomem_retries == 1);
+    check(stats.tokens_allocated == 4);
+    check(stats.escapes == 1);
+
+    // counters accumulate across calls until reset
+    jsmn_init(&parser, tokens, sizeof(tokens) / sizeof(tokens[0]));
+    check(jsmn_parse(&parser, js, strlen(js)) == 5);
+    check(jsmn_parse(&parser, js, strlen(js)) == 5);
+    jsmn_stats_get(&parser, &stats);
+    check(stats.bytes_scanned == 2 * strlen(js));
+    check(stats.tokens_allocated == 10);
+    check(stats.escapes == 2);
+    check(stats.nomem_retries == 0);
+
+    jsmn_stats_reset(&parser);
+    jsmn_stats_get(&parser, &stats);
+    check(stats.bytes_scanned == 0);
+    check(stats.max_depth == 0);
+
+    js = "[1, [2, [3]], 4]";
+    check(jsmn_parse(&parser, js, strlen(js)) == 7);
+    jsmn_stats_get(&parser, &stats);
+    check(stats.bytes_scanned == strlen(js));
+    check(stats.tokens_allocated == 7);
+    check(stats.max_depth == 3);
+    check(stats.backscan_steps > 0);
+#endif
+    return 0;
+}
+
+int test_limits(void) {
+    jsmn_token_t tokens[16];
+    jsmn_parser_t parser;
+    jsmn_limits_t limits;
+    const char *js;
+
+    js = "[[[1]], \"abcdef\", 12345]";
+
+    // depth
+    jsmn_init(&parser, tokens, 16);
+    memset(&limits, 0, sizeof(limits));
+    limits.max_depth = 2;
+    jsmn_set_limits(&parser, &limits);
+    check(jsmn_parse(&parser, js, strlen(js)) == JSMN_ERROR_LIMIT);
+    limits.max_depth = 3;
+    jsmn_set_limits(&parser, &limits);
+    check(jsmn_parse(&parser, js, strlen(js)) == 6);
+
+    // depth is enforced when counting tokens, too
+    jsmn_init(&parser, NULL, 0);
+    limits.max_depth = 2;
+    jsmn_set_limits(&parser, &limits);
+    check(jsmn_parse(&parser, js, strlen(js)) == JSMN_ERROR_LIMIT);
+
+    // token count: distinct from running out of token storage
+    jsmn_init(&parser, tokens, 16);
+    memset(&limits, 0, sizeof(limits));
+    limits.max_tokens = 5;
+    jsmn_set_limits(&parser, &limits);
+    check(jsmn_parse(&parser, js, strlen(js)) == JSMN_ERROR_LIMIT);
+    limits.max_tokens = 6;
+    jsmn_set_limits(&parser, &limits);
+    check(jsmn_parse(&parser, js, strlen(js)) == 6);
+
+    // string and primitive length
+    memset(&limits, 0, sizeof(limits));
+    limits.max_strlen = 5;
+    jsmn_set_limits(&parser, &limits);
+    check(jsmn_parse(&parser, js, strlen(js)) == JSMN_ERROR_LIMIT);
+    check(jsmn_parse(&parser, "[12345]", 7) == 2);
+    check(jsmn_parse(&parser, "[123456]", 8) == JSMN_ERROR_LIMIT);
+    check(jsmn_parse(&parser, "\"abcde\"", 7) == 1);
+    check(jsmn_parse(&parser, "\"abcd\\n\"", 8) == JSMN_ERROR_LIMIT);
+    check(jsmn_parse(&parser, "\"abc", 4) == JSMN_ERROR_PART);
+    limits.max_strlen = 6;
+    jsmn_set_limits(&parser, &limits);
+    check(jsmn_parse(&parser, js, strlen(js)) == 6);
+
+    // byte budget
+    memset(&limits, 0, sizeof(limits));
+    limits.max_bytes = 10;
+    jsmn_set_limits(&parser, &limits);
+    check(jsmn_parse(&parser, js, strlen(js)) == JSMN_ERROR_LIMIT);
+    check(jsmn_parse(&parser, "[1,2,3,4] ", 10) == 5);
+    check(jsmn_parse(&parser, "[1,2,3,4]  ", 11) == JSMN_ERROR_LIMIT);
+    check(jsmn_parse(&parser, "[1,2]\0     ", 11) == 3);
+    check(jsmn_parse(&parser, "[1,2\0      ", 11) == JSMN_ERROR_PART);
+
+    // jsmn_set_limits(NULL) removes every limit
+    jsmn_set_limits(&parser, NULL);
+    check(jsmn_parse(&parser, js, strlen(js)) == 6);
+    return 0;
+}
+
+static int collect(void *arg, const char *buf, size_t len) {
+    char *out = arg;
+    strncat(out, buf, len);
+    return 0;
+}
+
+int test_writer(void) {
+    char buf[256];
+    char out[256];
+    char small[8];
+    jsmn_writer_t w;
+
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_writer_begin_object(&w) == 0);
+    check(jsmn_writer_key(&w, "s") == 0);
+    check(jsmn_writer_string(&w, "a\"b\\c\n\x01/0123456789abcdef\t") == 0);
+    check(jsmn_writer_key(&w, "n") == 0);
+    check(jsmn_writer_begin_array(&w) == 0);
+    check(jsmn_writer_int(&w, 0) == 0);
+    check(jsmn_writer_int(&w, -9223372036854775807LL - 1) == 0);
+    check(jsmn_writer_uint(&w, 18446744073709551615ULL) == 0);
+    check(jsmn_writer_double(&w, 0.1) == 0);
+    check(jsmn_writer_double(&w, -1.5e-7) == 0);
+    check(jsmn_writer_double(&w, 1e21) == 0);
+    check(jsmn_writer_double(&w, 123456.0) == 0);
+    check(jsmn_writer_end_array(&w) == 0);
+    check(jsmn_writer_key(&w, "t") == 0);
+    check(jsmn_writer_bool(&w, true) == 0);
+    check(jsmn_writer_key(&w, "z") == 0);
+    check(jsmn_writer_null(&w) == 0);
+    check(jsmn_writer_end_object(&w) == 0);
+    check(jsmn_writer_length(&w) == w.len);
+    check(strncmp(buf,
+                  "{\"s\":\"a\\\"b\\\\c\\n\\u0001/0123456789abcdef\\t\","
+                  "\"n\":[0,-9223372036854775808,18446744073709551615,0.1,"
+                  "-1.5e-7,1e+21,123456],\"t\":true,\"z\":null}",
+                  w.len) == 0);
+
+    // misuse is reported and sticky
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_writer_begin_object(&w) == 0);
+    check(jsmn_writer_int(&w, 1) == JSMN_WRITER_ERROR_INVAL);
+    check(jsmn_writer_key(&w, "a") == JSMN_WRITER_ERROR_INVAL);
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_writer_begin_array(&w) == 0);
+    check(jsmn_writer_end_object(&w) == JSMN_WRITER_ERROR_INVAL);
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_writer_double(&w, 1.0 / 0.0) == JSMN_WRITER_ERROR_INVAL);
+
+    // a full buffer without a flush function
+    jsmn_writer_init(&w, small, sizeof(small), NULL, NULL);
+    check(jsmn_writer_string(&w, "too long to fit") == JSMN_WRITER_ERROR_NOMEM);
+
+    // with a flush function, output of any size goes through
+    out[0] = '\0';
+    jsmn_writer_init(&w, small, sizeof(small), collect, out);
+    check(jsmn_writer_begin_array(&w) == 0);
+    check(jsmn_writer_string(&w, "longer than the buffer") == 0);
+    check(jsmn_writer_int(&w, 42) == 0);
+    check(jsmn_writer_end_array(&w) == 0);
+    check(jsmn_writer_int(&w, 7) == 0);
+    check(jsmn_writer_flush(&w) == 0);
+    check(strcmp(out, "[\"longer than the buffer\",42]\n7") == 0);
+    check(jsmn_writer_length(&w) == strlen(out));
+    return 0;
+}
+
+int test_writer_tokens(void) {
+    jsmn_token_t tokens[16];
+    jsmn_parser_t parser;
+    jsmn_writer_t w;
+    char buf[128];
+    const char *js = "{\"a\": [1, 2], \"b\": {\"c\": \"x\\ty\"}, \"d\": null}";
+
+    jsmn_init(&parser, tokens, 16);
+    check(jsmn_parse(&parser, js, strlen(js)) == 11);
+
+    // copy the "b" member and the "a" value into a new object
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_writer_begin_object(&w) == 0);
+    check(jsmn_writer_token(&w, &parser, 5) == 0);
+    check(jsmn_writer_token(&w, &parser, 6) == 0);
+    check(jsmn_writer_key(&w, "a") == 0);
+    check(jsmn_writer_token(&w, &parser, 2) == 0);
+    check(jsmn_writer_end_object(&w) == 0);
+    check(strncmp(buf, "{\"b\":{\"c\": \"x\\ty\"},\"a\":[1, 2]}", w.len) == 0);
+
+    // only strings can be keys
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_writer_begin_object(&w) == 0);
+    check(jsmn_writer_token(&w, &parser, 3) == JSMN_WRITER_ERROR_INVAL);
+    check(jsmn_writer_token(&w, &parser, 99) == JSMN_WRITER_ERROR_INVAL);
+    return 0;
+}
+
+int test_minify(void) {
+    char buf[128];
+    jsmn_writer_t w;
+    const char *js = " { \"a b\" : [ 1 ,\t2 ] ,\n \"c\\\" d\" : \"\\\\\" , "
+                     "\"long string with  two  spaces\" : null }\n";
+
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_minify(js, strlen(js), &w) == 0);
+    check(strncmp(buf,
+                  "{\"a b\":[1,2],\"c\\\" d\":\"\\\\\","
+                  "\"long string with  two  spaces\":null}",
+                  w.len) == 0);
+
+    // an unterminated string is copied as is
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_minify("[ \"a\\", 5, &w) == 0);
+    check(w.len == 4 && strncmp(buf, "[\"a\\", 4) == 0);
+    return 0;
+}
+
+int test_pretty_print(void) {
+    jsmn_token_t tokens[16];
+    jsmn_parser_t parser;
+    jsmn_writer_t w;
+    jsmn_pretty_opts_t opts;
+    char buf[256];
+    const char *js = "{\"a\":[1, {\"b\" :\"x y\"}, []],\"c\":{}, \"d\": true}";
+
+    jsmn_init(&parser, tokens, 16);
+    check(jsmn_parse(&parser, js, strlen(js)) == 12);
+
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_pretty_print(&parser, 0, NULL, &w) == 0);
+    check(strncmp(buf,
+                  "{\n"
+                  "  \"a\": [\n"
+                  "    1,\n"
+                  "    {\n"
+                  "      \"b\": \"x y\"\n"
+                  "    },\n"
+                  "    []\n"
+                  "  ],\n"
+                  "  \"c\": {},\n"
+                  "  \"d\": true\n"
+                  "}",
+                  w.len) == 0);
+
+    // compact output from the tokens
+    opts.indent = 0;
+    opts.indent_char = ' ';
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_pretty_print(&parser, 0, &opts, &w) == 0);
+    check(strncmp(buf, "{\"a\":[1,{\"b\":\"x y\"},[]],\"c\":{},\"d\":true}",
+                  w.len) == 0);
+
+    // a subtree, indented with tabs
+    opts.indent = 1;
+    opts.indent_char = '\t';
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_pretty_print(&parser, 4, &opts, &w) == 0);
+    check(strncmp(buf, "{\n\t\"b\": \"x y\"\n}", w.len) == 0);
+
+    // nesting as deep as the limit, and deeper
+    opts.indent = 0;
+    static jsmn_token_t deep_tokens[JSMN_FORMAT_MAX_DEPTH + 2];
+    static char deep[2 * JSMN_FORMAT_MAX_DEPTH + 8];
+    static char out[2 * JSMN_FORMAT_MAX_DEPTH + 8];
+    for (int depth = JSMN_FORMAT_MAX_DEPTH; depth <= JSMN_FORMAT_MAX_DEPTH + 1;
+         depth++) {
+        memset(deep, '[', (size_t)depth);
+        deep[depth] = '1';
+        memset(&deep[depth + 1], ']', (size_t)depth);
+        deep[2 * depth + 1] = '\0';
+        jsmn_init(&parser, deep_tokens, JSMN_FORMAT_MAX_DEPTH + 2);
+        check(jsmn_parse(&parser, deep, strlen(deep)) == depth + 1);
+        jsmn_writer_init(&w, out, sizeof(out), NULL, NULL);
+        if (depth == JSMN_FORMAT_MAX_DEPTH) {
+            check(jsmn_pretty_print(&parser, 0, &opts, &w) == 0);
+            check(w.len == strlen(deep) && memcmp(out, deep, w.len) == 0);
+        } else {
+            check(jsmn_pretty_print(&parser, 0, &opts, &w) ==
+                  JSMN_WRITER_ERROR_INVAL);
+        }
+    }
+    return 0;
+}
+
+static int merge_patch_eq(const char *doc, const char *patch,
+                          const char *expected) {
+    jsmn_token_t doc_tokens[32];
+    jsmn_token_t patch_tokens[32];
+    jsmn_parser_t doc_parser;
+    jsmn_parser_t patch_parser;
+    jsmn_writer_t w;
+    char buf[256];
+
+    jsmn_init(&doc_parser, doc_tokens, 32);
+    jsmn_init(&patch_parser, patch_tokens, 32);
+    if (jsmn_parse(&doc_parser, doc, strlen(doc)) < 0 ||
+        jsmn_parse(&patch_parser, patch, strlen(patch)) < 0) {
+        return 0;
+    }
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    if (jsmn_merge_patch(&doc_parser, &patch_parser, &w) != 0) {
+        return 0;
+    }
+    if (w.len != strlen(expected) || strncmp(buf, expected, w.len) != 0) {
+        printf("merge patch gave %.*s, not %s\n", (int)w.len, buf, expected);
+        return 0;
+    }
+    return 1;
+}
+
+int test_merge_patch(void) {
+    // untouched members are copied verbatim, whitespace and all
+    check(merge_patch_eq("{\"a\": 1, \"b\" : [1, 2], \"c\": 3}", "{\"c\":4}",
+                         "{\"a\": 1, \"b\" : [1, 2],\"c\":4}"));
+    check(merge_patch_eq("{\"a\":\"b\"}", "{\"a\":\"c\"}", "{\"a\":\"c\"}"));
+    check(merge_patch_eq("{\"a\":\"b\"}", "{\"b\":\"c\"}",
+                         "{\"a\":\"b\",\"b\":\"c\"}"));
+    check(merge_patch_eq("{\"a\":\"b\"}", "{\"a\":null}", "{}"));
+    check(merge_patch_eq("{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}",
+                         "{\"b\":\"c\"}"));
+    check(merge_patch_eq("{\"a\":[\"b\"]}", "{\"a\":\"c\"}", "{\"a\":\"c\"}"));
+    check(merge_patch_eq("{\"a\":\"c\"}", "{\"a\":[\"b\"]}", "{\"a\":[\"b\"]}"));
+    check(merge_patch_eq("{\"a\":{\"b\":\"c\"}}",
+                         "{\"a\":{\"b\":\"d\",\"c\":null}}",
+                         "{\"a\":{\"b\":\"d\"}}"));
+    check(merge_patch_eq("{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}",
+                         "{\"a\":[1]}"));
+    check(merge_patch_eq("[\"a\",\"b\"]", "[\"c\",\"d\"]", "[\"c\",\"d\"]"));
+    check(merge_patch_eq("{\"a\":\"b\"}", "[\"c\"]", "[\"c\"]"));
+#ifndef JSMN_STRICT
+    // strict mode won't parse a bare top-level primitive
+    check(merge_patch_eq("{\"a\":\"foo\"}", "null", "null"));
+#endif
+    check(merge_patch_eq("{\"e\":null}", "{\"a\":1}", "{\"e\":null,\"a\":1}"));
+    check(merge_patch_eq("[1,2]", "{\"a\":\"b\",\"c\":null}", "{\"a\":\"b\"}"));
+    check(merge_patch_eq("{}", "{\"a\":{\"bb\":{\"ccc\":null}}}",
+                         "{\"a\":{\"bb\":{}}}"));
+    return 0;
+}
+
+static int json_patch_eq(const char *doc, const char *patch, int status,
+                         const char *expected) {
+    jsmn_token_t doc_tokens[32];
+    jsmn_token_t patch_tokens[64];
+    jsmn_token_t scratch_tokens[32];
+    jsmn_parser_t doc_parser;
+    jsmn_parser_t patch_parser;
+    jsmn_writer_t w;
+    char scratch[512];
+    char buf[256];
+    int r;
+
+    jsmn_init(&doc_parser, doc_tokens, 32);
+    jsmn_init(&patch_parser, patch_tokens, 64);
+    if (jsmn_parse(&doc_parser, doc, strlen(doc)) < 0 ||
+        jsmn_parse(&patch_parser, patch, strlen(patch)) < 0) {
+        return 0;
+    }
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    r = jsmn_json_patch(&doc_parser, &patch_parser, scratch, sizeof(scratch),
+                        scratch_tokens, 32, &w);
+    if (r != status) {
+        printf("json patch status is %d, not %d\n", r, status);
+        return 0;
+    }
+    if (status == 0 &&
+        (w.len != strlen(expected) || strncmp(buf, expected, w.len) != 0)) {
+        printf("json patch gave %.*s, not %s\n", (int)w.len, buf, expected);
+        return 0;
+    }
+    return 1;
+}
+
+int test_json_patch(void) {
+    // RFC 6902, appendix A
+    check(json_patch_eq("{\"foo\": \"bar\"}",
+                        "[{\"op\": \"add\", \"path\": \"/baz\", "
+                        "\"value\": \"qux\"}]",
+                        0, "{\"foo\": \"bar\",\"baz\":\"qux\"}"));
+    check(json_patch_eq("{\"foo\": [\"bar\", \"baz\"]}",
+                        "[{\"op\": \"add\", \"path\": \"/foo/1\", "
+                        "\"value\": \"qux\"}]",
+                        0, "{\"foo\": [\"bar\", \"qux\",\"baz\"]}"));
+    check(json_patch_eq("{\"baz\": \"qux\", \"foo\": \"bar\"}",
+                        "[{\"op\": \"remove\", \"path\": \"/baz\"}]", 0,
+                        "{\"foo\": \"bar\"}"));
+    check(json_patch_eq("{\"foo\": [\"bar\", \"qux\", \"baz\"]}",
+                        "[{\"op\": \"remove\", \"path\": \"/foo/1\"}]", 0,
+                        "{\"foo\": [\"bar\", \"baz\"]}"));
+    check(json_patch_eq("{\"baz\": \"qux\", \"foo\": \"bar\"}",
+                        "[{\"op\": \"replace\", \"path\": \"/baz\", "
+                        "\"value\": \"boo\"}]",
+                        0, "{\"baz\": \"boo\", \"foo\": \"bar\"}"));
+    check(json_patch_eq("{\"foo\": {\"bar\": \"baz\", \"waldo\": \"fred\"}, "
+                        "\"qux\": {\"corge\": \"grault\"}}",
+                        "[{\"op\": \"move\", \"from\": \"/foo/waldo\", "
+                        "\"path\": \"/qux/thud\"}]",
+                        0,
+                        "{\"foo\": {\"bar\": \"baz\"}, \"qux\": {\"corge\": "
+                        "\"grault\",\"thud\":\"fred\"}}"));
+    check(json_patch_eq("{\"foo\": [\"all\", \"grass\", \"cows\", \"eat\"]}",
+                        "[{\"op\": \"move\", \"from\": \"/foo/1\", "
+                        "\"path\": \"/foo/3\"}]",
+                        0, "{\"foo\": [\"all\", \"cows\", \"eat\",\"grass\"]}"));
+    check(json_patch_eq("{\"baz\": \"qux\", \"foo\": [\"a\", 2, \"c\"]}",
+                        "[{\"op\": \"test\", \"path\": \"/baz\", \"value\": "
+                        "\"qux\"}, {\"op\": \"test\", \"path\": \"/foo/1\", "
+                        "\"value\": 2.0}]",
+                        0, "{\"baz\": \"qux\", \"foo\": [\"a\", 2, \"c\"]}"));
+    check(json_patch_eq("{\"baz\": \"qux\"}",
+                        "[{\"op\": \"test\", \"path\": \"/baz\", \"value\": "
+                        "\"bar\"}]",
+                        JSMN_PATCH_ERROR_TEST, NULL));
+    check(json_patch_eq("{\"foo\": \"bar\"}",
+                        "[{\"op\": \"add\", \"path\": \"/child\", \"value\": "
+                        "{\"grandchild\": {}}}]",
+                        0,
+                        "{\"foo\": \"bar\",\"child\":{\"grandchild\": {}}}"));
+    check(json_patch_eq("{\"foo\": \"bar\"}",
+                        "[{\"op\": \"remove\", \"path\": \"/baz\"}]",
+                        JSMN_PATCH_ERROR_PATH, NULL));
+    check(json_patch_eq("{\"/\": 9, \"~1\": 10}",
+                        "[{\"op\": \"test\", \"path\": \"/~01\", \"value\": "
+                        "10}, {\"op\": \"add\", \"path\": \"/a~1b\", "
+                        "\"value\": 1}]",
+                        0, "{\"/\": 9, \"~1\": 10,\"a/b\":1}"));
+    check(json_patch_eq("{\"foo\": [\"bar\"]}",
+                        "[{\"op\": \"add\", \"path\": \"/foo/-\", \"value\": "
+                        "[\"abc\", \"def\"]}]",
+                        0, "{\"foo\": [\"bar\",[\"abc\", \"def\"]]}"));
+    check(json_patch_eq("{\"foo\": [\"bar\"]}",
+                        "[{\"op\": \"add\", \"path\": \"/foo/2\", \"value\": "
+                        "1}]",
+                        JSMN_PATCH_ERROR_PATH, NULL));
+    check(json_patch_eq("{\"foo\": \"bar\"}",
+                        "[{\"op\": \"frob\", \"path\": \"\"}]",
+                        JSMN_PATCH_ERROR_INVAL, NULL));
+
+    // sequences, and the edge cases of removing and moving
+    check(json_patch_eq("{\"a\": [1], \"b\": {}}",
+                        "[{\"op\": \"copy\", \"from\": \"/a\", \"path\": "
+                        "\"/b/c\"}, {\"op\": \"remove\", \"path\": \"/a/0\"}, "
+                        "{\"op\": \"replace\", \"path\": \"/b/c/0\", "
+                        "\"value\": 2}]",
+                        0, "{\"a\": [], \"b\": {\"c\":[2]}}"));
+    check(json_patch_eq("[1, 2, 3]",
+                        "[{\"op\": \"remove\", \"path\": \"/2\"}, "
+                        "{\"op\": \"remove\", \"path\": \"/0\"}]",
+                        0, "[2]"));
+    check(json_patch_eq("[1]",
+                        "[{\"op\": \"move\", \"from\": \"/0\", \"path\": "
+                        "\"/-\"}]",
+                        0, "[1]"));
+    check(json_patch_eq("[1, 2, 3]",
+                        "[{\"op\": \"move\", \"from\": \"/2\", \"path\": "
+                        "\"/0\"}]",
+                        0, "[3,1, 2]"));
+    check(json_patch_eq("{\"a\": {\"b\": 1}}",
+                        "[{\"op\": \"move\", \"from\": \"/a/b\", \"path\": "
+                        "\"/a\"}]",
+                        0, "{\"a\": 1}"));
+    check(json_patch_eq("{\"a\": {\"b\": 1}}",
+                        "[{\"op\": \"move\", \"from\": \"/a\", \"path\": "
+                        "\"/a/b\"}]",
+                        JSMN_PATCH_ERROR_INVAL, NULL));
+    check(json_patch_eq("{\"a\": 1}",
+                        "[{\"op\": \"move\", \"from\": \"/a\", \"path\": "
+                        "\"/b\"}]",
+                        0, "{\"b\":1}"));
+    check(json_patch_eq("{\"a\": 1}", "[]", 0, "{\"a\": 1}"));
+
+    // "test" compares characters, not escapes (RFC 6902, 4.6)
+    check(json_patch_eq("{\"a\": \"A\\u00e9\\ud83d\\ude00\\n\"}",
+                        "[{\"op\": \"test\", \"path\": \"/a\", \"value\": "
+                        "\"\\u0041\xc3\xa9\xf0\x9f\x98\x80\\u000a\"}]",
+                        0, "{\"a\": \"A\\u00e9\\ud83d\\ude00\\n\"}"));
+    check(json_patch_eq("{\"a\": {\"\\u0062\": 1}}",
+                        "[{\"op\": \"test\", \"path\": \"/a\", \"value\": "
+                        "{\"b\": 1}}]",
+                        0, "{\"a\": {\"\\u0062\": 1}}"));
+    check(json_patch_eq("{\"a\": \"\\u0041\"}",
+                        "[{\"op\": \"test\", \"path\": \"/a\", \"value\": "
+                        "\"\\u0042\"}]",
+                        JSMN_PATCH_ERROR_TEST, NULL));
+
+    // a bare number with nothing after it is not read past its end
+    const char number[2] = {'4', '2'};
+    const char *op = "{\"op\": \"test\", \"path\": \"\", \"value\": 42.0}";
+    jsmn_token_t doc_tokens[4];
+    jsmn_token_t op_tokens[8];
+    jsmn_parser_t doc_parser;
+    jsmn_parser_t op_parser;
+    jsmn_writer_t w;
+    char buf[16];
+    jsmn_init(&doc_parser, doc_tokens, 4);
+    jsmn_init(&op_parser, op_tokens, 8);
+    check(jsmn_parse_lenient(&doc_parser, number, sizeof(number)) == 1);
+    check(jsmn_parse(&op_parser, op, strlen(op)) == 7);
+    jsmn_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_json_patch_op(&doc_parser, &op_parser, 0, &w) == 0);
+    check(w.len == 2 && memcmp(buf, "42", 2) == 0);
+    return 0;
+}
+
+typedef struct {
+    int w;
+    int h;
+} size2_t;
+
+typedef struct {
+    int id;
+    unsigned char flags;
+    long long big;
+    double ratio;
+    float scale;
+    bool on;
+    char name[8];
+    int extra;
+    size2_t size;
+} bound_t;
+
+static const jsmn_bind_field_t size2_fields[] = {
+    JSMN_BIND_FIELD(size2_t, w, JSMN_BIND_INT),
+    JSMN_BIND_FIELD(size2_t, h, JSMN_BIND_INT),
+};
+
+static jsmn_binding_t size2_binding;
+
+static const jsmn_bind_field_t bound_fields[] = {
+    JSMN_BIND_FIELD(bound_t, id, JSMN_BIND_INT),
+    JSMN_BIND_FIELD(bound_t, flags, JSMN_BIND_UINT),
+    JSMN_BIND_FIELD(bound_t, big, JSMN_BIND_INT),
+    JSMN_BIND_FIELD(bound_t, ratio, JSMN_BIND_DOUBLE),
+    JSMN_BIND_FIELD(bound_t, scale, JSMN_BIND_DOUBLE),
+    JSMN_BIND_NAMED("enabled", bound_t, on, JSMN_BIND_BOOL),
+    JSMN_BIND_FIELD(bound_t, name, JSMN_BIND_STRING),
+    JSMN_BIND_FIELD(bound_t, extra, JSMN_BIND_TOKEN),
+    JSMN_BIND_NESTED(bound_t, size, &size2_binding),
+};
+
+static int bind_decode(jsmn_binding_t *binding, const char *js, void *out) {
+    jsmn_token_t tokens[64];
+    jsmn_parser_t parser;
+    jsmn_init(&parser, tokens, 64);
+    if (jsmn_parse(&parser, js, strlen(js)) < 0) {
+        return -100;
+    }
+    return jsmn_bind_decode(binding, &parser, 0, out);
+}
+
+int test_bind(void) {
+    jsmn_binding_t binding;
+    bound_t b;
+
+    check(jsmn_bind_init(&size2_binding, size2_fields, 2) == 0);
+    check(jsmn_bind_init(&binding, bound_fields,
+                         sizeof(bound_fields) / sizeof(bound_fields[0])) == 0);
+
+    memset(&b, 0, sizeof(b));
+    const char *js = "{\"id\": -42, \"unknown\": {\"id\": 1}, \"flags\": 255, "
+                     "\"big\": 9007199254740993, \"ratio\": 2.5e-1, "
+                     "\"scale\": 3, \"enabled\": true, \"name\": \"jsmn\", "
+                     "\"extra\": [1, 2], \"size\": {\"h\": 480, \"w\": 640}, "
+                     "\"i\": 7, \"idd\": 8}";
+    check(bind_decode(&binding, js, &b) == 10);
+    check(b.id == -42);
+    check(b.flags == 255);
+    check(b.big == 9007199254740993LL);
+    check(b.ratio == 0.25);
+    check(b.scale == 3.0f);
+    check(b.on == true);
+    check(strcmp(b.name, "jsmn") == 0);
+    check(b.extra == 20);
+    check(b.size.w == 640 && b.size.h == 480);
+
+    // null and missing members leave fields untouched
+    check(bind_decode(&binding, "{\"id\": null, \"name\": null}", &b) == 0);
+    check(b.id == -42);
+
+    // values that don't fit their fields
+    check(bind_decode(&binding, "{\"flags\": 256}", &b) == JSMN_BIND_ERROR_TYPE);
+    check(bind_decode(&binding, "{\"flags\": -1}", &b) == JSMN_BIND_ERROR_TYPE);
+    check(bind_decode(&binding, "{\"id\": 2147483648}", &b) ==
+          JSMN_BIND_ERROR_TYPE);
+    check(bind_decode(&binding, "{\"id\": -2147483648}", &b) == 1);
+    check(b.id == INT32_MIN);
+    check(bind_decode(&binding, "{\"id\": 1.5}", &b) == JSMN_BIND_ERROR_TYPE);
+    check(bind_decode(&binding, "{\"id\": \"1\"}", &b) == JSMN_BIND_ERROR_TYPE);
+    check(bind_decode(&binding, "{\"enabled\": 1}", &b) == JSMN_BIND_ERROR_TYPE);
+    check(bind_decode(&binding, "{\"size\": [1]}", &b) == JSMN_BIND_ERROR_TYPE);
+    check(bind_decode(&binding, "{\"name\": \"12345678\"}", &b) ==
+          JSMN_BIND_ERROR_NOMEM);
+    check(bind_decode(&binding, "[1]", &b) == JSMN_BIND_ERROR_INVAL);
+
+    // duplicate names are rejected
+    const jsmn_bind_field_t dup[] = {
+        JSMN_BIND_FIELD(size2_t, w, JSMN_BIND_INT),
+        JSMN_BIND_NAMED("w", size2_t, h, JSMN_BIND_INT),
+    };
+    check(jsmn_bind_init(&binding, dup, 2) == JSMN_BIND_ERROR_INVAL);
+    return 0;
+}
+
+int test_parse_variants(void) {
+    jsmn_token_t tokens[16];
+    jsmn_parser_t parser;
+    const char *lenient = "{a: 1, b: [true, x]}";
+    const char *js = "{\"a\": [1, {\"b\": 2}], \"c\": 3}";
+
+    jsmn_init(&parser, tokens, 16);
+
+    // each variant keeps its own policy, whatever the build flags
+    check(jsmn_parse_strict(&parser, lenient, strlen(lenient)) ==
+          JSMN_ERROR_INVAL);
+    check(jsmn_parse_lenient(&parser, lenient, strlen(lenient)) == 7);
+    check(test_parse_counted(&parser, lenient, strlen(lenient)) ==
+          JSMN_ERROR_INVAL);
+
+    // parent links are filled in by the strict and lenient variants
+    check(jsmn_parse_strict(&parser, js, strlen(js)) == 9);
+    check(tokens[0].parent_index == -1);
+    check(tokens[2].parent_index == 1);
+    check(tokens[4].parent_index == 2);
+    check(tokens[6].parent_index == 5);
+    check(tokens[7].parent_index == 0);
+    check(tokens[2].end_index == 7);
+    check(jsmn_sibling_of(&parser, 2) == 7);
+
+    // only the counting variant touches the statistics
+    jsmn_stats_t stats;
+    jsmn_stats_reset(&parser);
+    check(jsmn_parse_lenient(&parser, js, strlen(js)) == 9);
+    jsmn_stats_get(&parser, &stats);
+    check(stats.tokens_allocated == 0);
+    check(test_parse_counted(&parser, js, strlen(js)) == 9);
+    jsmn_stats_get(&parser, &stats);
+    check(stats.tokens_allocated == 9);
+    check(stats.max_depth == 3);
+    check(tokens[2].parent_index == -1);
+    return 0;
+}
+
+static bool same_tokens(const jsmn_token_t *a, const jsmn_token_t *b, int n) {
+    for (int i = 0; i < n; i++) {
+        if (a[i].start != b[i].start || a[i].type != b[i].type ||
+            a[i].strlen != b[i].strlen ||
+            a[i].child_count != b[i].child_count ||
+            a[i].parent_index != b[i].parent_index ||
+            a[i].level != b[i].level || a[i].end_index != b[i].end_index) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int test_parse_trusted(void) {
+    static const char *docs[] = {
+        "{\"a\": [1, -2.5e+3, true, false, null], \"b\": {\"c\": \"d\"}}",
+        "[\"esc \\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u00e9 \\uD83D\\uDE00\"]",
+        "{\"k\": {\"k\": {\"k\": [[], {}, [{}]]}}, \"\": \"\"}",
+        "42",
+        "\"top\"",
+        "1",
+        "true",
+        "[1, 2] {\"x\": 3}",
+    };
+    jsmn_token_t expected[32];
+    jsmn_token_t actual[32];
+    jsmn_parser_t p1, p2;
+
+    for (size_t d = 0; d < sizeof(docs) / sizeof(docs[0]); d++) {
+        const char *js = docs[d];
+        jsmn_init(&p1, expected, 32);
+        jsmn_init(&p2, actual, 32);
+        int n = jsmn_parse_lenient(&p1, js, strlen(js));
+        check(n > 0);
+        check(jsmn_parse_trusted(&p2, js, strlen(js)) == n);
+        check(same_tokens(expected, actual, n));
+        if (d < 3) {
+            check(jsmn_parse_strict(&p1, js, strlen(js)) == n);
+            check(same_tokens(expected, actual, n));
+        }
+    }
+    // bare top-level primitives: one token, like the lenient parser, where
+    // the strict one wants more input
+    jsmn_init(&p1, expected, 32);
+    check(jsmn_parse_strict(&p1, "1", 1) == JSMN_ERROR_PART);
+    check(jsmn_parse_strict(&p1, "true", 4) == JSMN_ERROR_PART);
+    jsmn_init(&p2, actual, 32);
+    check(jsmn_parse_trusted(&p2, "true", 4) == 1);
+    check(actual[0].type == JSMN_PRIMITIVE && actual[0].strlen == 4);
+
+    // the trusted parser still stops at the end of its input and at limits
+    const char *part = "{\"a\": \"unterminated";
+    jsmn_init(&p2, actual, 32);
+    check(jsmn_parse_trusted(&p2, part, strlen(part)) == JSMN_ERROR_PART);
+    check(jsmn_parse_trusted(&p2, docs[0], strlen(docs[0]) - 1) ==
+          JSMN_ERROR_PART);
+    jsmn_init(&p2, actual, 4);
+    check(jsmn_parse_trusted(&p2, docs[0], strlen(docs[0])) ==
+          JSMN_ERROR_NOMEM);
+    return 0;
+}
+
+int test_parse_padded(void) {
+    static const char *docs[] = {
+        "{\"a\": [1, -2.5e+3, true, false, null], \"b\": {\"c\": \"d\"}}",
+        "[\"a string well over sixteen bytes long, with \\\"escapes\\\" "
+        "\\u00e9 and a tail\", \"\", \"0123456789abcdef\"]",
+        "{\"k\": {\"k\": {\"k\": [[], {}, [{}]]}}}",
+        "42",
+        "{\"a\": \"unterminated string running into the padding",
+        "[\"bad escape \\x in a long string\"]",
+        "[1, 2",
+        "\"ends in a backslash\\",
+    };
+    jsmn_token_t expected[32];
+    jsmn_token_t actual[32];
+    jsmn_parser_t p1, p2;
+
+    for (size_t d = 0; d < sizeof(docs) / sizeof(docs[0]); d++) {
+        size_t len = strlen(docs[d]);
+        char *js = jsmn_alloc_padded(len);
+        check(js != NULL);
+        memcpy(js, docs[d], len);
+        jsmn_init(&p1, expected, 32);
+        jsmn_init(&p2, actual, 32);
+        int n = jsmn_parse_lenient(&p1, js, len);
+        check(jsmn_parse_padded(&p2, js, len) == n);
+        check(n < 0 || same_tokens(expected, actual, n));
+
+        // limits give the same answers as the bounded scanners
+        jsmn_limits_t limits = {0};
+        limits.max_strlen = 10;
+        jsmn_set_limits(&p1, &limits);
+        jsmn_set_limits(&p2, &limits);
+        check(jsmn_parse_padded(&p2, js, len) ==
+              jsmn_parse_lenient(&p1, js, len));
+        jsmn_free_padded(js);
+    }
+
+    // a byte budget must cover the whole padded document
+    char *js = jsmn_alloc_padded(6);
+    memcpy(js, "[1, 2]", 6);
+    jsmn_init(&p2, actual, 32);
+    check(jsmn_parse_padded(&p2, js, 6) == 3);
+    jsmn_limits_t limits = {0};
+    limits.max_bytes = 5;
+    jsmn_set_limits(&p2, &limits);
+    check(jsmn_parse_padded(&p2, js, 6) == JSMN_ERROR_LIMIT);
+    jsmn_free_padded(js);
+
+    // string text runs to the NUL at len, the kernels' blocks on into the
+    // padding, at every length and with every instruction set
+    jsmn_isa_t best = jsmn_simd_isa();
+    for (int isa = JSMN_ISA_SCALAR; isa <= (int)best; isa++) {
+        check(jsmn_simd_select((jsmn_isa_t)isa) == 0);
+        for (size_t len = 1; len < 150; len++) {
+            js = jsmn_alloc_padded(len);
+            check(js != NULL);
+            js[0] = '\"';
+            memset(&js[1], 'x', len - 1);
+            check(jsmn_scan_string_padded(&js[1]) == len - 1);
+            jsmn_init(&p2, actual, 32);
+            check(jsmn_parse_padded(&p2, js, len) == JSMN_ERROR_PART);
+            js[len - 1] = '\"';
+            jsmn_init(&p2, actual, 32);
+            check(jsmn_parse_padded(&p2, js, len) == (len > 1 ? 1 : JSMN_ERROR_PART));
+            jsmn_free_padded(js);
+        }
+    }
+    check(jsmn_simd_select(best) == 0);
+    return 0;
+}
+
+int test_parse_table(void) {
+    static const char *docs[] = {
+        "{\"a\": [1, -2.5e+3, true, false, null], \"b\": {\"c\": \"d\"}}",
+        "[\"esc \\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u00e9 \\uD83D\\uDE00\"]",
+        "{\"k\": {\"k\": {\"k\": [[], {}, [{}]]}}, \"\": \"\"}",
+        "[1, 2] {\"x\": 3}",
+        "42 ",
+        "[42",
+        "[\"bad escape \\x\"]",
+        "[\"bad hex \\u12g4\"]",
+        "[\"unterminated \\u12",
+        "[1, \x01]",
+        "{\"a\" 1, true: 2}",
+        "[tru\xc3\xa9]",
+        "{\"a\": [1}",
+    };
+    jsmn_token_t expected[32];
+    jsmn_token_t actual[32];
+    jsmn_parser_t p1, p2;
+
+    for (size_t d = 0; d < sizeof(docs) / sizeof(docs[0]); d++) {
+        const char *js = docs[d];
+        jsmn_init(&p1, expected, 32);
+        jsmn_init(&p2, actual, 32);
+        int n = jsmn_parse_strict(&p1, js, strlen(js));
+        check(jsmn_parse_table(&p2, js, strlen(js)) == n);
+        check(p1.pos == p2.pos);
+        check(n < 0 || same_tokens(expected, actual, n));
+
+        // and the same answers when limits cut tokens short
+        jsmn_limits_t limits = {0};
+        limits.max_strlen = 3;
+        jsmn_set_limits(&p1, &limits);
+        jsmn_set_limits(&p2, &limits);
+        check(jsmn_parse_table(&p2, js, strlen(js)) ==
+              jsmn_parse_strict(&p1, js, strlen(js)));
+    }
+    return 0;
+}
+
+int test_primitive_class(void) {
+    jsmn_token_t tokens[16];
+    jsmn_parser_t parser;
+    const char *js = "[1e5, -0, 2E-3, -7, 12.5, true, false, null, 0]";
+
+    jsmn_init(&parser, tokens, 16);
+    check(jsmn_parse(&parser, js, strlen(js)) == 10);
+    check(jsmn_token_class(&tokens[0]) == JSMN_CLASS_NONE);
+    check(jsmn_token_is_float(&tokens[1]));
+    check(!jsmn_token_is_integer(&tokens[1]));
+    check(jsmn_token_is_integer(&tokens[2]));
+    check(jsmn_token_is_negative(&tokens[2]));
+    check(jsmn_token_is_float(&tokens[3]));
+    check(!jsmn_token_is_negative(&tokens[3]));
+    check(jsmn_token_class(&tokens[4]) == JSMN_CLASS_INTEGER);
+    check(tokens[4].subtype == (JSMN_CLASS_INTEGER | JSMN_CLASS_NEGATIVE));
+    check(jsmn_token_is_float(&tokens[5]));
+    check(jsmn_token_is_true(&tokens[6]) && jsmn_token_is_boolean(&tokens[6]));
+    check(jsmn_token_is_false(&tokens[7]) && !jsmn_token_is_true(&tokens[7]));
+    check(jsmn_token_is_null(&tokens[8]) && !jsmn_token_is_number(&tokens[8]));
+    check(jsmn_token_is_integer(&tokens[9]));
+
+    // lenient parsers accept other bare words; they are neither of these
+    const char *words = "[trueish, nul, -, -x, f]";
+    check(jsmn_parse_lenient(&parser, words, strlen(words)) == 6);
+    for (int i = 1; i < 6; i++) {
+        check(jsmn_token_class(&tokens[i]) == JSMN_CLASS_OTHER);
+        check(!jsmn_token_is_boolean(&tokens[i]));
+        check(!jsmn_token_is_null(&tokens[i]));
+        check(!jsmn_token_is_number(&tokens[i]));
+        check(!jsmn_token_is_negative(&tokens[i]));
+    }
+
+    // strings and keys are never classified
+    const char *obj = "{\"true\": \"1\"}";
+    check(jsmn_parse(&parser, obj, strlen(obj)) == 3);
+    check(!jsmn_token_is_true(&tokens[1]));
+    check(!jsmn_token_is_integer(&tokens[2]));
+    return 0;
+}
+
+int test_symtab(void) {
+    jsmn_token_t tokens[16];
+    jsmn_parser_t parser;
+    jsmn_symbol_slot_t slots[8];
+    jsmn_symtab_t symtab;
+    const char *js = "{\"id\": \"name\", \"name\": {\"id\": 1, \"x\": 2}}";
+
+    jsmn_symtab_init(&symtab, slots, 8);
+    check(jsmn_symtab_add(&symtab, "id") == 1);
+    check(jsmn_symtab_add(&symtab, "name") == 2);
+    check(jsmn_symtab_add(&symtab, "id") == 1);
+
+    jsmn_init(&parser, tokens, 16);
+    jsmn_set_symtab(&parser, &symtab);
+    check(jsmn_parse(&parser, js, strlen(js)) == 9);
+    check(jsmn_token_symbol(&tokens[0]) == 0);
+    check(jsmn_token_symbol(&tokens[1]) == 1);
+    check(jsmn_token_symbol(&tokens[2]) == 0); // a value, not a key
+    check(jsmn_token_symbol(&tokens[3]) == 2);
+    check(jsmn_token_symbol(&tokens[5]) == 1);
+    check(jsmn_token_symbol(&tokens[7]) == 3);
+    check(jsmn_symtab_find(&symtab, "x", 1) == 3);
+
+    // per-parse symbols are dropped by the next parse; seeded ones stay put
+    const char *other = "{\"y\": 0, \"x\": 0, \"name\": 0}";
+    check(jsmn_parse_trusted(&parser, other, strlen(other)) == 7);
+    check(jsmn_token_symbol(&tokens[1]) == 3);
+    check(jsmn_token_symbol(&tokens[3]) == 4);
+    check(jsmn_token_symbol(&tokens[5]) == 2);
+    check(jsmn_symtab_find(&symtab, "x", 1) == 4);
+
+    // a full table leaves the overflow keys without a symbol
+    const char *many = "{\"a\":0,\"b\":0,\"c\":0,\"d\":0,\"e\":0,\"id\":0}";
+    check(jsmn_parse(&parser, many, strlen(many)) == 13);
+    check(jsmn_token_symbol(&tokens[1]) == 3);
+    check(jsmn_token_symbol(&tokens[7]) == 6);
+    check(jsmn_token_symbol(&tokens[9]) == 0);
+    check(jsmn_token_symbol(&tokens[11]) == 1);
+    check(jsmn_symtab_find(&symtab, "e", 1) == 0);
+
+    // detached, keys get no symbols
+    jsmn_set_symtab(&parser, NULL);
+    check(jsmn_parse(&parser, js, strlen(js)) == 9);
+    check(jsmn_token_symbol(&tokens[1]) == 0);
+    return 0;
+}
+
+int test_keyset(void) {
+    jsmn_token_t tokens[4100];
+    jsmn_parser_t parser;
+    jsmn_keyset_slot_t slots[8192];
+    jsmn_keyset_t keyset;
+    const char *js = "{\"a\": {\"a\": 1, \"b\": 2}, \"b\": [{\"a\": 3}]}";
+
+    jsmn_keyset_init(&keyset, slots, 8);
+    jsmn_init(&parser, tokens, 4100);
+    jsmn_set_keyset(&parser, &keyset);
+    // the same key in different objects is fine
+    check(jsmn_parse(&parser, js, strlen(js)) == 12);
+
+    const char *dup = "{\"a\": 1, \"b\": {\"c\": 2}, \"a\": 3}";
+    check(jsmn_parse(&parser, dup, strlen(dup)) == JSMN_ERROR_DUPKEY);
+    check(parser.pos == 24);
+    const char *nested = "[{\"x\": {\"y\": 1, \"y\": 2}}]";
+    check(jsmn_parse_strict(&parser, nested, strlen(nested)) ==
+          JSMN_ERROR_DUPKEY);
+    // keys are compared as written
+    const char *escaped = "{\"a\": 1, \"\\u0061\": 2}";
+    check(jsmn_parse(&parser, escaped, strlen(escaped)) == 5);
+    // counting parses do not check
+    jsmn_init(&parser, NULL, 0);
+    jsmn_set_keyset(&parser, &keyset);
+    check(jsmn_parse(&parser, dup, strlen(dup)) == 9);
+
+    // more keys than the set holds
+    jsmn_init(&parser, tokens, 4100);
+    jsmn_set_keyset(&parser, &keyset);
+    const char *many = "{\"a\":0,\"b\":0,\"c\":0,\"d\":0,\"e\":0,\"f\":0,"
+                       "\"g\":0}";
+    check(jsmn_parse(&parser, many, strlen(many)) == JSMN_ERROR_KEYSET);
+    // keys of closed objects still count
+    const char *spread = "[{\"a\":0,\"b\":0},{\"a\":0,\"b\":0},"
+                         "{\"a\":0,\"b\":0},{\"a\":0}]";
+    check(jsmn_parse(&parser, spread, strlen(spread)) == JSMN_ERROR_KEYSET);
+
+    // a big object, one duplicate at the very end
+    static char big[2048 * 16];
+    int n = 0;
+    big[n++] = '{';
+    for (int i = 0; i < 2048; i++) {
+        n += sprintf(&big[n], "%s\"k%d\":%d", i ? "," : "", i, i);
+    }
+    big[n++] = '}';
+    jsmn_keyset_init(&keyset, slots, 8192);
+    check(jsmn_parse(&parser, big, (size_t)n) == 4097);
+    sprintf(&big[n - 1], ",\"k1234\":0}");
+    check(jsmn_parse(&parser, big, strlen(big)) == JSMN_ERROR_DUPKEY);
+
+    // an incremental reparse checks the new subtree
+    char doc[64] = "{\"a\": {\"x\": 1, \"y\": 2}, \"b\": 3}";
+    char old_js[64];
+    check(jsmn_parse(&parser, doc, strlen(doc)) == 9);
+    strcpy(old_js, doc);
+    doc[16] = 'x';
+    jsmn_edit_t edit = {16, 1, 1};
+    check(jsmn_reparse(&parser, jsmn_parse, old_js, doc, strlen(doc),
+                       &edit) == JSMN_ERROR_DUPKEY);
+
+    // detached, duplicates pass
+    jsmn_set_keyset(&parser, NULL);
+    check(jsmn_parse(&parser, dup, strlen(dup)) == 9);
+    return 0;
+}
+
+static uint64_t root_hash(const char *js, unsigned int flags) {
+    jsmn_token_t tokens[32];
+    uint64_t hashes[32];
+    jsmn_parser_t parser;
+    jsmn_init(&parser, tokens, 32);
+    if (jsmn_parse(&parser, js, strlen(js)) < 0 ||
+        jsmn_hash_tokens(&parser, hashes, 32, flags) < 0) {
+        return 0;
+    }
+    return hashes[0];
+}
+
+int test_hash(void) {
+    jsmn_token_t tokens[16];
+    uint64_t hashes[16];
+    jsmn_parser_t parser;
+
+    // spelling does not matter
+    check(root_hash("{\"a\": [1, \"x\", true]}", 0) ==
+          root_hash(" {\"a\":[ 1.0 , \"\\u0078\" ,true ] } ", 0));
+    check(root_hash("[\"\\u00e9\\n\", \"\\ud83d\\ude00\"]", 0) ==
+          root_hash("[\"\xc3\xa9\\u000a\", \"\xf0\x9f\x98\x80\"]", 0));
+    check(root_hash("[0, 100]", 0) == root_hash("[-0.0, 1e2]", 0));
+    check(root_hash("[1e20, 1e16]", 0) ==
+          root_hash("[100000000000000000000, 10000000000000000]", 0));
+    check(root_hash("[12345678901234567e3, -0.5e-400]", 0) ==
+          root_hash("[1.2345678901234567E19, -50000e-405]", 0));
+
+    // values do
+    check(root_hash("{\"a\": 1}", 0) != root_hash("{\"a\": 2}", 0));
+    check(root_hash("{\"a\": 1}", 0) != root_hash("{\"b\": 1}", 0));
+    check(root_hash("[1]", 0) != root_hash("[\"1\"]", 0));
+    check(root_hash("[]", 0) != root_hash("{}", 0));
+    check(root_hash("[1, [2]]", 0) != root_hash("[[1], 2]", 0));
+    check(root_hash("[\"ab\", \"\"]", 0) != root_hash("[\"a\", \"b\"]", 0));
+    check(root_hash("[12345678901234567]", 0) !=
+          root_hash("[12345678901234568]", 0));
+    check(root_hash("[1e400]", 0) != root_hash("[2e400]", 0));
+    check(root_hash("[1e-400]", 0) != root_hash("[0]", 0));
+
+    // member order, unless told to ignore it
+    const char *ab = "{\"a\": 1, \"b\": {\"c\": [true, null]}}";
+    const char *ba = "{\"b\": {\"c\": [true, null]}, \"a\": 1}";
+    check(root_hash(ab, 0) != root_hash(ba, 0));
+    check(root_hash(ab, JSMN_HASH_UNORDERED) ==
+          root_hash(ba, JSMN_HASH_UNORDERED));
+    check(root_hash("[1, 2]", JSMN_HASH_UNORDERED) !=
+          root_hash("[2, 1]", JSMN_HASH_UNORDERED));
+
+    // equal subtrees of one document
+    const char *js = "[{\"x\": 1}, {\"x\": 1.0}, {\"x\": 2}]";
+    jsmn_init(&parser, tokens, 16);
+    check(jsmn_parse(&parser, js, strlen(js)) == 10);
+    check(jsmn_hash_tokens(&parser, hashes, 16, 0) == 10);
+    check(hashes[1] == hashes[4]);
+    check(hashes[1] != hashes[7]);
+    check(hashes[2] == hashes[5]); // a key hashes its whole member
+    check(hashes[2] != hashes[8]);
+
+    check(jsmn_hash_tokens(&parser, hashes, 9, 0) == JSMN_HASH_ERROR_NOMEM);
+    jsmn_init(&parser, NULL, 0);
+    check(jsmn_parse(&parser, js, strlen(js)) == 10);
+    check(jsmn_hash_tokens(&parser, hashes, 16, 0) == JSMN_HASH_ERROR_INVAL);
+    return 0;
+}
+
+static int canonicalize(const char *js, char *buf, size_t size) {
+    jsmn_token_t tokens[64];
+    int order[64];
+    jsmn_parser_t parser;
+    jsmn_writer_t writer;
+    int r;
+    jsmn_init(&parser, tokens, 64);
+    if (jsmn_parse(&parser, js, strlen(js)) < 0) {
+        return JSMN_WRITER_ERROR_INVAL;
+    }
+    jsmn_writer_init(&writer, buf, size - 1, NULL, NULL);
+    r = jsmn_canonicalize(&parser, 0, order, 64, &writer);
+    buf[writer.len] = '\0';
+    return r;
+}
+
+int test_canonicalize(void) {
+    char buf[256];
+    char again[256];
+
+    // the example of RFC 8785, section 3.2.2
+    const char *js =
+        "{\n  \"numbers\": [333333333.33333329, 1E30, 4.50, 2e-3, "
+        "0.000000000000000000000000001],\n  \"string\": "
+        "\"\\u20ac$\\u000F\\u000aA'\\u0042\\u0022\\u005c\\\\\\\"\\/\",\n"
+        "  \"literals\": [null, true, false]\n}";
+    check(canonicalize(js, buf, sizeof(buf)) == 0);
+    check(strcmp(buf, "{\"literals\":[null,true,false],\"numbers\":"
+                      "[333333333.3333333,1e+30,4.5,0.002,1e-27],\"string\":"
+                      "\"\xe2\x82\xac$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\"}") == 0);
+    check(canonicalize(buf, again, sizeof(again)) == 0);
+    check(strcmp(buf, again) == 0);
+
+    // keys sort by UTF-16 code units (section 3.2.3), nested objects too
+    js = "{\"\\u20ac\": 1, \"\\r\": 2, \"\\ufb33\": 3, \"1\": 4, "
+         "\"\\ud83d\\ude00\": 5, \"\\u0080\": 6, \"\\u00f6\": {\"b\": 7, "
+         "\"a\": [8, {}]}}";
+    check(canonicalize(js, buf, sizeof(buf)) == 0);
+    check(strcmp(buf, "{\"\\r\":2,\"1\":4,\"\xc2\x80\":6,\"\xc3\xb6\":"
+                      "{\"a\":[8,{}],\"b\":7},\"\xe2\x82\xac\":1,"
+                      "\"\xf0\x9f\x98\x80\":5,\"\xef\xac\xb3\":3}") == 0);
+
+    // more members than an insertion sort is used for
+    js = "{\"t\":0,\"s\":0,\"r\":0,\"q\":0,\"p\":0,\"o\":0,\"n\":0,\"m\":0,"
+         "\"l\":0,\"k\":0,\"j\":0,\"i\":0,\"h\":0,\"g\":0,\"f\":0,\"e\":0,"
+         "\"d\":0,\"c\":0,\"b\":0,\"a\":0}";
+    check(canonicalize(js, buf, sizeof(buf)) == 0);
+    check(strcmp(buf, "{\"a\":0,\"b\":0,\"c\":0,\"d\":0,\"e\":0,\"f\":0,"
+                      "\"g\":0,\"h\":0,\"i\":0,\"j\":0,\"k\":0,\"l\":0,"
+                      "\"m\":0,\"n\":0,\"o\":0,\"p\":0,\"q\":0,\"r\":0,"
+                      "\"s\":0,\"t\":0}") == 0);
+
+    // numbers as ECMAScript writes them
+    check(canonicalize("[-0, 10, -0.0, 1e2, 12345678901234567890, "
+                       "5e-324, 0.1, 1e21, 1e-7]",
+                       buf, sizeof(buf)) == 0);
+    check(strcmp(buf, "[0,10,0,100,12345678901234567000,5e-324,0.1,1e+21,"
+                      "1e-7]") == 0);
+    // digits Grisu2 alone gets one too long, or not the closest
+    check(canonicalize("[6570.3726279916355, 2.1201840400810929e-105]", buf,
+                       sizeof(buf)) == 0);
+    check(strcmp(buf, "[6570.372627991635,2.1201840400810927e-105]") == 0);
+
+    // no canonical form
+    check(canonicalize("{\"a\": 1, \"\\u0061\": 2}", buf, sizeof(buf)) ==
+          JSMN_WRITER_ERROR_INVAL);
+    check(canonicalize("[\"\\ud800\"]", buf, sizeof(buf)) ==
+          JSMN_WRITER_ERROR_INVAL);
+    check(canonicalize("[\"\xff\"]", buf, sizeof(buf)) ==
+          JSMN_WRITER_ERROR_INVAL);
+    check(canonicalize("[1e400]", buf, sizeof(buf)) ==
+          JSMN_WRITER_ERROR_INVAL);
+    check(canonicalize("[\"abcdef\"]", buf, 8) == JSMN_WRITER_ERROR_NOMEM);
+
+    // order must hold the keys of every open object
+    jsmn_token_t tokens[16];
+    int order[2];
+    jsmn_parser_t parser;
+    jsmn_writer_t writer;
+    js = "{\"a\": {\"c\": 1}, \"b\": 2}";
+    jsmn_init(&parser, tokens, 16);
+    check(jsmn_parse(&parser, js, strlen(js)) == 7);
+    jsmn_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_canonicalize(&parser, 0, order, 2, &writer) ==
+          JSMN_WRITER_ERROR_NOMEM);
+    jsmn_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+    check(jsmn_canonicalize(&parser, 2, order, 1, &writer) == 0);
+    check(writer.len == 7 && strncmp(buf, "{\"c\":1}", 7) == 0);
+    return 0;
+}
+
+int test_tape(void) {
+    jsmn_token_t tokens[16];
+    jsmn_token_t loaded[16];
+    jsmn_parser_t parser;
+    jsmn_parser_t reload;
+    jsmn_tape_t tape;
+    jsmn_token_t tok;
+    uint64_t buf[64]; // a mapping would be page aligned
+    char js[] = "{\"a\": [1, -2.5, true, null], \"b\": {\"c\": \"d\"}}";
+    size_t len = strlen(js);
+
+    jsmn_init(&parser, tokens, 16);
+    int n = jsmn_parse(&parser, js, len);
+    check(n == 11);
+    check(jsmn_tape_size(n) <= sizeof(buf));
+    check(jsmn_tape_write(&parser, js, len, buf, jsmn_tape_size(n) - 1) ==
+          JSMN_TAPE_ERROR_NOMEM);
+    check(jsmn_tape_write(&parser, js, len, buf, sizeof(buf)) == 0);
+
+    check(jsmn_tape_open(&tape, buf, sizeof(buf), js, len, true) == 0);
+    check(tape.token_count == n);
+    jsmn_init(&reload, loaded, 16);
+    check(jsmn_tape_load(&tape, &reload) == n);
+    check(reload.token_count == parser.token_count);
+    check(same_tokens(tokens, loaded, n));
+    check(jsmn_token_is_negative(&loaded[4]));
+    check(jsmn_tape_token(&tape, 10, &tok) == 0);
+    check(tok.start == tokens[10].start && tok.strlen == 1);
+    check(jsmn_tape_token(&tape, 11, &tok) == JSMN_TAPE_ERROR_INVAL);
+    jsmn_init(&reload, loaded, 4);
+    check(jsmn_tape_load(&tape, &reload) == JSMN_TAPE_ERROR_NOMEM);
+
+    // stale JSON: a different length is always caught, different bytes
+    // only when verifying
+    check(jsmn_tape_open(&tape, buf, sizeof(buf), js, len - 1, false) ==
+          JSMN_TAPE_ERROR_STALE);
+    js[len - 4] = 'e';
+    check(jsmn_tape_open(&tape, buf, sizeof(buf), js, len, false) == 0);
+    check(jsmn_tape_open(&tape, buf, sizeof(buf), js, len, true) ==
+          JSMN_TAPE_ERROR_STALE);
+
+    // damaged or truncated tapes
+    check(jsmn_tape_open(&tape, buf, jsmn_tape_size(n) - 1, js, len, false) ==
+          JSMN_TAPE_ERROR_NOMEM);
+    ((unsigned char *)buf)[sizeof(jsmn_tape_header_t) + 1] ^= 1;
+    js[len - 4] = 'd';
+    check(jsmn_tape_open(&tape, buf, sizeof(buf), js, len, true) ==
+          JSMN_TAPE_ERROR_STALE);
+    buf[0] ^= 1;
+    check(jsmn_tape_open(&tape, buf, sizeof(buf), js, len, false) ==
+          JSMN_TAPE_ERROR_FORMAT);
+    buf[0] ^= 1;
+    ((unsigned char *)buf)[sizeof(jsmn_tape_header_t) + 1] ^= 1;
+
+    // entries pointing outside the JSON or the tape, unverified: token 3
+    // is the 1 at offset 7, ending at 4
+    jsmn_tape_entry_t *entries =
+        (jsmn_tape_entry_t *)((char *)buf + sizeof(jsmn_tape_header_t));
+    jsmn_tape_entry_t saved = entries[3];
+    check(saved.offset == 7 && saved.end_index == 4);
+    int32_t bad[][3] = {
+        {(int32_t)len, 4, -1}, // string past the JSON
+        {7, 12, -1},           // subtree past the last token
+        {7, 3, -1},            // subtree ending before it starts
+        {7, 4, 3},             // parent not before the token
+        {7, 4, -2},
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        entries[3] = saved;
+        entries[3].offset = (uint32_t)bad[i][0];
+        entries[3].end_index = bad[i][1];
+        entries[3].parent_index = bad[i][2];
+        check(jsmn_tape_open(&tape, buf, sizeof(buf), js, len, false) == 0);
+        check(jsmn_tape_token(&tape, 3, &tok) == JSMN_TAPE_ERROR_FORMAT);
+        jsmn_init(&reload, loaded, 16);
+        check(jsmn_tape_load(&tape, &reload) == JSMN_TAPE_ERROR_FORMAT);
+    }
+    entries[3] = saved;
+    check(jsmn_tape_open(&tape, buf, sizeof(buf), js, len, false) == 0);
+    check(jsmn_tape_token(&tape, 3, &tok) == 0);
+
+    // a count-only parse has nothing to save
+    jsmn_init(&parser, NULL, 0);
+    check(jsmn_parse(&parser, js, len) == n);
+    check(jsmn_tape_write(&parser, js, len, buf, sizeof(buf)) ==
+          JSMN_TAPE_ERROR_INVAL);
+    return 0;
+}
+
+int test_cache(void) {
+    jsmn_token_t expected[16];
+    jsmn_token_t tokens[16];
+    jsmn_parser_t p1;
+    jsmn_parser_t p2;
+    jsmn_cache_t cache;
+    jsmn_symbol_slot_t slots[16];
+    jsmn_symtab_t symtab;
+    jsmn_keyset_slot_t keyset_slots[8];
+    jsmn_keyset_t keyset;
+    const char *a = "{\"a\": [1, 2, {\"b\": null}], \"c\": \"d\"}";
+    const char *b = "[true, false]";
+    const char *c = "{\"e\": 0}";
+    char copy[64];
+
+    check(jsmn_cache_init(&cache, jsmn_parse_strict, 0, 0) ==
+          JSMN_CACHE_ERROR_INVAL);
+    check(jsmn_cache_init(&cache, jsmn_parse_strict, 2, 0) == 0);
+    jsmn_init(&p1, expected, 16);
+    jsmn_init(&p2, tokens, 16);
+    int n = jsmn_parse_strict(&p1, a, strlen(a));
+    check(n == 10);
+
+    // a hit relocates the tokens into the new copy of the input
+    check(jsmn_cache_parse(&cache, &p2, a, strlen(a)) == n);
+    strcpy(copy, a);
+    memset(tokens, 0, sizeof(tokens));
+    check(jsmn_cache_parse(&cache, &p2, copy, strlen(copy)) == n);
+    check(cache.stats.lookups == 2 && cache.stats.hits == 1);
+    check(p2.token_count == (unsigned int)n);
+    check(tokens[9].start == &copy[expected[9].start - a]);
+    for (int i = 0; i < n; i++) {
+        tokens[i].start = a + (tokens[i].start - copy);
+    }
+    check(same_tokens(expected, tokens, n));
+
+    // a change of one byte is a miss, and errors are not cached
+    copy[7] = '3';
+    check(jsmn_cache_parse(&cache, &p2, copy, strlen(copy)) == n);
+    check(cache.stats.hits == 1 && cache.stats.entries == 2);
+    check(jsmn_cache_parse(&cache, &p2, "[1,", 3) == JSMN_ERROR_PART);
+    check(cache.stats.inserts == 2);
+
+    // least recently used results go first
+    check(jsmn_cache_parse(&cache, &p2, a, strlen(a)) == n);
+    check(jsmn_cache_parse(&cache, &p2, b, strlen(b)) == 3);
+    check(cache.stats.evictions == 1 && cache.stats.entries == 2);
+    check(jsmn_cache_parse(&cache, &p2, a, strlen(a)) == n);
+    check(cache.stats.hits == 3);
+    size_t bytes = cache.stats.bytes;
+    check(bytes > strlen(a) + strlen(b));
+
+    // hits still hand out symbol IDs, and still need room for the tokens
+    jsmn_symtab_init(&symtab, slots, 16);
+    check(jsmn_symtab_add(&symtab, "c") == 1);
+    jsmn_set_symtab(&p2, &symtab);
+    check(jsmn_cache_parse(&cache, &p2, a, strlen(a)) == n);
+    check(tokens[1].symbol == 2 && tokens[6].symbol == 3);
+    check(tokens[8].symbol == 1 && tokens[9].symbol == 0);
+    jsmn_init(&p2, tokens, 4);
+    check(jsmn_cache_parse(&cache, &p2, a, strlen(a)) == JSMN_ERROR_NOMEM);
+
+    // a parser with a key set never takes a hit that skipped its check
+    const char *dup = "{\"f\": 1, \"f\": 2}";
+    jsmn_init(&p2, tokens, 16);
+    check(jsmn_cache_parse(&cache, &p2, dup, strlen(dup)) == 5);
+    jsmn_keyset_init(&keyset, keyset_slots, 8);
+    jsmn_set_keyset(&p2, &keyset);
+    unsigned long lookups = cache.stats.lookups;
+    check(jsmn_cache_parse(&cache, &p2, dup, strlen(dup)) ==
+          JSMN_ERROR_DUPKEY);
+    check(cache.stats.lookups == lookups);
+    jsmn_cache_free(&cache);
+
+    // a byte budget bounds memory; results over it are never kept
+    check(jsmn_cache_init(&cache, jsmn_parse, 8, bytes) == 0);
+    jsmn_init(&p2, tokens, 16);
+    check(jsmn_cache_parse(&cache, &p2, a, strlen(a)) == n);
+    check(jsmn_cache_parse(&cache, &p2, b, strlen(b)) == 3);
+    check(jsmn_cache_parse(&cache, &p2, c, strlen(c)) == 3);
+    check(cache.stats.bytes <= bytes && cache.stats.evictions == 1);
+    jsmn_cache_clear(&cache);
+    check(cache.stats.entries == 0 && cache.stats.bytes == 0);
+    jsmn_cache_free(&cache);
+    check(jsmn_cache_init(&cache, jsmn_parse, 8, 16) == 0);
+    check(jsmn_cache_parse(&cache, &p2, b, strlen(b)) == 3);
+    check(cache.stats.entries == 0);
+    jsmn_cache_free(&cache);
+    return 0;
+}
+
+int test_reparse(void) {
+    static const struct {
+        const char *before; // text replaced, found in the document
+        const char *after;
+    } edits[] = {
+        {"42", "43"},                   // a value in place
+        {"42", "[4, 2, {\"x\": []}]"}, // a value grows a subtree
+        {"[1, 2, 3]", "[]"},            // a subtree shrinks
+        {"2, 3", "2, 3, 4, 5"},         // array elements added
+        {"\"k\": true", "\"k\": true, \"k2\": null"}, // a member added
+        {"\"s\"", "\"t\\\" u\""},        // a string with an escape
+        {"\"z\"", "\"zz\""},          // a key renamed
+        {"true", "true]"},              // breaks the nesting: full reparse
+        {"[1, 2, 3]", "[1, 2, 3"},      // invalid after the edit
+    };
+    static const jsmn_parse_fn parsers[] = {jsmn_parse, jsmn_parse_strict};
+    const char *doc = "{\"a\": {\"b\": 42, \"c\": [1, 2, 3]}, "
+                      "\"d\": [{\"k\": true}, \"s\"], \"z\": {}}";
+    jsmn_token_t expected[48];
+    jsmn_token_t tokens[48];
+    jsmn_parser_t p1;
+    jsmn_parser_t p2;
+    jsmn_symbol_slot_t slots[32];
+    jsmn_symtab_t symtab;
+    char old_js[128];
+    char js[128];
+
+    jsmn_symtab_init(&symtab, slots, 32);
+    for (size_t f = 0; f < sizeof(parsers) / sizeof(parsers[0]); f++) {
+        for (size_t e = 0; e < sizeof(edits) / sizeof(edits[0]); e++) {
+            const char *at = strstr(doc, edits[e].before);
+            jsmn_edit_t edit = {(size_t)(at - doc), strlen(edits[e].before),
+                                strlen(edits[e].after)};
+            strcpy(old_js, doc);
+            snprintf(js, sizeof(js), "%.*s%s%s", (int)edit.start, doc,
+                     edits[e].after, at + edit.old_len);
+
+            jsmn_init(&p2, tokens, 48);
+            jsmn_set_symtab(&p2, &symtab);
+            check(parsers[f](&p2, old_js, strlen(old_js)) > 0);
+            int r = jsmn_reparse(&p2, parsers[f], old_js, js, strlen(js),
+                                 &edit);
+            jsmn_init(&p1, expected, 48);
+            int n = parsers[f](&p1, js, strlen(js));
+            check(r == n);
+            if (n > 0) {
+                check(p2.token_count == p1.token_count);
+                check(same_tokens(expected, tokens, n));
+                for (int i = 0; i < n; i++) {
+                    // keys keep or gain symbols, values never have them
+                    check((tokens[i].symbol != 0) ==
+                          (tokens[i].type == JSMN_STRING &&
+                           tokens[i].child_count == 1));
+                }
+            }
+        }
+    }
+
+    // edited in place, with the subtree needing more tokens than are free
+    strcpy(js, "[[1], [2]]");
+    jsmn_init(&p2, tokens, 5);
+    check(jsmn_parse(&p2, js, strlen(js)) == 5);
+    jsmn_edit_t edit = {2, 1, 1};
+    js[2] = '7';
+    check(jsmn_reparse(&p2, jsmn_parse, js, js, strlen(js), &edit) == 5);
+    check(tokens[2].start == &js[2] && tokens[4].start == &js[7]);
+    memcpy(js, "[[1,2,3], [2]]", 15);
+    edit.old_len = 1;
+    edit.new_len = 5;
+    check(jsmn_reparse(&p2, jsmn_parse, js, js, strlen(js), &edit) ==
+          JSMN_ERROR_NOMEM);
+    return 0;
+}
+
+int test_reader(void) {
+    jsmn_token_t tokens[8];
+    jsmn_parser_t parser;
+    jsmn_reader_t reader;
+    const char *value;
+    size_t len;
+    int fds[2];
+    const char *stream = " {\"a\": [1, \"]}\"]}\n[2, 3]\"s\\\"\" 42\ttrue {}\n"
+                         "[1, 2, 3, 4, 5, 6, 7, 8] ] -7\n";
+
+    // a window smaller than the stream, so it must slide and grow
+    check(pipe(fds) == 0);
+    check(write(fds[1], stream, strlen(stream)) == (ssize_t)strlen(stream));
+    close(fds[1]);
+    jsmn_init(&parser, tokens, 8);
+    check(jsmn_reader_init(&reader, fds[0], jsmn_parse_strict, 4, 64) == 0);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 5);
+    check(len == 16 && strncmp(value, "{\"a\": [1, \"]}\"]}", len) == 0);
+    check(tokens[4].type == JSMN_STRING && tokens[4].strlen == 2);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 3);
+    check(len == 6 && strncmp(value, "[2, 3]", len) == 0);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 1);
+    check(len == 5 && tokens[0].type == JSMN_STRING);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 1);
+    check(len == 2 && jsmn_token_is_integer(&tokens[0]));
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 1);
+    check(len == 4 && jsmn_token_is_true(&tokens[0]));
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 1);
+    check(len == 2 && tokens[0].type == JSMN_OBJECT);
+    // too few tokens: the text is still delivered for a retry
+    check(jsmn_reader_next(&reader, &parser, &value, &len) ==
+          JSMN_ERROR_NOMEM);
+    check(len == 24 && value[len - 1] == ']');
+    check(jsmn_reader_next(&reader, &parser, &value, &len) ==
+          JSMN_ERROR_INVAL);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 1);
+    check(len == 2 && jsmn_token_is_negative(&tokens[0]));
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 0);
+    check(reader.size <= 32);
+    jsmn_reader_free(&reader);
+    close(fds[0]);
+
+    // a value longer than the window may grow to
+    check(pipe(fds) == 0);
+    check(write(fds[1], "[1, 2, 3, 4] [5", 15) == 15);
+    close(fds[1]);
+    check(jsmn_reader_init(&reader, fds[0], jsmn_parse_strict, 4, 8) == 0);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) ==
+          JSMN_READER_ERROR_NOMEM);
+    jsmn_reader_free(&reader);
+    close(fds[0]);
+
+    // a non-blocking descriptor that runs dry part way through a value
+    check(pipe(fds) == 0);
+    check(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+    check(jsmn_reader_init(&reader, fds[0], jsmn_parse_strict, 4, 64) == 0);
+    check(write(fds[1], "[1, ", 4) == 4);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) ==
+          JSMN_READER_ERROR_AGAIN);
+    check(write(fds[1], "2]\n", 3) == 3);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 3);
+    close(fds[1]);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 0);
+    jsmn_reader_free(&reader);
+    close(fds[0]);
+
+    // a stream ending inside a value
+    check(pipe(fds) == 0);
+    check(write(fds[1], "[5, {", 5) == 5);
+    close(fds[1]);
+    check(jsmn_reader_init(&reader, fds[0], jsmn_parse_strict, 64, 64) == 0);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == JSMN_ERROR_PART);
+    check(len == 5);
+    check(jsmn_reader_next(&reader, &parser, &value, &len) == 0);
+    jsmn_reader_free(&reader);
+    close(fds[0]);
+    return 0;
+}
+
+int test_random_access(void) {
+    jsmn_token_t tokens[64];
+    jsmn_parser_t parser;
+    jsmn_child_index_t index;
+    int table[128];
+    const char *js = "{\"a\": [10, [1], {\"x\": 1}, 13, 14], \"b\": {}, "
+                     "\"c\": \"s\", \"d\": [[], 2]}";
+
+    jsmn_init(&parser, tokens, 64);
+    int n = jsmn_parse(&parser, js, strlen(js));
+    check(n == 19);
+    // with and without an index the answers agree
+    for (int pass = 0; pass < 3; pass++) {
+        if (pass == 1) {
+            jsmn_child_index_init(&index, table, 128);
+            jsmn_set_child_index(&parser, &index);
+        } else if (pass == 2) {
+            // too small: falls back to stepping
+            jsmn_child_index_init(&index, table, 2 * n - 1);
+        }
+        check(jsmn_object_member(&parser, 0, 0) == 1);
+        check(jsmn_object_member(&parser, 0, 1) == 11);
+        check(jsmn_object_member(&parser, 0, 3) == 15);
+        check(jsmn_object_member(&parser, 0, 4) == -1);
+        check(jsmn_object_member(&parser, 2, 0) == -1); // an array
+        check(jsmn_object_member(&parser, 12, 0) == -1); // empty
+        check(jsmn_array_get(&parser, 2, 0) == 3);
+        check(jsmn_array_get(&parser, 2, 2) == 6);
+        check(jsmn_array_get(&parser, 2, 4) == 10);
+        check(jsmn_array_get(&parser, 2, 5) == -1);
+        check(jsmn_array_get(&parser, 2, -1) == -1);
+        check(jsmn_array_get(&parser, 4, 0) == 5);
+        check(jsmn_array_get(&parser, 16, 1) == 18);
+        check(jsmn_array_get(&parser, 17, 0) == -1); // empty
+        check(jsmn_array_get(&parser, 0, 0) == -1); // an object
+        check(jsmn_array_get(&parser, 99, 0) == -1);
+    }
+    check(!index.built);
+
+    // a new parse rebuilds the index
+    jsmn_child_index_init(&index, table, 128);
+    check(jsmn_array_get(&parser, 2, 1) == 4 && index.built);
+    const char *big = "[0, 1, 2, 3, 4, 5, 6, 7, 8, 9]";
+    check(jsmn_parse(&parser, big, strlen(big)) == 11);
+    check(!index.built);
+    for (int i = 0; i < 10; i++) {
+        check(jsmn_array_get(&parser, 0, i) == i + 1);
+    }
+    return 0;
+}
+
+/* Compile and run expr, returning the match count or a compile error */
+static int query(jsmn_parser_t *parser, const char *expr, int *matches,
+                 int max_matches) {
+    jsmn_path_op_t code[16];
+    jsmn_path_t path;
+    int r = jsmn_path_compile(&path, expr, code, 16);
+    if (r < 0) {
+        return r;
+    }
+    return jsmn_path_eval(&path, parser, 0, matches, max_matches);
+}
+
+/* Return true if the token at index has the text s */
+static bool token_text_is(jsmn_parser_t *parser, int index, const char *s) {
+    jsmn_token_t *tok = jsmn_token_ref(parser, index);
+    return tok != NULL && tok->strlen == (int)strlen(s) &&
+           strncmp(tok->start, s, strlen(s)) == 0;
+}
+
+int test_path(void) {
+    jsmn_token_t tokens[64];
+    jsmn_parser_t parser;
+    jsmn_path_op_t code[4];
+    jsmn_path_t path;
+    int m[16];
+    const char *js =
+        "{\"items\": [{\"price\": 5, \"id\": 1}, {\"price\": 7.5, \"id\": 2}, "
+        "{\"id\": 3}], \"events\": [{\"level\": \"error\", \"id\": 4}, "
+        "{\"level\": \"info\"}], \"n\": [0, 1, 2, 3, 4, 5]}";
+
+    jsmn_init(&parser, tokens, 64);
+    check(jsmn_parse(&parser, js, strlen(js)) > 0);
+
+    check(query(&parser, "$.items[*].price", m, 16) == 2);
+    check(token_text_is(&parser, m[0], "5") &&
+          token_text_is(&parser, m[1], "7.5"));
+    check(query(&parser, "$..id", m, 16) == 4);
+    for (int i = 0; i < 4; i++) {
+        check(tokens[m[i]].type == JSMN_PRIMITIVE);
+        check(tokens[m[i]].start[0] == '1' + i);
+    }
+    check(query(&parser, "$.events[?(@.level==\"error\")]", m, 16) == 1);
+    check(tokens[m[0]].type == JSMN_OBJECT && tokens[m[0] + 4].start[0] == '4');
+    check(query(&parser, "$.events[?(@.level != 'error')].level", m, 16) == 1);
+    check(token_text_is(&parser, m[0], "info"));
+    check(query(&parser, "$.items[?(@.price > 6)].id", m, 16) == 1);
+    check(token_text_is(&parser, m[0], "2"));
+    check(query(&parser, "$.items[?(@.price <= 7.5)]", m, 16) == 2);
+    check(query(&parser, "$.items[?(@.price)]", m, 16) == 2);
+    check(query(&parser, "$..[?(@.id == 3)]", m, 16) == 1);
+    check(query(&parser, "$['items'][0][\"id\"]", m, 16) == 1);
+    check(token_text_is(&parser, m[0], "1"));
+    check(query(&parser, "$.*", m, 16) == 3);
+    check(query(&parser, "$.missing..id", m, 16) == 0);
+
+    // indices and slices, with and without the child index
+    jsmn_child_index_t index;
+    int table[128];
+    for (int pass = 0; pass < 2; pass++) {
+        check(query(&parser, "$.n[-1]", m, 16) == 1);
+        check(token_text_is(&parser, m[0], "5"));
+        check(query(&parser, "$.n[1:5:2]", m, 16) == 2);
+        check(token_text_is(&parser, m[0], "1") &&
+              token_text_is(&parser, m[1], "3"));
+        check(query(&parser, "$.n[-2:]", m, 16) == 2);
+        check(token_text_is(&parser, m[0], "4"));
+        check(query(&parser, "$.n[:2]", m, 16) == 2);
+        check(query(&parser, "$.n[4:100:3]", m, 16) == 1);
+        check(query(&parser, "$.n[9]", m, 16) == 0);
+        jsmn_child_index_init(&index, table, 128);
+        jsmn_set_child_index(&parser, &index);
+    }
+
+    // only max_matches are stored, but all are counted
+    m[1] = -1;
+    check(query(&parser, "$.n[*]", m, 1) == 6);
+    check(token_text_is(&parser, m[0], "0") && m[1] == -1);
+
+    check(query(&parser, "items", m, 16) == JSMN_PATH_ERROR_INVAL);
+    check(query(&parser, "$.", m, 16) == JSMN_PATH_ERROR_INVAL);
+    check(query(&parser, "$..", m, 16) == JSMN_PATH_ERROR_INVAL);
+    check(query(&parser, "$[1:2:0]", m, 16) == JSMN_PATH_ERROR_INVAL);
+    check(query(&parser, "$['a]", m, 16) == JSMN_PATH_ERROR_INVAL);
+    check(query(&parser, "$[?(@.a == )]", m, 16) == JSMN_PATH_ERROR_INVAL);
+    check(jsmn_path_compile(&path, "$.a.b.c.d.e", code, 4) ==
+          JSMN_PATH_ERROR_NOMEM);
+    return 0;
+}
+
+/* Project js and compare the output with expected */
+static bool projects_to(const char *js, const char *const *paths, int n,
+                        jsmn_project_mode_t mode, const char *expected) {
+    char buf[256];
+    jsmn_writer_t writer;
+    jsmn_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+    if (jsmn_project(js, strlen(js), paths, n, mode, &writer) != 0) {
+        return false;
+    }
+    return writer.len == strlen(expected) &&
+           strncmp(buf, expected, writer.len) == 0;
+}
+
+int test_project(void) {
+    static const char *const keep[] = {"id", "user.name", "items.price",
+                                       "tags"};
+    static const char *const drop[] = {"user.token", "items.id", "x"};
+    const char *js = "{ \"id\": 7, \"user\": {\"name\": \"a \\\" b\", "
+                     "\"token\": \"s3cr]t\"},\n \"items\": [{\"price\": 1.5, "
+                     "\"id\": [1, {}]}, 3, {\"id\": 2}], \"tags\": [ \"x\", \"y\" ], "
+                     "\"x\": null }";
+
+    check(projects_to(js, keep, 4, JSMN_PROJECT_KEEP,
+                      "{\"id\":7,\"user\":{\"name\":\"a \\\" b\"},"
+                      "\"items\":[{\"price\":1.5},{}],\"tags\":[ \"x\", \"y\" ]}"));
+    check(projects_to(js, drop, 3, JSMN_PROJECT_DROP,
+                      "{\"id\":7,\"user\":{\"name\":\"a \\\" b\"},"
+                      "\"items\":[{\"price\":1.5},3,{}],"
+                      "\"tags\":[ \"x\", \"y\" ]}"));
+    // off-path subtrees are copied verbatim, whitespace and all
+    check(projects_to(js, drop, 0, JSMN_PROJECT_DROP, js + 0));
+    check(projects_to(js, keep, 0, JSMN_PROJECT_KEEP, "{}"));
+    check(projects_to(" [ {\"a\": 1, \"b\": 2} ] ", keep, 1,
+                      JSMN_PROJECT_DROP, "[{\"a\":1,\"b\":2}]"));
+    check(projects_to("42", keep, 1, JSMN_PROJECT_KEEP, "42"));
+
+    // malformed input along the way is refused
+    const char *bad[] = {"{\"id\" 7}", "{\"id\": 7", "{\"user\": {\"name\": \"x}}",
+                         "{\"id\": 1 \"x\": 2}", "{\"items\": [1,]}"};
+    char buf[64];
+    jsmn_writer_t writer;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        jsmn_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+        check(jsmn_project(bad[i], strlen(bad[i]), keep, 4, JSMN_PROJECT_KEEP,
+                           &writer) == JSMN_WRITER_ERROR_INVAL);
+    }
+
+    // arrays along a path, nested as deep as the limit, and deeper
+    static const char *const deep_path[] = {"a.x"};
+    static char deep[2 * JSMN_FORMAT_MAX_DEPTH + 16];
+    static char out[2 * JSMN_FORMAT_MAX_DEPTH + 16];
+    for (int n = JSMN_FORMAT_MAX_DEPTH - 1; n <= JSMN_FORMAT_MAX_DEPTH; n++) {
+        int len = sprintf(deep, "{\"a\":");
+        memset(&deep[len], '[', (size_t)n);
+        memset(&deep[len + n], ']', (size_t)n);
+        strcpy(&deep[len + 2 * n], "}");
+        jsmn_writer_init(&writer, out, sizeof(out), NULL, NULL);
+        int r = jsmn_project(deep, strlen(deep), deep_path, 1,
+                             JSMN_PROJECT_DROP, &writer);
+        if (n < JSMN_FORMAT_MAX_DEPTH) {
+            check(r == 0 && writer.len == strlen(deep) &&
+                  memcmp(out, deep, writer.len) == 0);
+        } else {
+            check(r == JSMN_WRITER_ERROR_INVAL);
+        }
+    }
+    return 0;
+}
+
+/* Parse and compile the schema text s into code */
+static int compile_schema(const char *s, jsmn_schema_t *schema,
+                          jsmn_schema_op_t *code, int code_size) {
+    jsmn_token_t tokens[64];
+    jsmn_parser_t parser;
+    jsmn_init(&parser, tokens, 64);
+    if (jsmn_parse(&parser, s, strlen(s)) < 0) {
+        return JSMN_SCHEMA_ERROR_INVAL;
+    }
+    return jsmn_schema_compile(schema, &parser, 0, code, code_size);
+}
+
+int test_schema(void) {
+    jsmn_token_t tokens[32];
+    jsmn_parser_t parser;
+    jsmn_schema_op_t code[32];
+    jsmn_schema_t schema;
+    jsmn_schema_error_t e[8];
+    const char *s =
+        "{\"$schema\": \"https://json-schema.org/draft/2020-12/schema\", "
+        "\"type\": \"object\", \"required\": [\"id\", \"name\"], "
+        "\"properties\": {"
+        "\"id\": {\"type\": \"integer\", \"minimum\": 1}, "
+        "\"name\": {\"type\": \"string\", \"minLength\": 1, \"maxLength\": 5}, "
+        "\"tags\": {\"type\": \"array\", \"items\": {\"enum\": [\"a\", \"b\", "
+        "3, null]}}, "
+        "\"score\": {\"type\": [\"number\", \"null\"], \"maximum\": 10}}}";
+    const char *js;
+
+    check(compile_schema(s, &schema, code, 32) == 17);
+
+    js = "{\"id\": 2.0, \"name\": \"h\\u00e9llo\", \"tags\": [\"a\", 3, null], "
+         "\"score\": null, \"extra\": {}}";
+    jsmn_init(&parser, tokens, 32);
+    check(jsmn_parse(&parser, js, strlen(js)) > 0);
+    check(jsmn_schema_validate(&schema, &parser, 0, e, 8) == 0);
+
+    // each failure is reported at the offending token, in document order
+    js = "{\"id\": 0, \"tags\": [\"c\", 3.0], \"score\": 11, "
+         "\"name\": \"toolong\"}";
+    jsmn_init(&parser, tokens, 32);
+    check(jsmn_parse(&parser, js, strlen(js)) > 0);
+    check(jsmn_schema_validate(&schema, &parser, 0, e, 8) == 4);
+    check(e[0].token == 2 && e[0].keyword == JSMN_SCHEMA_FAIL_MINIMUM);
+    check(e[1].token == 5 && e[1].keyword == JSMN_SCHEMA_FAIL_ENUM);
+    check(e[2].token == 8 && e[2].keyword == JSMN_SCHEMA_FAIL_MAXIMUM);
+    check(e[3].token == 10 && e[3].keyword == JSMN_SCHEMA_FAIL_MAX_LENGTH);
+    check(jsmn_schema_validate(&schema, &parser, 0, e, 2) == 4);
+
+    js = "{\"id\": \"x\", \"name\": \"\"}";
+    jsmn_init(&parser, tokens, 32);
+    check(jsmn_parse(&parser, js, strlen(js)) > 0);
+    check(jsmn_schema_validate(&schema, &parser, 0, e, 8) == 2);
+    check(e[0].token == 2 && e[0].keyword == JSMN_SCHEMA_FAIL_TYPE);
+    check(e[1].token == 4 && e[1].keyword == JSMN_SCHEMA_FAIL_MIN_LENGTH);
+
+    js = "[{\"name\": \"ok\"}]";
+    jsmn_init(&parser, tokens, 32);
+    check(jsmn_parse(&parser, js, strlen(js)) > 0);
+    check(jsmn_schema_validate(&schema, &parser, 0, e, 8) == 1);
+    check(e[0].token == 0 && e[0].keyword == JSMN_SCHEMA_FAIL_TYPE);
+    check(jsmn_schema_validate(&schema, &parser, 1, e, 8) == 1);
+    check(e[0].token == 1 && e[0].keyword == JSMN_SCHEMA_FAIL_REQUIRED);
+    check(code[e[0].op].op == JSMN_SCHEMA_OP_REQUIRED &&
+          code[e[0].op].len == 2 && strncmp(code[e[0].op].name, "id", 2) == 0);
+
+    check(compile_schema("{\"type\": \"thing\"}", &schema, code, 32) ==
+          JSMN_SCHEMA_ERROR_INVAL);
+    check(compile_schema("{\"enum\": [{}]}", &schema, code, 32) ==
+          JSMN_SCHEMA_ERROR_INVAL);
+    check(compile_schema("{\"items\": [{}]}", &schema, code, 32) ==
+          JSMN_SCHEMA_ERROR_INVAL);
+    check(compile_schema("{\"maxLength\": -1}", &schema, code, 32) ==
+          JSMN_SCHEMA_ERROR_INVAL);
+    check(compile_schema("true", &schema, code, 32) ==
+          JSMN_SCHEMA_ERROR_INVAL);
+    check(compile_schema(s, &schema, code, 16) == JSMN_SCHEMA_ERROR_NOMEM);
+    return 0;
+}
+
+int test_simd(void) {
+    static const char *utf8[] = {
+        "plain ascii",
+        "caf\xc3\xa9",
+        "\xe2\x82\xac and \xf0\x9f\x98\x80",
+        "\xc0\xaf",         // overlong '/'
+        "\xe0\x80\xaf",     // overlong '/'
+        "\xed\xa0\x80",     // surrogate
+        "\xf4\x90\x80\x80", // above U+10FFFF
+        "\xf5\x80\x80\x80",
+        "cut \xe2\x82",
+        "\x80 lone",
+        "ok \xef\xbf\xbf ok",
+    };
+    static const size_t utf8_valid[] = {11, 5, 12, 0, 0, 0, 0, 0, 4, 0, 9};
+    static const char alphabet[] = "\0ab \t\r\n\"\\\x01\x1f\x7f\xc3\xa9\xe2\x82\xac";
+    jsmn_isa_t best = jsmn_simd_isa();
+    char buf[200];
+    unsigned int seed = 1;
+
+    check(jsmn_simd_select(JSMN_ISA_SCALAR) == 0);
+    check(jsmn_simd_isa() == JSMN_ISA_SCALAR);
+    for (size_t i = 0; i < sizeof(utf8) / sizeof(utf8[0]); i++) {
+        check(jsmn_scan_utf8(utf8[i], strlen(utf8[i])) == utf8_valid[i]);
+    }
+    check(jsmn_scan_string("ab\\\"", 4) == 2);
+    check(jsmn_scan_unescaped("ab\ncd", 5) == 2);
+    check(jsmn_scan_plain("true, 1", 7) == 5);
+    check(jsmn_skip_space(" \t\r\n x", 6) == 5);
+    check(jsmn_skip_space("    ", 4) == 4);
+    check(jsmn_scan_string_nul("ab\0c\"", 5) == 2);
+
+    // every wider level agrees with the scalar kernels, whatever the
+    // length and alignment
+    for (int isa = JSMN_ISA_SSE2; isa <= (int)best; isa++) {
+        for (int round = 0; round < 2000; round++) {
+            size_t off = (size_t)(round % 7);
+            size_t n = (size_t)(round % 150);
+            for (size_t i = 0; i < off + n; i++) {
+                seed = seed * 1103515245 + 12345;
+                // mostly plain bytes, so matches land anywhere
+                buf[i] = (seed >> 16) % 8 == 0
+                             ? alphabet[(seed >> 20) % (sizeof(alphabet) - 1)]
+                             : 'x';
+            }
+            const char *s = &buf[off];
+            size_t r[6];
+            check(jsmn_simd_select(JSMN_ISA_SCALAR) == 0);
+            r[0] = jsmn_scan_string(s, n);
+            r[1] = jsmn_scan_unescaped(s, n);
+            r[2] = jsmn_scan_plain(s, n);
+            r[3] = jsmn_skip_space(s, n);
+            r[4] = jsmn_scan_utf8(s, n);
+            r[5] = jsmn_scan_string_nul(s, n);
+            check(jsmn_simd_select((jsmn_isa_t)isa) == 0);
+            check(jsmn_scan_string(s, n) == r[0]);
+            check(jsmn_scan_unescaped(s, n) == r[1]);
+            check(jsmn_scan_plain(s, n) == r[2]);
+            check(jsmn_skip_space(s, n) == r[3]);
+            check(jsmn_scan_utf8(s, n) == r[4]);
+            check(jsmn_scan_string_nul(s, n) == r[5]);
+        }
+        for (size_t i = 0; i < sizeof(utf8) / sizeof(utf8[0]); i++) {
+            // long enough for the wide loop, ending in the sample
+            memset(buf, ' ', 100);
+            memcpy(&buf[100], utf8[i], strlen(utf8[i]));
+            size_t n = 100 + strlen(utf8[i]);
+            check(jsmn_scan_utf8(buf, n) == 100 + utf8_valid[i]);
+            check(jsmn_skip_space(buf, n) == (utf8[i][0] == ' ' ? 101 : 100));
+        }
+    }
+    check(jsmn_simd_select((jsmn_isa_t)-1) == -1);
+    check(jsmn_simd_select(best) == 0);
+    return 0;
+}
+
 int main(void) {
   test(test_empty, "test for a empty JSON objects/arrays");
   test(test_object, "test for a JSON objects");
@@ -732,6 +2583,33 @@ int main(void) {
   test(test_token_types, "test token type predicates");
   test(test_hierarchy, "test hierarchy functions");
   test(test_find_fns, "test find functions");
+  test(test_stats, "test hot-path statistics");
+  test(test_limits, "test resource limits");
+  test(test_writer, "test JSON writer");
+  test(test_writer_tokens, "test JSON writer token copies");
+  test(test_minify, "test minifier");
+  test(test_pretty_print, "test pretty printer");
+  test(test_merge_patch, "test JSON merge patch");
+  test(test_json_patch, "test JSON patch");
+  test(test_bind, "test struct binding");
+  test(test_parse_variants, "test parser variants");
+  test(test_parse_trusted, "test trusted parser");
+  test(test_parse_padded, "test padded parser");
+  test(test_parse_table, "test table-driven parser");
+  test(test_primitive_class, "test primitive classes");
+  test(test_symtab, "test key interning");
+  test(test_keyset, "test duplicate key rejection");
+  test(test_hash, "test subtree hashing");
+  test(test_canonicalize, "test JSON canonicalization");
+  test(test_tape, "test token tapes");
+  test(test_cache, "test parse cache");
+  test(test_reparse, "test incremental reparse");
+  test(test_reader, "test streaming reader");
+  test(test_random_access, "test random access to children");
+  test(test_path, "test JSONPath queries");
+  test(test_project, "test streaming projection");
+  test(test_schema, "test JSON Schema validation");
+  test(test_simd, "test CPU dispatched scanning kernels");
   printf("\nPASSED: %d\nFAILED: %d\n", test_passed, test_failed);
   return (test_failed > 0);
 }
@@ -0,0 +1,176 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include "../jsmn.hpp"
+#include "test.h"
+
+using namespace jsmn::literals;
+
+static constexpr jsmn::key k_id = "id";
+static_assert(k_id.hash() == jsmn::key::hash_of("id", 2),
+              "key hashes must be computable at compile time");
+
+int test_cpp_access(void) {
+    jsmn::document<32> doc;
+    const char *js = "{\"id\": 42, \"name\": \"jsmn\", \"ratio\": -2.5e1, "
+                     "\"ok\": true, \"none\": null}";
+    check(doc.parse(js) == 11);
+
+    jsmn::value root = doc.root();
+    check(root.is_object());
+    check(root.size() == 5);
+    check(root[k_id].get<std::int64_t>() == 42);
+    check(root["id"].get<int>() == 42);
+    check(root["name"_key].get<std::string_view>() == "jsmn");
+    check(root["ratio"].get<double>() == -25.0);
+    check(root["ok"].get<bool>() == true);
+    check(root["none"].is_null());
+    check(root["ratio"].is_float() && root["ratio"].is_negative());
+    check(root["id"].is_integer() && !root["id"].is_negative());
+
+    // conversions that don't fit fail and leave the fallback in place
+    check(root["ratio"].get<std::int64_t>(7) == 7);
+    check(root["name"].get<double>(1.5) == 1.5);
+    check(root["id"].get<std::string_view>().empty());
+    unsigned char small = 3;
+    check(root["id"].try_get(small) && small == 42);
+    std::int8_t tiny = 0;
+    check(!jsmn::value(doc.parser(), 0)["ratio"].try_get(tiny));
+
+    // -0 keeps its sign
+    jsmn::document<4> zero;
+    check(zero.parse("[-0, 0]") == 3);
+    double d = zero.root()[std::size_t(0)].get<double>(1.0);
+    check(d == 0 && std::signbit(d));
+    float f = zero.root()[std::size_t(0)].get<float>(1.0f);
+    check(f == 0 && std::signbit(f));
+    d = zero.root()[std::size_t(1)].get<double>(1.0);
+    check(d == 0 && !std::signbit(d));
+
+    // missing keys, near misses and lookups on the wrong type
+    check(!root["missing"].valid());
+    check(!root["i"].valid());
+    check(!root["idd"].valid());
+    check(!root["id"]["x"].valid());
+    check(!root[std::size_t(0)].valid());
+    check(root["id"].text() == "42");
+    return 0;
+}
+
+int test_cpp_iteration(void) {
+    jsmn::document<64> doc;
+    const char *js = "[1, [2, [3, {\"a\": [4, 5]}]], {\"b\": {\"c\": 6}}, 7]";
+    check(doc.parse(js) == 17);
+
+    jsmn::value root = doc.root();
+    int n = 0;
+    std::int64_t sum = 0;
+    for (jsmn::value v : root.elements()) {
+        std::int64_t i;
+        if (v.try_get(i)) {
+            sum += i;
+        }
+        n++;
+    }
+    // nested arrays and objects are skipped as single elements
+    check(n == 4);
+    check(sum == 8);
+    check(root[3].get<int>() == 7);
+    check(root[1][1][1]["a"][1].get<int>() == 5);
+    check(!root[4].valid());
+
+    jsmn::value obj = root[2];
+    check(obj.is_object());
+    int members = 0;
+    for (auto [name, val] : obj.members()) {
+        check(name.text() == "b");
+        check(val.is_object());
+        check(val["c"].get<int>() == 6);
+        members++;
+    }
+    check(members == 1);
+
+    // ranges over the wrong type are empty
+    check(root.members().empty());
+    check(obj.elements().empty());
+    check(root[0].elements().empty());
+
+    const char *empty = "{\"x\": [], \"y\": {}}";
+    check(doc.parse(empty) == 5);
+    check(doc.root()["x"].elements().empty());
+    check(doc.root()["y"].members().empty());
+    check(doc.root()["y"].is_object());
+    return 0;
+}
+
+int test_cpp_parser_view(void) {
+    jsmn_token_t tokens[16];
+    jsmn_parser_t parser;
+    jsmn_init(&parser, tokens, 16);
+    const char *js = "{\"k\": [true, false]}";
+    check(jsmn_parse(&parser, js, strlen(js)) == 5);
+
+    jsmn::value list = jsmn::value(parser)["k"];
+    check(list.size() == 2);
+    check(list[0].get<bool>(false) == true);
+    check(list[1].get<bool>(true) == false);
+
+    jsmn::document<2> doc;
+    check(doc.parse(js) == JSMN_ERROR_NOMEM);
+    jsmn::document<4> unparsed;
+    check(!unparsed.root().valid());
+    return 0;
+}
+
+struct bound {
+    int id = 0;
+    std::uint16_t port = 0;
+    double ratio = 0;
+    bool on = false;
+    std::string_view name;
+    jsmn::value tags;
+};
+
+static constexpr auto bound_binding = jsmn::make_binding(
+    jsmn::field("id", &bound::id), jsmn::field("port", &bound::port),
+    jsmn::field("ratio", &bound::ratio), jsmn::field("enabled", &bound::on),
+    jsmn::field("name", &bound::name), jsmn::field("tags", &bound::tags));
+static_assert(bound_binding.ok(), "binding hash is found at compile time");
+
+int test_cpp_binding(void) {
+    jsmn::document<64> doc;
+    const char *js = "{\"id\": 7, \"ignored\": {\"id\": 8}, \"port\": 8080, "
+                     "\"ratio\": 0.5, \"enabled\": true, \"name\": \"srv\", "
+                     "\"tags\": [\"a\", \"b\"], \"i\": 1, \"ids\": 2}";
+    check(doc.parse(js) > 0);
+
+    bound b;
+    check(bound_binding.decode(doc.root(), b) == 6);
+    check(b.id == 7);
+    check(b.port == 8080);
+    check(b.ratio == 0.5);
+    check(b.on);
+    check(b.name == "srv");
+    check(b.tags.is_array() && b.tags[1].get<std::string_view>() == "b");
+
+    check(doc.parse("{\"port\": 70000}") > 0);
+    check(bound_binding.decode(doc.root(), b) == JSMN_BIND_ERROR_TYPE);
+    check(doc.parse("{\"id\": null}") > 0);
+    check(bound_binding.decode(doc.root(), b) == 0);
+    check(b.id == 7);
+    check(doc.parse("[]") > 0);
+    check(bound_binding.decode(doc.root(), b) == JSMN_BIND_ERROR_INVAL);
+    return 0;
+}
+
+int main(void) {
+    test(test_cpp_access, "test C++ value access");
+    test(test_cpp_iteration, "test C++ iteration");
+    test(test_cpp_parser_view, "test C++ view over a C parser");
+  test(test_cpp_binding, "test C++ struct binding");
+    printf("\nPASSED: %d\nFAILED: %d\n", test_passed, test_failed);
+    return (test_failed > 0);
+}